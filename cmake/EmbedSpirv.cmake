@@ -0,0 +1,20 @@
+# ##############################################################################
+# A Logan Thomas Barnes project
+# ##############################################################################
+
+# Converts a SPIR-V binary into a comma separated list of 32-bit words that is
+# included in a C++ array initializer, so shaders are compiled into the library.
+#
+# Usage: cmake -DSPIRV_FILE=<input.spv> -DINCLUDE_FILE=<output.inc> -P EmbedSpirv.cmake
+
+file(READ ${SPIRV_FILE} SPIRV_HEX HEX)
+
+# The SPIR-V is written little-endian, like every platform this project supports.
+string(
+  REGEX REPLACE
+  "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])"
+  "0x\\4\\3\\2\\1,\n"
+  SPIRV_WORDS
+  "${SPIRV_HEX}"
+)
+file(WRITE ${INCLUDE_FILE} "${SPIRV_WORDS}")
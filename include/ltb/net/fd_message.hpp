@@ -0,0 +1,60 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/utils/types.hpp"
+
+// standard
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// platform
+#include <sys/un.h>
+
+namespace ltb::net
+{
+
+/// \brief The most file descriptors that can be sent in a single message.
+auto constexpr max_fds_per_message = 32U;
+
+/// \brief The largest payload that can be sent in a single message.
+auto constexpr max_message_payload_size = 16'384U;
+
+enum class ReceiveStatus
+{
+    Received,
+    WouldBlock,
+    Closed,
+    Failed,
+};
+
+/// \brief Fill in the address of a Unix domain socket.
+auto initialize_socket_name( std::string_view socket_path, sockaddr_un& socket_name ) -> bool;
+
+/// \brief Send a payload and a batch of file descriptors over a connected socket
+///        as a single message. The file descriptors are still owned by the caller.
+auto send_message(
+    int32                        socket_fd,
+    std::span< std::byte const > payload,
+    std::span< int32 const >     fds
+) -> bool;
+
+/// \brief Receive a single message. Any received file descriptors are owned by the
+///        caller when the status is `Received`, and are closed otherwise.
+///
+/// \param payload_size the number of payload bytes written to `payload`.
+auto receive_message(
+    int32                 socket_fd,
+    std::span< std::byte > payload,
+    size_t&               payload_size,
+    std::vector< int32 >& fds_out
+) -> ReceiveStatus;
+
+/// \brief Close every file descriptor in the list and clear it.
+auto close_all( std::vector< int32 >& fds ) -> void;
+
+} // namespace ltb::net
@@ -0,0 +1,88 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/net/fd_message.hpp"
+
+// standard
+#include <string>
+#include <unordered_map>
+
+namespace ltb::net
+{
+
+enum class FdServerEventType
+{
+    Connected,
+    Message,
+    Disconnected,
+};
+
+/// \brief Something that happened on one of the server's connections.
+///        Only `Message` events have a payload or file descriptors,
+///        and the file descriptors are owned by whoever handles the event.
+struct FdServerEvent
+{
+    FdServerEventType        type          = FdServerEventType::Connected;
+    uint64                   connection_id = 0U;
+    std::vector< std::byte > payload       = { };
+    std::vector< int32 >     fds           = { };
+};
+
+/// \brief A non-blocking server that accepts any number of FdSocket
+///        connections and multiplexes them with epoll, so it can be
+///        polled from a render loop without a thread per connection.
+class FdServer
+{
+public:
+    FdServer( )                                    = default;
+    FdServer( FdServer const& )                    = delete;
+    FdServer( FdServer&& )                         = delete;
+    auto operator=( FdServer const& ) -> FdServer& = delete;
+    auto operator=( FdServer&& ) -> FdServer&      = delete;
+    ~FdServer( );
+
+    /// \brief Bind to a socket path and start listening for connections.
+    ///        Any stale socket file at the path is removed first.
+    auto initialize( std::string_view socket_path ) -> bool;
+
+    /// \brief Accept new connections and read every message that has
+    ///        arrived since the last poll. Never blocks.
+    ///
+    /// \param events replaced with everything that happened, in order.
+    auto poll( std::vector< FdServerEvent >& events ) -> bool;
+
+    /// \brief Send a message to a single connection.
+    auto send(
+        uint64                       connection_id,
+        std::span< std::byte const > payload,
+        std::span< int32 const >     fds
+    ) -> bool;
+
+    /// \brief Close a connection. No `Disconnected` event is reported for it.
+    auto disconnect( uint64 connection_id ) -> void;
+
+    [[nodiscard]] auto connection_count( ) const -> size_t;
+
+private:
+    struct Connection
+    {
+        int32  socket_fd         = -1;
+        uint64 messages_received = 0U;
+    };
+
+    std::string                              socket_path_        = { };
+    int32                                    listen_socket_fd_   = -1;
+    int32                                    epoll_fd_           = -1;
+    uint64                                   next_connection_id_ = 1U;
+    std::unordered_map< uint64, Connection > connections_        = { };
+    std::vector< std::byte >                 receive_buffer_     = { };
+
+    auto accept_connections( std::vector< FdServerEvent >& events ) -> bool;
+    auto read_messages( uint64 connection_id, std::vector< FdServerEvent >& events ) -> bool;
+    auto close_connection( uint64 connection_id ) -> void;
+};
+
+} // namespace ltb::net
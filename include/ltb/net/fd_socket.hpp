@@ -4,14 +4,16 @@
 #pragma once
 
 // project
-#include "ltb/utils/types.hpp"
+#include "ltb/net/fd_message.hpp"
 
 // standard
 #include <memory>
+#include <string_view>
 
 namespace ltb::net
 {
 
+/// \brief The client side of a connection to an FdServer.
 class FdSocket
 {
 public:
@@ -21,10 +23,27 @@ public:
 
     auto connect_and_send( std::string_view socket_path, int32 fd ) -> bool;
 
-    auto bind_and_receive( std::string_view socket_path, int32& fd_out ) -> bool;
+    /// \brief Connect to a socket that an FdServer is listening on.
+    auto connect( std::string_view socket_path ) -> bool;
+
+    /// \brief Send a file descriptor over a connected socket.
+    auto send( int32 fd ) -> bool;
+
+    /// \brief Send a payload and a batch of file descriptors over a
+    ///        connected socket as a single message. The file descriptors
+    ///        are still owned by the caller once this returns.
+    auto send( std::span< std::byte const > payload, std::span< int32 const > fds ) -> bool;
+
+    /// \brief Block until a file descriptor is received over a connected socket.
+    auto receive( int32& fd_out ) -> bool;
+
+    /// \brief Block until a message is received over a connected socket. The message
+    ///        payload must exactly fill `payload`. The received file descriptors
+    ///        are owned by the caller and are closed on failure.
+    auto receive( std::span< std::byte > payload, std::vector< int32 >& fds_out ) -> bool;
 
 private:
-    int32 unix_socket_fd_;
+    int32 unix_socket_fd_ = -1;
 };
 
 } // namespace ltb::net
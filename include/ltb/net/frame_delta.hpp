@@ -0,0 +1,37 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/utils/types.hpp"
+
+// standard
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace ltb::net
+{
+
+/// \brief Frames are compared in 8-byte words, so their sizes must be a multiple of this.
+auto constexpr frame_delta_word_size = sizeof( uint64 );
+
+/// \brief Encode the words of a frame that changed since the previous frame, then
+///        update the previous frame to match. Both sides start from an all-zero frame.
+///
+/// The encoding is a list of runs, each made of the number of unchanged words to skip,
+/// the number of changed words that follow, and then those words. Frames that barely
+/// change between renders shrink to a small fraction of their size, and encoding only
+/// compares and copies memory, so it keeps up with a full-HD stream on one core.
+auto encode_frame_delta(
+    std::span< std::byte const > frame,
+    std::span< std::byte >       previous_frame,
+    std::vector< std::byte >&    encoded
+) -> bool;
+
+/// \brief Apply an encoded frame delta to the previous frame, turning it into the new frame.
+auto decode_frame_delta( std::span< std::byte const > encoded, std::span< std::byte > frame )
+    -> bool;
+
+} // namespace ltb::net
@@ -0,0 +1,52 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/utils/types.hpp"
+
+// standard
+#include <cstddef>
+#include <string_view>
+
+namespace ltb::net
+{
+
+/// \brief A memfd-backed memory mapping that can be shared with other processes by sending
+///        its file descriptor over an FdSocket.
+class SharedMemory
+{
+public:
+    SharedMemory( )                                        = default;
+    SharedMemory( SharedMemory const& )                    = delete;
+    SharedMemory( SharedMemory&& )                         = delete;
+    auto operator=( SharedMemory const& ) -> SharedMemory& = delete;
+    auto operator=( SharedMemory&& ) -> SharedMemory&      = delete;
+    ~SharedMemory( );
+
+    /// \brief Create and map a new zero-initialized shared memory file.
+    auto create( std::string_view name, size_t size ) -> bool;
+
+    /// \brief Create and map a new zero-initialized shared memory file backed by huge pages
+    ///        where possible. Falls back to regular pages and asks for transparent huge pages
+    ///        if no huge pages are reserved. The size is rounded up to a whole huge page.
+    auto create_hugepage_backed( std::string_view name, size_t size ) -> bool;
+
+    /// \brief Map a shared memory file created by another process. Takes ownership of the fd.
+    auto map( int32 fd ) -> bool;
+
+    /// \brief Unmap the memory and close the file descriptor.
+    auto reset( ) -> void;
+
+    [[nodiscard]] auto fd( ) const -> int32;
+    [[nodiscard]] auto data( ) const -> void*;
+    [[nodiscard]] auto size( ) const -> size_t;
+
+private:
+    int32  fd_   = -1;
+    void*  data_ = nullptr;
+    size_t size_ = 0U;
+};
+
+} // namespace ltb::net
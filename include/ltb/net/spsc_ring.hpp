@@ -0,0 +1,89 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/utils/types.hpp"
+
+// standard
+#include <array>
+#include <atomic>
+#include <bit>
+#include <type_traits>
+
+namespace ltb::net
+{
+
+/// \brief The size of a cache line, used to keep the producer and
+///        consumer indices from sharing one.
+auto constexpr cache_line_size = 64U;
+
+/// \brief A single-producer single-consumer queue of fixed-size records that can
+///        live in SharedMemory. Pushing and popping only touch atomics, so records
+///        cross processes without any system calls.
+///
+/// `head` is only written by the producer and `tail` only by the consumer. Both
+/// count every record ever pushed or popped, so the ring is full once they are
+/// `capacity` apart.
+template < typename Record, uint32 capacity >
+struct SpscRing
+{
+    static_assert( std::has_single_bit( capacity ), "The capacity must be a power of two" );
+    static_assert( std::is_trivially_copyable_v< Record > );
+    static_assert( std::atomic< uint64 >::is_always_lock_free, "Atomics must be address-free" );
+
+    alignas( cache_line_size ) std::atomic< uint64 > head = 0U;
+    alignas( cache_line_size ) std::atomic< uint64 > tail = 0U;
+    alignas( cache_line_size ) std::array< Record, capacity > records = { };
+};
+
+/// \brief Push a record from the producer side.
+///
+/// \returns false without blocking if the consumer hasn't made room for it.
+template < typename Record, uint32 capacity >
+auto try_push( SpscRing< Record, capacity >& ring, Record const& record ) -> bool
+{
+    auto const head = ring.head.load( std::memory_order_relaxed );
+    if ( ( head - ring.tail.load( std::memory_order_acquire ) ) >= capacity )
+    {
+        return false;
+    }
+
+    ring.records[ head % capacity ] = record;
+    ring.head.store( head + 1U, std::memory_order_release );
+    return true;
+}
+
+/// \brief Pop the oldest record from the consumer side.
+///
+/// \returns false without blocking if no record is available.
+template < typename Record, uint32 capacity >
+auto try_pop( SpscRing< Record, capacity >& ring, Record& record ) -> bool
+{
+    auto const tail = ring.tail.load( std::memory_order_relaxed );
+    if ( tail == ring.head.load( std::memory_order_acquire ) )
+    {
+        return false;
+    }
+
+    record = ring.records[ tail % capacity ];
+    ring.tail.store( tail + 1U, std::memory_order_release );
+    return true;
+}
+
+/// \brief Look at the oldest record from the consumer side without popping it.
+///
+/// \returns nullptr if no record is available.
+template < typename Record, uint32 capacity >
+auto peek( SpscRing< Record, capacity > const& ring ) -> Record const*
+{
+    auto const tail = ring.tail.load( std::memory_order_relaxed );
+    if ( tail == ring.head.load( std::memory_order_acquire ) )
+    {
+        return nullptr;
+    }
+    return &ring.records[ tail % capacity ];
+}
+
+} // namespace ltb::net
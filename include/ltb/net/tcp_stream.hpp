@@ -0,0 +1,85 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/utils/types.hpp"
+
+// standard
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace ltb::net
+{
+
+/// \brief A blocking TCP connection that carries a byte stream between machines.
+///
+/// Meant to be driven from a worker thread, since sends and receives only return once
+/// every byte went through. `shutdown` may be called from another thread to unblock them.
+class TcpStream
+{
+public:
+    TcpStream( )                                     = default;
+    TcpStream( TcpStream const& )                    = delete;
+    TcpStream( TcpStream&& )                         = delete;
+    auto operator=( TcpStream const& ) -> TcpStream& = delete;
+    auto operator=( TcpStream&& ) -> TcpStream&      = delete;
+    ~TcpStream( );
+
+    /// \brief Connect to a TcpListener listening on an IPv4 address and port.
+    auto connect( std::string_view address, uint16 port ) -> bool;
+
+    /// \brief Block until every byte of the payload was sent.
+    auto send( std::span< std::byte const > payload ) -> bool;
+
+    /// \brief Block until the payload is completely filled.
+    ///
+    /// \param closed set to true if the other side hung up before sending anything.
+    auto receive( std::span< std::byte > payload, bool& closed ) -> bool;
+
+    /// \brief Stop sending and receiving. Blocked calls on other threads return false.
+    auto shutdown( ) -> void;
+
+    /// \brief Close the connection so the stream can be reused.
+    auto reset( ) -> void;
+
+    [[nodiscard]] auto is_connected( ) const -> bool;
+
+private:
+    friend class TcpListener;
+
+    // Shutting down reads the socket while another thread may be accepting or resetting it.
+    std::atomic< int32 > socket_fd_ = -1;
+
+    auto configure( ) -> void;
+};
+
+/// \brief Accepts TcpStream connections on an IPv4 address and port.
+class TcpListener
+{
+public:
+    TcpListener( )                                       = default;
+    TcpListener( TcpListener const& )                    = delete;
+    TcpListener( TcpListener&& )                         = delete;
+    auto operator=( TcpListener const& ) -> TcpListener& = delete;
+    auto operator=( TcpListener&& ) -> TcpListener&      = delete;
+    ~TcpListener( );
+
+    /// \brief Start listening. Use "0.0.0.0" to accept connections from any machine.
+    auto listen( std::string_view address, uint16 port ) -> bool;
+
+    /// \brief Block until a connection arrives. The stream must not be connected yet.
+    ///        Connections that fail before they're accepted are skipped.
+    auto accept( TcpStream& stream ) -> bool;
+
+    /// \brief Stop listening. A blocked accept on another thread returns false.
+    auto shutdown( ) -> void;
+
+private:
+    int32 socket_fd_ = -1;
+};
+
+} // namespace ltb::net
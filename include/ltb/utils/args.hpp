@@ -7,7 +7,10 @@
 #include "ltb/utils/types.hpp"
 
 // standard
+#include <optional>
 #include <span>
+#include <string_view>
+#include <vector>
 
 namespace ltb::utils
 {
@@ -17,4 +20,22 @@ auto get_physical_device_index_from_args(
     uint32&                         physical_device_index
 ) -> bool;
 
+/// \brief Parse the argument at `index` as a number. The value is left unchanged
+///        if there are fewer arguments, and false is returned if it can't be parsed.
+template < typename T >
+auto get_number_from_args( std::span< char const* > const& args, size_t index, T& value ) -> bool;
+
+/// \brief Remove a flag from the arguments so the rest can be parsed by position.
+///
+/// \returns true if the flag was given.
+auto take_flag_from_args( std::vector< char const* >& args, std::string_view flag ) -> bool;
+
+/// \brief Remove an option and the value after it from the arguments. The value is
+///        left unchanged if the option isn't given, and false is returned if it has no value.
+auto take_option_from_args(
+    std::vector< char const* >&        args,
+    std::string_view                   option,
+    std::optional< std::string_view >& value
+) -> bool;
+
 } // namespace ltb::utils
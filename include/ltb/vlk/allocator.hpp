@@ -0,0 +1,105 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/vlk/vlk.hpp"
+
+// standard
+#include <map>
+#include <optional>
+
+namespace ltb::vlk
+{
+
+/// \brief The size of the device memory blocks resources are sub-allocated from.
+auto constexpr memory_block_size = VkDeviceSize{ 64ULL * 1024ULL * 1024ULL };
+
+/// \brief How memory is used, which decides the memory types it can live in.
+enum class MemoryUsage
+{
+    DeviceLocal,  // Only the device accesses it.
+    HostUpload,   // Written by the host through a mapping. Host-visible and coherent.
+    HostReadback, // Read by the host through a mapping. Host-cached where possible.
+    Transient,    // Never leaves a render pass. Lazily allocated where possible.
+    Exportable,   // Shared with other processes. Only its type is picked here.
+};
+
+/// \brief A range of device memory handed out by an AllocatorData. Host-visible
+///        allocations are mapped for as long as they exist.
+struct MemoryAllocation
+{
+    VkDeviceMemory memory            = { };
+    VkDeviceSize   offset            = { };
+    VkDeviceSize   size              = { };
+    uint32         memory_type_index = { };
+    void*          mapped            = nullptr;
+
+    // The block the range was taken from. Allocations too large for a block have none.
+    std::optional< uint32 > block_id = { };
+};
+
+/// \brief One large allocation that resources are bound into at aligned offsets.
+///
+/// Free ranges are indexed by offset, to merge them with their neighbours when they're
+/// freed, and by size, to find the smallest range that fits an allocation.
+struct MemoryBlock
+{
+    VkDeviceMemory memory            = { };
+    uint32         memory_type_index = { };
+    bool           linear            = false;
+    void*          mapped            = nullptr;
+    uint32         allocation_count  = 0U;
+
+    std::map< VkDeviceSize, VkDeviceSize >      free_ranges  = { }; // offset -> size
+    std::multimap< VkDeviceSize, VkDeviceSize > free_by_size = { }; // size -> offset
+};
+
+/// \brief Picks memory types and sub-allocates device memory for everything created
+///        from a setup, so recreating resources rarely reaches the driver.
+///
+/// Buffers and linear images never share a block with optimally tiled images, so
+/// neighbouring resources always respect the device's buffer-image granularity. Blocks
+/// are kept until the allocator is destroyed, so freed ranges are reused rather than
+/// given back. It's not thread-safe, like the command pool it's created alongside.
+struct AllocatorData
+{
+    VkPhysicalDevice                 physical_device   = { };
+    VkPhysicalDeviceMemoryProperties memory_properties = { };
+    std::map< uint32, MemoryBlock >  blocks            = { };
+    uint32                           next_block_id     = 0U;
+};
+
+/// \brief Initialize all the fields of an AllocatorData struct.
+auto initialize( AllocatorData& allocator, VkPhysicalDevice const& physical_device ) -> bool;
+
+/// \brief The first of `memory_type_bits` that suits a usage, preferring types with
+///        the usage's optional properties.
+auto find_memory_type_index(
+    AllocatorData const& allocator,
+    uint32               memory_type_bits,
+    MemoryUsage          usage
+) -> std::optional< uint32 >;
+
+/// \brief Sub-allocate memory that meets `requirements`. Allocations larger than
+///        a block get memory of their own.
+///
+/// \param linear whether the memory is bound to a buffer or a linearly tiled image.
+auto allocate(
+    MemoryAllocation&           allocation,
+    AllocatorData&              allocator,
+    VkDevice const&             device,
+    VkMemoryRequirements const& requirements,
+    MemoryUsage                 usage,
+    bool                        linear
+) -> bool;
+
+/// \brief Return an allocation's range to its block, or free its memory if it has none.
+auto deallocate( MemoryAllocation& allocation, AllocatorData& allocator, VkDevice const& device )
+    -> void;
+
+/// \brief Free every block. Everything allocated from them must be destroyed first.
+auto destroy( AllocatorData& allocator, VkDevice const& device ) -> void;
+
+} // namespace ltb::vlk
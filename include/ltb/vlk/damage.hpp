@@ -0,0 +1,36 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/vlk/vlk.hpp"
+
+namespace ltb::vlk
+{
+
+auto constexpr max_damage_rects = 8U;
+
+/// \brief A region of a frame that changed since the previous frame.
+struct DamageRect
+{
+    int32  x      = 0;
+    int32  y      = 0;
+    uint32 width  = 0U;
+    uint32 height = 0U;
+};
+
+/// \brief Check whether a rect covers no pixels.
+auto is_empty( VkRect2D const& rect ) -> bool;
+
+/// \brief The smallest rect containing both rects. Empty rects are ignored.
+auto unite( VkRect2D const& lhs, VkRect2D const& rhs ) -> VkRect2D;
+
+/// \brief Clip a rect to the extent of an image. The result may be empty.
+auto clip( VkRect2D const& rect, VkExtent2D const& extent ) -> VkRect2D;
+
+/// \brief Convert between a published damage rect and a Vulkan rect.
+auto to_rect( DamageRect const& damage ) -> VkRect2D;
+auto to_damage( VkRect2D const& rect ) -> DamageRect;
+
+} // namespace ltb::vlk
@@ -0,0 +1,34 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/vlk/setup.hpp"
+
+// standard
+#include <type_traits>
+
+namespace ltb::vlk
+{
+
+auto constexpr device_message_magic   = uint32{ 0x4C54'4244 }; // "LTBD"
+auto constexpr device_message_version = uint32{ 1 };
+
+/// \brief The consumer's device, sent to every producer as soon as it connects.
+///
+/// Producers pick the physical device with the same UUIDs before creating their
+/// own, so their rings can be imported without copies. A producer without a matching
+/// device goes straight to a host ring.
+struct DeviceMessage
+{
+    uint32   magic     = device_message_magic;
+    uint32   version   = device_message_version;
+    DeviceId device_id = { };
+};
+
+static_assert( std::is_trivially_copyable_v< DeviceMessage > );
+static_assert( std::is_standard_layout_v< DeviceMessage > );
+static_assert( 40U == sizeof( DeviceMessage ), "The layout must not change silently" );
+
+} // namespace ltb::vlk
@@ -0,0 +1,258 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/net/shared_memory.hpp"
+#include "ltb/net/spsc_ring.hpp"
+#include "ltb/vlk/image.hpp"
+#include "ltb/vlk/shared_ring.hpp"
+
+// standard
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+namespace ltb::vlk
+{
+
+/// \brief The block at the start of a host ring's shared memory. The pixels of
+///        every slot follow it, starting at `host_ring_pixels_offset`.
+///
+/// Frame N is copied into slot N % slot_count. The producer publishes the frame's
+/// record once its pixels are in the slot, and the consumer stores N + 1 in
+/// `released_frame_count` once it has copied them out.
+struct HostRingControl
+{
+    uint32                slot_count           = 0U;
+    std::atomic< uint64 > released_frame_count = { };
+
+    net::SpscRing< FrameRecord, frame_record_capacity > frames = { };
+};
+
+/// \brief Where the first slot's pixels start in a host ring's shared memory.
+auto constexpr host_ring_page_size     = size_t{ 4096U };
+auto constexpr host_ring_pixels_offset = ( ( sizeof( HostRingControl ) + host_ring_page_size - 1U )
+                                           / host_ring_page_size )
+                                       * host_ring_page_size;
+
+auto constexpr host_ring_message_magic   = uint32{ 0x4C54'4248 }; // "LTBH"
+auto constexpr host_ring_message_version = uint32{ 1 };
+
+/// \brief The header sent along with the shared memory of a host ring.
+struct HostRingMessage
+{
+    uint32 magic      = host_ring_message_magic;
+    uint32 version    = host_ring_message_version;
+    uint32 slot_count = 0U;
+    uint32 format     = 0U; // VkFormat
+    uint32 width      = 0U;
+    uint32 height     = 0U;
+    uint64 row_pitch  = 0U;
+    uint64 slot_size  = 0U;
+    uint64 generation = 0U;
+};
+
+static_assert( std::is_trivially_copyable_v< HostRingMessage > );
+static_assert( std::is_standard_layout_v< HostRingMessage > );
+static_assert( 48U == sizeof( HostRingMessage ), "The layout must not change silently" );
+
+auto constexpr transport_reply_magic = uint32{ 0x4C54'4241 }; // "LTBA"
+
+enum class TransportStatus : uint32
+{
+    Accepted,
+    Fallback,
+};
+
+/// \brief The consumer's answer to a ring message. A producer whose shared ring
+///        can't be imported is asked to fall back to a host ring instead.
+struct TransportReply
+{
+    uint32          magic  = transport_reply_magic;
+    TransportStatus status = TransportStatus::Accepted;
+};
+
+static_assert( std::is_trivially_copyable_v< TransportReply > );
+static_assert( 8U == sizeof( TransportReply ), "The layout must not change silently" );
+
+/// \brief A persistently mapped host-visible buffer and the commands that copy through it.
+struct HostTransfer
+{
+    VkBuffer         buffer         = { };
+    AllocatorData*   allocator      = nullptr;
+    MemoryAllocation allocation     = { };
+    VkCommandBuffer  command_buffer = { };
+    VkFence          fence          = { };
+};
+
+/// \brief How much has been copied through host memory since the last report.
+struct HostCopyStats
+{
+    uint64                                frame_count = 0U;
+    uint64                                byte_count  = 0U;
+    std::chrono::steady_clock::duration   copy_time   = { };
+    std::chrono::steady_clock::time_point report_time = { };
+};
+
+template < ExternalMemory mem_type >
+struct HostRingData;
+
+template <>
+struct HostRingData< ExternalMemory::Export >
+{
+    std::vector< ImageData< ExternalMemory::None > > images          = { };
+    std::vector< HostTransfer >                      readbacks       = { };
+    std::vector< std::optional< FrameRecord > >      pending_records = { };
+    net::SharedMemory                                memory          = { };
+    HostRingControl*                                 control         = nullptr;
+    uint64                                           row_pitch       = 0U;
+    uint64                                           slot_size       = 0U;
+    uint64                                           generation      = 0U;
+    uint64                                           next_frame_id   = 0U;
+    uint64                                           next_published  = 0U;
+    HostCopyStats                                    stats           = { };
+};
+
+template <>
+struct HostRingData< ExternalMemory::Import >
+{
+    ImageData< ExternalMemory::None > image            = { };
+    HostTransfer                      upload           = { };
+    net::SharedMemory                 memory           = { };
+    HostRingControl*                  control          = nullptr;
+    uint64                            slot_size        = 0U;
+    uint64                            generation       = 0U;
+    std::optional< uint64 >           latched_frame_id = { };
+    std::optional< FrameRecord >      latched_record   = { };
+    HostCopyStats                     stats            = { };
+};
+
+/// \brief Create the render targets, readback buffers, and shared memory of a producer
+///        host ring. Used when the consumer can't import the producer's device memory.
+auto initialize(
+    HostRingData< ExternalMemory::Export >& ring,
+    AllocatorData&                          allocator,
+    VkDevice const&                         device,
+    VkCommandPool const&                    command_pool,
+    VkExtent3D                              image_extents,
+    VkFormat                                color_format,
+    uint32                                  slot_count
+) -> bool;
+
+/// \brief A wrapper function around the main initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    HostRingData< ExternalMemory::Export >& ring,
+    SetupData< setup_app_type > const&      setup,
+    VkExtent3D                              image_extents,
+    uint32                                  slot_count
+) -> bool
+{
+    auto color_format = VkFormat{ };
+    if constexpr ( setup_app_type == AppType::Windowed )
+    {
+        color_format = setup.surface_format.format;
+    }
+    else
+    {
+        color_format = setup.color_format;
+    }
+    return initialize(
+        ring,
+        *setup.allocator,
+        setup.device,
+        setup.graphics_command_pool,
+        image_extents,
+        color_format,
+        slot_count
+    );
+}
+
+/// \brief Map the shared memory of a producer host ring and create the image it's
+///        uploaded to. The file descriptor is owned by the ring, even on failure.
+auto initialize(
+    HostRingData< ExternalMemory::Import >& ring,
+    AllocatorData&                          allocator,
+    VkDevice const&                         device,
+    VkCommandPool const&                    command_pool,
+    HostRingMessage const&                  message,
+    int32                                   memory_fd
+) -> bool;
+
+/// \brief A wrapper function around the main initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    HostRingData< ExternalMemory::Import >& ring,
+    SetupData< setup_app_type > const&      setup,
+    HostRingMessage const&                  message,
+    int32                                   memory_fd
+) -> bool
+{
+    return initialize(
+        ring,
+        *setup.allocator,
+        setup.device,
+        setup.graphics_command_pool,
+        message,
+        memory_fd
+    );
+}
+
+/// \brief Describe a producer host ring. The caller owns the duplicated file descriptor.
+auto get_message(
+    HostRingMessage&                              message,
+    int32&                                        memory_fd,
+    HostRingData< ExternalMemory::Export > const& ring
+) -> bool;
+
+/// \brief Claim the slot of the next frame. Returns false without blocking
+///        if the slot's last frame hasn't been copied to shared memory yet.
+auto acquire_render_slot(
+    HostRingData< ExternalMemory::Export >& ring,
+    uint32&                                 slot,
+    uint64&                                 frame_id
+) -> bool;
+
+/// \brief Copy a frame rendered into its slot back to host memory. Must be submitted
+///        after the frame's render. The record is published once the copy is done.
+auto submit_readback(
+    HostRingData< ExternalMemory::Export >& ring,
+    VkDevice const&                         device,
+    VkQueue const&                          queue,
+    FrameRecord const&                      record
+) -> bool;
+
+/// \brief Copy every finished readback into shared memory and publish its record, in
+///        frame order, as long as the consumer has released the slots they go into.
+auto publish_frames( HostRingData< ExternalMemory::Export >& ring, VkDevice const& device )
+    -> bool;
+
+/// \brief Upload the next published frame, if any, into the ring's image. The upload
+///        is submitted to the queue so later submits can sample the image.
+///
+/// \returns true once any frame has been uploaded.
+auto latch_ready_frame(
+    HostRingData< ExternalMemory::Import >& ring,
+    VkDevice const&                         device,
+    VkQueue const&                          queue
+) -> bool;
+
+/// \brief Destroy all the fields of a HostRingData struct.
+template < ExternalMemory mem_type >
+auto destroy(
+    HostRingData< mem_type >& ring,
+    VkDevice const&           device,
+    VkCommandPool const&      command_pool
+) -> void;
+
+/// \brief A wrapper function around the main destroy function.
+template < ExternalMemory mem_type, AppType setup_app_type >
+auto destroy( HostRingData< mem_type >& ring, SetupData< setup_app_type > const& setup ) -> void
+{
+    return destroy( ring, setup.device, setup.graphics_command_pool );
+}
+
+} // namespace ltb::vlk
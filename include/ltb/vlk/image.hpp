@@ -6,29 +6,104 @@
 // project
 #include "ltb/vlk/setup.hpp"
 
+// standard
+#include <array>
+#include <span>
+#include <type_traits>
+#include <vector>
+
 namespace ltb::vlk
 {
 
+/// \brief The most memory planes a DRM format modifier can split an image into.
+auto constexpr max_memory_planes = 4U;
+
 template < ExternalMemory mem_type >
 struct ImageData
 {
     VkExtent2D           image_size          = { };
+    VkFormat             color_format        = { };
+    VkImageTiling        image_tiling        = { };
     VkImage              color_image         = { };
     VkMemoryRequirements memory_requirements = { };
     uint32               memory_type_index   = { };
     VkDeviceMemory       color_image_memory  = { };
+    VkDeviceSize         memory_offset       = { };
     VkImageView          color_image_view    = { };
+
+    // Images bound into an ImagePoolData share its memory, which only the pool frees.
+    bool owns_memory = true;
+
+    // Set when the memory is sub-allocated, in which case destroy hands it back.
+    AllocatorData*   allocator  = nullptr;
+    MemoryAllocation allocation = { };
+
+    // Only used by dma-buf images.
+    ExternalHandle                     external_handle     = ExternalHandle::OpaqueFd;
+    uint64                             drm_format_modifier = { };
+    std::vector< VkSubresourceLayout > plane_layouts       = { };
+};
+
+/// \brief One external allocation that several images are bound into at aligned offsets,
+///        so the whole set is shared with a single file descriptor.
+///
+/// `memory` stays null when the driver requires dedicated image allocations, in which
+/// case every image owns its own memory instead.
+template < ExternalMemory mem_type >
+struct ImagePoolData
+{
+    VkDeviceMemory memory            = { };
+    VkDeviceSize   allocation_size   = { };
+    uint32         memory_type_index = { };
+    ExternalHandle external_handle   = ExternalHandle::OpaqueFd;
 };
 
+/// \brief Where one memory plane of a dma-buf image lives in its allocation.
+struct ExternalPlaneLayout
+{
+    uint64 offset    = 0U;
+    uint64 row_pitch = 0U;
+};
+
+/// \brief Everything another process needs to import an exported image without
+///        hardcoding how it was created. The layout is fixed so it can be sent
+///        over a socket as raw bytes.
+///
+/// `offset` is where the image is bound in the allocation, `memory_type_bits` are
+/// the memory types an opaque fd can be imported as, and `generation` changes
+/// whenever the exporter recreates its images. Dma-buf images also carry the DRM
+/// format modifier and the layout of each of its memory planes.
+struct ExternalImageDescription
+{
+    uint32 width            = 0U;
+    uint32 height           = 0U;
+    uint32 format           = 0U; // VkFormat
+    uint32 tiling           = 0U; // VkImageTiling
+    uint64 allocation_size  = 0U;
+    uint64 offset           = 0U;
+    uint32 memory_type_bits = 0U;
+    uint32 slot             = 0U;
+    uint64 generation       = 0U;
+
+    uint32                                               handle_type         = 0U; // ExternalHandle
+    uint32                                               plane_count         = 0U;
+    uint64                                               drm_format_modifier = 0U;
+    std::array< ExternalPlaneLayout, max_memory_planes > planes              = { };
+};
+
+static_assert( std::is_trivially_copyable_v< ExternalImageDescription > );
+static_assert( std::is_standard_layout_v< ExternalImageDescription > );
+static_assert( 128U == sizeof( ExternalImageDescription ), "The layout must not change silently" );
+
 /// \brief Initialize all the fields of an ImageData struct.
 template < ExternalMemory mem_type >
 auto initialize(
-    ImageData< mem_type >&  image,
-    VkPhysicalDevice const& physical_device,
-    VkDevice const&         device,
-    VkExtent3D              image_extents,
-    VkFormat                color_format,
-    int32                   import_image_fd
+    ImageData< mem_type >& image,
+    AllocatorData&         allocator,
+    VkDevice const&        device,
+    VkExtent3D             image_extents,
+    VkFormat               color_format,
+    int32                  import_image_fd
 ) -> bool;
 
 /// \brief A wrapper function around the main initialize function.
@@ -51,7 +126,7 @@ auto initialize(
     }
     return initialize(
         image,
-        setup.physical_device,
+        *setup.allocator,
         setup.device,
         image_extents,
         color_format,
@@ -59,12 +134,111 @@ auto initialize(
     );
 }
 
+/// \brief Initialize an exportable image whose memory is shared as `handle_type`.
+auto initialize(
+    ImageData< ExternalMemory::Export >& image,
+    AllocatorData&                       allocator,
+    VkDevice const&                      device,
+    VkExtent3D                           image_extents,
+    VkFormat                             color_format,
+    ExternalHandle                       handle_type
+) -> bool;
+
+/// \brief A wrapper function around the handle-type initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    ImageData< ExternalMemory::Export >& image,
+    SetupData< setup_app_type > const&   setup,
+    VkExtent3D                           image_extents,
+    ExternalHandle                       handle_type
+) -> bool
+{
+    auto color_format = VkFormat{ };
+    if constexpr ( setup_app_type == AppType::Windowed )
+    {
+        color_format = setup.surface_format.format;
+    }
+    else
+    {
+        color_format = setup.color_format;
+    }
+    return initialize(
+        image,
+        *setup.allocator,
+        setup.device,
+        image_extents,
+        color_format,
+        handle_type
+    );
+}
+
+/// \brief Import an image exported by another process, recreating it from its description.
+auto initialize(
+    ImageData< ExternalMemory::Import >& image,
+    AllocatorData&                       allocator,
+    VkDevice const&                      device,
+    ExternalImageDescription const&      description,
+    int32                                import_image_fd
+) -> bool;
+
+/// \brief A wrapper function around the main description-based initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    ImageData< ExternalMemory::Import >& image,
+    SetupData< setup_app_type > const&   setup,
+    ExternalImageDescription const&      description,
+    int32                                import_image_fd
+) -> bool
+{
+    return initialize( image, *setup.allocator, setup.device, description, import_image_fd );
+}
+
+/// \brief Create `image_count` exportable images and bind them all into one allocation.
+auto initialize(
+    ImagePoolData< ExternalMemory::Export >&            pool,
+    std::vector< ImageData< ExternalMemory::Export > >& images,
+    AllocatorData&                                      allocator,
+    VkDevice const&                                     device,
+    VkExtent3D                                          image_extents,
+    VkFormat                                            color_format,
+    ExternalHandle                                      handle_type,
+    uint32                                              image_count
+) -> bool;
+
+/// \brief Import a pool exported by another process, recreating its images from their
+///        descriptions and binding them into the single imported allocation.
+auto initialize(
+    ImagePoolData< ExternalMemory::Import >&            pool,
+    std::vector< ImageData< ExternalMemory::Import > >& images,
+    AllocatorData&                                      allocator,
+    VkDevice const&                                     device,
+    std::span< ExternalImageDescription const >         descriptions,
+    int32                                               import_memory_fd
+) -> bool;
+
+/// \brief Describe an exported image so another process can import it.
+auto describe(
+    ExternalImageDescription&                  description,
+    ImageData< ExternalMemory::Export > const& image,
+    uint32                                     slot,
+    uint64                                     generation
+) -> void;
+
+/// \brief Describe an exported image bound into a pool's allocation.
+auto describe(
+    ExternalImageDescription&                      description,
+    ImagePoolData< ExternalMemory::Export > const& pool,
+    ImageData< ExternalMemory::Export > const&     image,
+    uint32                                         slot,
+    uint64                                         generation
+) -> void;
+
 /// \brief Get the file descriptor of an image with external memory storage.
 auto get_file_descriptor(
-    int32&                file_descriptor,
-    VkInstance const&     instance,
-    VkDevice const&       device,
-    VkDeviceMemory const& image_memory
+    int32&                                     file_descriptor,
+    VkInstance const&                          instance,
+    VkDevice const&                            device,
+    ImageData< ExternalMemory::Export > const& image
 ) -> bool;
 
 /// \brief Get the file descriptor of an image with external memory storage.
@@ -75,14 +249,17 @@ auto get_file_descriptor(
     ImageData< ExternalMemory::Export > const& image
 ) -> bool
 {
-    return get_file_descriptor(
-        file_descriptor,
-        setup.instance,
-        setup.device,
-        image.color_image_memory
-    );
+    return get_file_descriptor( file_descriptor, setup.instance, setup.device, image );
 }
 
+/// \brief Get the file descriptor of a pool's allocation.
+auto get_file_descriptor(
+    int32&                                         file_descriptor,
+    VkInstance const&                              instance,
+    VkDevice const&                                device,
+    ImagePoolData< ExternalMemory::Export > const& pool
+) -> bool;
+
 /// \brief Destroy all the fields of an ImageData struct.
 template < ExternalMemory mem_type >
 auto destroy( ImageData< mem_type >& image, VkDevice const& device ) -> void;
@@ -94,4 +271,8 @@ auto destroy( ImageData< mem_type >& image, SetupData< setup_app_type > const& s
     return destroy( image, setup.device );
 }
 
+/// \brief Free a pool's allocation. The images bound into it must be destroyed first.
+template < ExternalMemory mem_type >
+auto destroy( ImagePoolData< mem_type >& pool, VkDevice const& device ) -> void;
+
 } // namespace ltb::vlk
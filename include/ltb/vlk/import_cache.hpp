@@ -0,0 +1,94 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/vlk/image.hpp"
+
+// standard
+#include <compare>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace ltb::vlk
+{
+
+/// \brief Identifies an image shared by a producer: the producer, the ring slot it's
+///        displayed from, and the generation of the allocation it was created in.
+struct ImportKey
+{
+    uint32 producer_id = 0U;
+    uint32 slot        = 0U;
+    uint64 generation  = 0U;
+
+    auto operator<=>( ImportKey const& ) const = default;
+};
+
+/// \brief An imported image and how many rings currently display it.
+struct CachedImport
+{
+    ImageData< ExternalMemory::Import > image      = { };
+    uint32                              user_count = 0U;
+    bool                                evicted    = false;
+};
+
+/// \brief Imported images kept alive across ring announcements, so a producer that
+///        announces the same allocations again while its ring is still displayed, like
+///        one that reconnects, reuses the existing imports and views.
+///
+/// Images are evicted once their producer announces a newer generation or the last ring
+/// using them is released, and are only destroyed once no ring uses them. Rings that are
+/// still read by frames in flight must not be released until those frames are done, so
+/// evicted images are never destroyed while the GPU samples them.
+struct ImportCacheData
+{
+    std::map< ImportKey, CachedImport > images = { };
+
+    // Pools are keyed by producer id and generation, and freed with their last image.
+    std::map< std::pair< uint32, uint64 >, ImagePoolData< ExternalMemory::Import > > pools = { };
+};
+
+/// \brief Find every slot of a producer's allocation generation and mark them as used by
+///        one more ring. A generation re-announced after it was evicted is kept again.
+///
+/// \returns false if the generation isn't cached, in which case nothing is marked.
+auto acquire(
+    ImportCacheData&                                    cache,
+    uint32                                              producer_id,
+    uint64                                              generation,
+    uint32                                              slot_count,
+    std::vector< ImageData< ExternalMemory::Import > >& images
+) -> bool;
+
+/// \brief Hand newly imported images, and the pool they're bound into if any, over to the
+///        cache, already used by one ring. Older generations of the producer are evicted.
+///        The images can still be used through `images`, but only the cache destroys them.
+auto insert(
+    ImportCacheData&                                    cache,
+    uint32                                              producer_id,
+    uint64                                              generation,
+    std::vector< ImageData< ExternalMemory::Import > >& images,
+    ImagePoolData< ExternalMemory::Import >&            pool
+) -> void;
+
+/// \brief Mark the slots of a producer's allocation generation as used by one less ring.
+///        Slots no ring uses anymore are evicted.
+auto release( ImportCacheData& cache, uint32 producer_id, uint64 generation, uint32 slot_count )
+    -> void;
+
+/// \brief Destroy the images no ring uses anymore, and the pools they leave empty.
+auto destroy_evicted( ImportCacheData& cache, VkDevice const& device ) -> void;
+
+/// \brief Destroy every cached image and pool, whether they're in use or not.
+auto destroy( ImportCacheData& cache, VkDevice const& device ) -> void;
+
+/// \brief A wrapper function around the main destroy function.
+template < AppType setup_app_type >
+auto destroy( ImportCacheData& cache, SetupData< setup_app_type > const& setup ) -> void
+{
+    return destroy( cache, setup.device );
+}
+
+} // namespace ltb::vlk
@@ -0,0 +1,38 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/utils/types.hpp"
+
+// standard
+#include <array>
+#include <type_traits>
+
+namespace ltb::vlk
+{
+
+auto constexpr layer_message_magic   = uint32{ 0x4C54'424C }; // "LTBL"
+auto constexpr layer_message_version = uint32{ 1 };
+
+/// \brief Where a producer's frames are composited. Sent before the producer's ring.
+///
+/// Layers are drawn in increasing z-order, then increasing id. The rect is the
+/// layer's x, y, width, and height as fractions of the consumer's output. A producer
+/// that reconnects with the same layer id takes over the layer where it left off.
+struct LayerMessage
+{
+    uint32                   magic    = layer_message_magic;
+    uint32                   version  = layer_message_version;
+    uint32                   layer_id = 0U;
+    int32                    z_order  = 0;
+    std::array< float32, 4 > rect     = { 0.0F, 0.0F, 1.0F, 1.0F };
+    float32                  opacity  = 1.0F;
+};
+
+static_assert( std::is_trivially_copyable_v< LayerMessage > );
+static_assert( std::is_standard_layout_v< LayerMessage > );
+static_assert( 36U == sizeof( LayerMessage ), "The layout must not change silently" );
+
+} // namespace ltb::vlk
@@ -7,6 +7,7 @@
 #include "ltb/vlk/output.hpp"
 
 // standard
+#include <array>
 #include <vector>
 
 namespace ltb::vlk
@@ -32,11 +33,91 @@ struct DisplayUniforms
 auto constexpr float_size = sizeof( float32 );
 auto constexpr vec4_size  = float_size * 4;
 
+/// \brief Where a composited layer is drawn and how opaque it is. The rect is the
+///        layer's x, y, width, and height as fractions of the output.
+struct LayerUniforms
+{
+    alignas( uniform_alignment ) std::array< float32, 4 > rect    = { 0.0F, 0.0F, 1.0F, 1.0F };
+    alignas( uniform_alignment ) float32                  opacity = 1.0F;
+
+    auto operator==( LayerUniforms const& ) const -> bool = default;
+};
+
+/// \brief Everything a triangle is drawn with, as its shaders read it from a uniform buffer.
+struct TriangleUniforms
+{
+    ModelUniforms   model   = { };
+    DisplayUniforms display = { };
+};
+
 static_assert( vec4_size == uniform_alignment );
 static_assert( sizeof( ModelUniforms ) == vec4_size );
 static_assert( alignof( ModelUniforms ) == uniform_alignment );
 static_assert( sizeof( DisplayUniforms ) == vec4_size );
 static_assert( alignof( DisplayUniforms ) == uniform_alignment );
+static_assert( sizeof( LayerUniforms ) == ( vec4_size * 2U ) );
+static_assert( alignof( LayerUniforms ) == uniform_alignment );
+static_assert( sizeof( TriangleUniforms ) == ( vec4_size * 2U ) );
+
+/// \brief The most layers a composite pipeline can draw at once.
+auto constexpr max_composite_layers = 32U;
+
+/// \brief How a composited layer is blended over the layers drawn before it.
+enum class CompositeBlend : uint32
+{
+    Straight,      // Colors aren't multiplied by their alpha.
+    Premultiplied, // Colors are already multiplied by their alpha.
+    Opaque,        // The layer replaces everything below it. Alpha and opacity are ignored.
+};
+
+/// \brief How the colors sampled from a layer are converted before they're blended.
+enum class CompositeColor : uint32
+{
+    Linear,      // Sampled colors are linear, which includes every sRGB format.
+    SrgbEncoded, // Sampled colors are sRGB-encoded values stored in a UNORM format.
+};
+
+auto constexpr composite_blend_count   = 3U;
+auto constexpr composite_color_count   = 2U;
+auto constexpr composite_variant_count = composite_blend_count * composite_color_count;
+
+/// \brief A specialized composite pipeline. Every variant is created along with the
+///        pipeline, and the shader only contains the blend and color paths it uses.
+struct CompositeVariant
+{
+    CompositeBlend blend = CompositeBlend::Straight;
+    CompositeColor color = CompositeColor::Linear;
+
+    auto operator==( CompositeVariant const& ) const -> bool = default;
+};
+
+/// \brief Where a variant's pipeline is stored. Variants are ordered by blend, then color.
+constexpr auto get_variant_index( CompositeVariant const variant ) -> uint32
+{
+    return ( static_cast< uint32 >( variant.blend ) * composite_color_count )
+         + static_cast< uint32 >( variant.color );
+}
+
+/// \brief How an image changes hands with another process around a render.
+enum class OwnershipTransfer
+{
+    None,
+    Acquire, // Taken from the external queue family before it's sampled.
+    Release, // Handed to the external queue family once it's rendered.
+};
+
+/// \brief An image used by a render. Composite renders draw every layer, in order,
+///        with the layer's descriptor set, placement, opacity, and pipeline variant.
+struct RenderLayer
+{
+    VkImage           image            = { };
+    OwnershipTransfer transfer         = OwnershipTransfer::None;
+    uint32            descriptor_index = 0U;
+    LayerUniforms     uniforms         = { };
+    CompositeVariant  variant          = { };
+
+    auto operator==( RenderLayer const& ) const -> bool = default;
+};
 
 template < Pipeline pipeline_type >
 struct PipelineData;
@@ -44,10 +125,21 @@ struct PipelineData;
 template <>
 struct PipelineData< Pipeline::Triangle >
 {
-    ModelUniforms    model_uniforms   = { };
-    DisplayUniforms  display_uniforms = { };
-    VkPipelineLayout pipeline_layout  = { };
-    VkPipeline       pipeline         = { };
+    ModelUniforms         model_uniforms        = { };
+    DisplayUniforms       display_uniforms      = { };
+    VkDescriptorPool      descriptor_pool       = { };
+    VkDescriptorSetLayout descriptor_set_layout = { };
+    VkPipelineLayout      pipeline_layout       = { };
+    VkPipeline            pipeline              = { };
+
+    // The uniforms of each frame in flight, copied in before every render. Commands only
+    // bind a frame's set, so they stay valid while the uniforms change.
+    VkBuffer                       uniform_buffer       = { };
+    AllocatorData*                 allocator            = nullptr;
+    MemoryAllocation               uniform_allocation   = { };
+    VkDeviceSize                   uniform_stride       = 0U;
+    std::vector< VkDescriptorSet > descriptor_sets      = { };
+    uint32                         max_frames_in_flight = 0U;
 
     static constexpr auto vertex_count = 3U;
 };
@@ -55,11 +147,17 @@ struct PipelineData< Pipeline::Triangle >
 template <>
 struct PipelineData< Pipeline::Composite >
 {
-    VkDescriptorPool               descriptor_pool       = { };
-    VkDescriptorSetLayout          descriptor_set_layout = { };
-    std::vector< VkDescriptorSet > descriptor_sets       = { };
-    VkPipelineLayout               pipeline_layout       = { };
-    VkPipeline                     pipeline              = { };
+    VkDescriptorPool      descriptor_pool       = { };
+    VkDescriptorSetLayout descriptor_set_layout = { };
+    VkPipelineLayout      pipeline_layout       = { };
+
+    // One pipeline per variant, indexed by blend mode, then color conversion.
+    std::array< VkPipeline, composite_variant_count > pipelines = { };
+
+    // One set per layer per frame in flight, grouped by layer. The
+    // first `max_frames_in_flight` sets are the sets of layer 0.
+    std::vector< VkDescriptorSet > descriptor_sets      = { };
+    uint32                         max_frames_in_flight = 0U;
 
     static constexpr auto vertex_count = 4U;
 };
@@ -68,7 +166,9 @@ struct PipelineData< Pipeline::Composite >
 template < Pipeline pipeline_type >
 auto initialize(
     PipelineData< pipeline_type >& pipeline,
+    AllocatorData&                 allocator,
     VkDevice const&                device,
+    VkPipelineCache const&         pipeline_cache,
     VkRenderPass const&            render_pass,
     uint32                         max_frames_in_flight
 ) -> bool;
@@ -82,17 +182,103 @@ auto initialize(
     uint32                                 max_frames_in_flight
 ) -> bool
 {
-    return initialize( pipeline, setup.device, output.render_pass, max_frames_in_flight );
+    return initialize(
+        pipeline,
+        *setup.allocator,
+        setup.device,
+        setup.pipeline_cache,
+        output.render_pass,
+        max_frames_in_flight
+    );
 }
 
+/// \brief A wrapper function around the main initialize function. Headless renders pick
+///        their frame in flight with `SyncData::frame_index`.
 template < Pipeline pipeline_type, AppType setup_app_type >
 auto initialize(
     PipelineData< pipeline_type >&         pipeline,
     SetupData< setup_app_type > const&     setup,
-    OutputData< AppType::Headless > const& output
+    OutputData< AppType::Headless > const& output,
+    uint32                                 max_frames_in_flight
+) -> bool
+{
+    return initialize(
+        pipeline,
+        *setup.allocator,
+        setup.device,
+        setup.pipeline_cache,
+        output.render_pass,
+        max_frames_in_flight
+    );
+}
+
+/// \brief Initialize a triangle and a composite pipeline, which may use different render
+///        passes. Every pipeline of both is compiled in one parallel batch.
+auto initialize(
+    PipelineData< Pipeline::Triangle >&  triangle_pipeline,
+    PipelineData< Pipeline::Composite >& composite_pipeline,
+    AllocatorData&                       allocator,
+    VkDevice const&                      device,
+    VkPipelineCache const&               pipeline_cache,
+    VkRenderPass const&                  triangle_render_pass,
+    uint32                               triangle_frames_in_flight,
+    VkRenderPass const&                  composite_render_pass,
+    uint32                               composite_frames_in_flight
+) -> bool;
+
+/// \brief A wrapper function around the function that initializes both pipelines.
+template < AppType setup_app_type, AppType triangle_app_type, AppType composite_app_type >
+auto initialize(
+    PipelineData< Pipeline::Triangle >&     triangle_pipeline,
+    PipelineData< Pipeline::Composite >&    composite_pipeline,
+    SetupData< setup_app_type > const&      setup,
+    OutputData< triangle_app_type > const&  triangle_output,
+    uint32                                  triangle_frames_in_flight,
+    OutputData< composite_app_type > const& composite_output,
+    uint32                                  composite_frames_in_flight
 ) -> bool
 {
-    return initialize( pipeline, setup.device, output.render_pass, 1U );
+    return initialize(
+        triangle_pipeline,
+        composite_pipeline,
+        *setup.allocator,
+        setup.device,
+        setup.pipeline_cache,
+        triangle_output.render_pass,
+        triangle_frames_in_flight,
+        composite_output.render_pass,
+        composite_frames_in_flight
+    );
+}
+
+/// \brief The descriptor set a triangle reads a frame's uniforms from.
+auto get_descriptor_set( PipelineData< Pipeline::Triangle > const& pipeline, uint32 frame_index )
+    -> VkDescriptorSet const&;
+
+/// \brief Copy a triangle's uniforms to the buffer a frame in flight reads them from.
+///        The frame's previous render must have finished.
+auto update_uniforms( PipelineData< Pipeline::Triangle > const& pipeline, uint32 frame_index )
+    -> void;
+
+/// \brief The descriptor set a layer samples its image from in a frame.
+auto get_descriptor_set(
+    PipelineData< Pipeline::Composite > const& pipeline,
+    uint32                                     frame_index,
+    uint32                                     layer_index
+) -> VkDescriptorSet const&;
+
+/// \brief The pipeline specialized for a variant picked at runtime, like a layer's.
+auto get_pipeline( PipelineData< Pipeline::Composite > const& pipeline, CompositeVariant variant )
+    -> VkPipeline const&;
+
+/// \brief The pipeline specialized for a variant known at compile time.
+template < CompositeBlend blend, CompositeColor color >
+auto get_pipeline( PipelineData< Pipeline::Composite > const& pipeline ) -> VkPipeline const&
+{
+    auto constexpr variant_index
+        = get_variant_index( CompositeVariant{ .blend = blend, .color = color } );
+    static_assert( variant_index < composite_variant_count );
+    return pipeline.pipelines[ variant_index ];
 }
 
 /// \brief Destroy all the fields of a PipelineData struct.
@@ -0,0 +1,69 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/vlk/setup.hpp"
+
+// standard
+#include <array>
+#include <filesystem>
+#include <type_traits>
+
+namespace ltb::vlk
+{
+
+/// \brief Overrides the directory pipeline caches are saved to.
+auto constexpr pipeline_cache_dir_variable = "LTB_VLK_PIPELINE_CACHE_DIR";
+
+auto constexpr pipeline_cache_file_magic   = uint32{ 0x4C54'4250 }; // "LTBP"
+auto constexpr pipeline_cache_file_version = uint32{ 1 };
+
+/// \brief Written ahead of the driver's cache data. Drivers reject caches from other
+///        devices themselves, but not always gracefully, so a cache is only handed to
+///        the driver if it was written by the same device, driver, and driver version.
+struct PipelineCacheFileHeader
+{
+    uint32                            magic               = pipeline_cache_file_magic;
+    uint32                            version             = pipeline_cache_file_version;
+    uint32                            vendor_id           = 0U;
+    uint32                            device_id           = 0U;
+    uint32                            driver_version      = 0U;
+    uint32                            reserved            = 0U;
+    uint64                            data_size           = 0U;
+    std::array< uint8, VK_UUID_SIZE > pipeline_cache_uuid = { };
+    std::array< uint8, VK_UUID_SIZE > driver_uuid         = { };
+};
+
+static_assert( std::is_trivially_copyable_v< PipelineCacheFileHeader > );
+static_assert( std::is_standard_layout_v< PipelineCacheFileHeader > );
+static_assert( 64U == sizeof( PipelineCacheFileHeader ), "The layout must not change silently" );
+
+/// \brief The file a device's pipeline cache is saved to, under the directory set by
+///        `pipeline_cache_dir_variable` or the generated directory by default.
+auto get_pipeline_cache_path( VkPhysicalDevice const& physical_device ) -> std::filesystem::path;
+
+/// \brief Create a pipeline cache, filled with the contents of `cache_path` if it was saved
+///        by the same device and driver. A missing or mismatched file leaves it empty.
+auto initialize_pipeline_cache(
+    VkPipelineCache&             pipeline_cache,
+    VkPhysicalDevice const&      physical_device,
+    DeviceId const&              device_id,
+    VkDevice const&              device,
+    std::filesystem::path const& cache_path
+) -> bool;
+
+/// \brief Save a pipeline cache to `cache_path`. The file is replaced atomically, so
+///        processes that save the same cache at once never leave a partial file behind.
+auto save_pipeline_cache(
+    VkPipelineCache const&       pipeline_cache,
+    VkPhysicalDevice const&      physical_device,
+    DeviceId const&              device_id,
+    VkDevice const&              device,
+    std::filesystem::path const& cache_path
+) -> bool;
+
+auto destroy_pipeline_cache( VkPipelineCache& pipeline_cache, VkDevice const& device ) -> void;
+
+} // namespace ltb::vlk
@@ -0,0 +1,54 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/vlk/vlk.hpp"
+
+// standard
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ltb::vlk
+{
+
+/// \brief Threads that record parts of a render at the same time. The thread that starts a
+///        task is thread 0 and records its own part, so only `thread_count - 1` are started.
+///
+/// Every thread records into command buffers from its own command pools, since a pool can
+/// only be used by one thread at a time. The threads wait between tasks instead of being
+/// started for every render.
+struct RecordingThreadsData
+{
+    uint32 thread_count = 1U;
+
+    // The task every thread runs, given its thread index. Each new task gets a new id.
+    std::mutex                             mutex         = { };
+    std::condition_variable_any            task_started  = { };
+    std::condition_variable                task_finished = { };
+    std::function< bool( uint32 ) > const* task          = nullptr;
+    uint64                                 task_id       = 0U;
+    uint32                                 busy_count    = 0U;
+    bool                                   succeeded     = true;
+
+    std::vector< std::jthread > workers = { };
+};
+
+/// \brief The number of threads worth recording with, one per core.
+auto get_recording_thread_count( ) -> uint32;
+
+/// \brief Start the threads that record alongside the calling thread.
+auto initialize( RecordingThreadsData& threads, uint32 thread_count ) -> bool;
+
+/// \brief Run a task on every thread, including the calling one, and wait for all of them.
+///        Fails if the task fails on any thread.
+auto run( RecordingThreadsData& threads, std::function< bool( uint32 ) > const& task ) -> bool;
+
+/// \brief Stop and join the threads. Tasks must not be running.
+auto destroy( RecordingThreadsData& threads ) -> void;
+
+} // namespace ltb::vlk
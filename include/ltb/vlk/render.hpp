@@ -4,10 +4,15 @@
 #pragma once
 
 // project
+#include "ltb/vlk/damage.hpp"
 #include "ltb/vlk/pipeline.hpp"
 #include "ltb/vlk/synchronization.hpp"
+#include "ltb/vlk/timing.hpp"
 
 // standard
+#include <algorithm>
+#include <span>
+#include <utility>
 #include <vector>
 
 namespace ltb::vlk
@@ -15,83 +20,196 @@ namespace ltb::vlk
 
 constexpr auto max_possible_timeout = std::numeric_limits< uint64_t >::max( );
 
-template < AppType setup_app_type, Pipeline pipeline_type, AppType output_app_type >
-auto render(
-    SetupData< setup_app_type > const&   setup,
-    PipelineData< pipeline_type > const& pipeline,
-    OutputData< output_app_type > const& output,
-    SyncData< output_app_type > const&   sync
-) -> bool
+/// \brief Where a render draws, as picked for the frame being rendered.
+struct RenderTarget
 {
-    return render( setup, pipeline, ImageData< ExternalMemory::None >{ }, output, sync );
-}
+    VkFramebuffer framebuffer           = { };
+    VkRect2D      render_area           = { };
+    VkImage       discarded_image       = { }; // Moved out of the undefined layout first.
+    uint32        frame_index           = 0U;
+    VkQueryPool   timestamp_queries     = { };
+    uint32        first_timestamp_query = 0U;
 
-template <
-    AppType        setup_app_type,
-    Pipeline       pipeline_type,
-    ExternalMemory mem_type,
-    AppType        output_app_type >
-auto render(
-    SetupData< setup_app_type > const&   setup,
+    // When set, the threads record the layers into the secondary buffers, one per thread.
+    RecordingThreadsData*              recording_threads         = nullptr;
+    std::span< VkCommandBuffer const > secondary_command_buffers = { };
+};
+
+/// \brief Record the draws of a render. The render pass must already be begun.
+template < Pipeline pipeline_type, AppType output_app_type >
+auto record_draws(
+    VkCommandBuffer const&               command_buffer,
     PipelineData< pipeline_type > const& pipeline,
-    ImageData< mem_type > const&         image,
+    std::span< RenderLayer const > const layers,
     OutputData< output_app_type > const& output,
-    SyncData< output_app_type > const&   sync
-) -> bool
+    RenderTarget const&                  target
+) -> void
 {
-    auto* graphics_queue_fence = VkFence{ };
+    auto const viewport = VkViewport{
+        .x        = 0.0F,
+        .y        = 0.0F,
+        .width    = static_cast< float32 >( output.framebuffer_size.width ),
+        .height   = static_cast< float32 >( output.framebuffer_size.height ),
+        .minDepth = 0.0F,
+        .maxDepth = 1.0F,
+    };
+    auto constexpr first_viewport = 0U;
+    auto constexpr viewport_count = 1U;
+    ::vkCmdSetViewport( command_buffer, first_viewport, viewport_count, &viewport );
 
-    if constexpr ( AppType::Windowed == output_app_type )
-    {
-        graphics_queue_fence = sync.graphics_queue_fences[ sync.current_frame ];
-    }
-    else
-    {
-        graphics_queue_fence = sync.graphics_queue_fence;
-    }
+    // Only the render area is cleared, so nothing is drawn outside of it either.
+    auto constexpr first_scissor = 0U;
+    auto constexpr scissor_count = 1U;
+    ::vkCmdSetScissor( command_buffer, first_scissor, scissor_count, &target.render_area );
 
-    auto const graphics_fences = std::array{ graphics_queue_fence };
+    auto constexpr vertex_count   = PipelineData< pipeline_type >::vertex_count;
+    auto constexpr instance_count = 1U;
+    auto constexpr first_vertex   = 0U;
+    auto constexpr first_instance = 0U;
 
-    CHECK_VK( ::vkWaitForFences(
-        setup.device,
-        static_cast< uint32 >( graphics_fences.size( ) ),
-        graphics_fences.data( ),
-        VK_TRUE,
-        max_possible_timeout
-    ) );
+    if constexpr ( Pipeline::Triangle == pipeline_type )
+    {
+        ::vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline );
 
-    auto  swapchain_image_index = uint32{ 0 };
-    auto* framebuffer           = VkFramebuffer{ };
-    auto* command_buffer        = VkCommandBuffer{ };
+        // The uniforms are read from the frame's range of the uniform buffer.
+        auto constexpr first_set            = 0U;
+        auto constexpr descriptor_set_count = 1U;
+        auto constexpr dynamic_offset_count = 0U;
+        auto constexpr dynamic_offsets      = nullptr;
+        ::vkCmdBindDescriptorSets(
+            command_buffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipeline.pipeline_layout,
+            first_set,
+            descriptor_set_count,
+            &get_descriptor_set( pipeline, target.frame_index ),
+            dynamic_offset_count,
+            dynamic_offsets
+        );
 
-    if constexpr ( AppType::Windowed == output_app_type )
-    {
-        CHECK_VK( ::vkAcquireNextImageKHR(
-            setup.device,
-            output.swapchain,
-            max_possible_timeout,
-            sync.image_available_semaphores[ sync.current_frame ],
-            nullptr,
-            &swapchain_image_index
-        ) );
-        framebuffer    = output.framebuffers[ swapchain_image_index ];
-        command_buffer = sync.command_buffers[ sync.current_frame ];
+        ::vkCmdDraw( command_buffer, vertex_count, instance_count, first_vertex, first_instance );
     }
     else
     {
-        framebuffer    = output.framebuffer;
-        command_buffer = sync.command_buffer;
+        // One draw per layer, each blended over the layers drawn before it. The viewport
+        // and scissor are dynamic in every variant, so they survive pipeline changes.
+        auto* bound_pipeline = VkPipeline{ };
+        for ( auto const& layer : layers )
+        {
+            if ( auto* const variant_pipeline = get_pipeline( pipeline, layer.variant );
+                 bound_pipeline != variant_pipeline )
+            {
+                ::vkCmdBindPipeline(
+                    command_buffer,
+                    VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    variant_pipeline
+                );
+                bound_pipeline = variant_pipeline;
+            }
+
+            auto constexpr first_set            = 0U;
+            auto constexpr descriptor_set_count = 1U;
+            auto constexpr dynamic_offset_count = 0U;
+            auto constexpr dynamic_offsets      = nullptr;
+            ::vkCmdBindDescriptorSets(
+                command_buffer,
+                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                pipeline.pipeline_layout,
+                first_set,
+                descriptor_set_count,
+                &get_descriptor_set( pipeline, target.frame_index, layer.descriptor_index ),
+                dynamic_offset_count,
+                dynamic_offsets
+            );
+
+            ::vkCmdPushConstants(
+                command_buffer,
+                pipeline.pipeline_layout,
+                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                0,
+                sizeof( layer.uniforms ),
+                &layer.uniforms
+            );
+
+            ::vkCmdDraw(
+                command_buffer,
+                vertex_count,
+                instance_count,
+                first_vertex,
+                first_instance
+            );
+        }
     }
+}
+
+/// \brief Record the draws of a render's layers into the target's secondary buffers, with
+///        every recording thread taking a run of consecutive layers. Executing the first
+///        `secondary_count` buffers in order draws the layers in order.
+template < Pipeline pipeline_type, AppType output_app_type >
+auto record_draws_in_parallel(
+    uint32&                              secondary_count,
+    PipelineData< pipeline_type > const& pipeline,
+    std::span< RenderLayer const > const layers,
+    OutputData< output_app_type > const& output,
+    RenderTarget const&                  target
+) -> bool
+{
+    auto const layer_count    = layers.size( );
+    auto const thread_count   = size_t{ target.recording_threads->thread_count };
+    auto const layers_per_run = ( layer_count + thread_count - 1U ) / thread_count;
+    auto const run_count      = ( layer_count + layers_per_run - 1U ) / layers_per_run;
+    secondary_count           = static_cast< uint32 >( run_count );
 
-    CHECK_VK( ::vkResetFences(
-        setup.device,
-        static_cast< uint32 >( graphics_fences.size( ) ),
-        graphics_fences.data( )
-    ) );
+    // Dynamic state isn't inherited, so each buffer sets its own viewport and scissor.
+    auto const inheritance_info = VkCommandBufferInheritanceInfo{
+        .sType                = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext                = nullptr,
+        .renderPass           = output.render_pass,
+        .subpass              = 0U,
+        .framebuffer          = target.framebuffer,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags           = 0U,
+        .pipelineStatistics   = 0U,
+    };
+    auto const begin_info = VkCommandBufferBeginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT
+               | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &inheritance_info,
+    };
 
-    auto constexpr reset_flags = VkCommandBufferResetFlags{ 0U };
-    CHECK_VK( ::vkResetCommandBuffer( command_buffer, reset_flags ) );
+    auto const record_run = [ & ]( uint32 const thread_index ) -> bool
+    {
+        if ( thread_index >= secondary_count )
+        {
+            return true;
+        }
+        auto const  first_layer    = thread_index * layers_per_run;
+        auto const  run_size       = std::min( layers_per_run, layer_count - first_layer );
+        auto const  run_layers     = layers.subspan( first_layer, run_size );
+        auto const& command_buffer = target.secondary_command_buffers[ thread_index ];
 
+        CHECK_VK( ::vkBeginCommandBuffer( command_buffer, &begin_info ) );
+        record_draws( command_buffer, pipeline, run_layers, output, target );
+        CHECK_VK( ::vkEndCommandBuffer( command_buffer ) );
+        return true;
+    };
+    return run( *target.recording_threads, record_run );
+}
+
+/// \brief Record the commands of a render into a command buffer that isn't in use.
+///        Composite renders with recording threads record their layers in parallel.
+template < AppType setup_app_type, Pipeline pipeline_type, AppType output_app_type >
+auto record_render(
+    VkCommandBuffer const&               command_buffer,
+    SetupData< setup_app_type > const&   setup,
+    PipelineData< pipeline_type > const& pipeline,
+    std::span< RenderLayer const > const layers,
+    OutputData< output_app_type > const& output,
+    RenderTarget const&                  target
+) -> bool
+{
     auto const begin_info = VkCommandBufferBeginInfo{
         .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .pNext            = nullptr,
@@ -100,19 +218,74 @@ auto render(
     };
     CHECK_VK( ::vkBeginCommandBuffer( command_buffer, &begin_info ) );
 
-    if constexpr ( mem_type == ExternalMemory::Import )
+    // The first timestamp is written once every earlier command has started.
+    if ( nullptr != target.timestamp_queries )
     {
+        ::vkCmdResetQueryPool(
+            command_buffer,
+            target.timestamp_queries,
+            target.first_timestamp_query,
+            timestamp_queries_per_render
+        );
+        ::vkCmdWriteTimestamp(
+            command_buffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            target.timestamp_queries,
+            target.first_timestamp_query
+        );
+    }
+
+    // The producer's render pass leaves shared images in the shader read layout,
+    // so only their queue family changes and their contents are kept.
+    auto acquire_barriers = std::vector< VkImageMemoryBarrier >{ };
+    auto release_barriers = std::vector< VkImageMemoryBarrier >{ };
+    for ( auto const& layer : layers )
+    {
+        if ( OwnershipTransfer::None == layer.transfer )
+        {
+            continue;
+        }
+
+        auto const acquires = ( OwnershipTransfer::Acquire == layer.transfer );
+        auto const external = uint32{ VK_QUEUE_FAMILY_EXTERNAL };
+        auto const local    = setup.graphics_queue_family_index;
+
         auto const barrier = VkImageMemoryBarrier{
             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
             .pNext = nullptr,
-            .srcAccessMask = VK_ACCESS_NONE,
-            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .srcAccessMask = acquires ? VK_ACCESS_NONE : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = acquires ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_NONE,
+            .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
             .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = acquires ? external : local,
+            .dstQueueFamilyIndex = acquires ? local : external,
+            .image = layer.image,
+            .subresourceRange = VkImageSubresourceRange{
+                   .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                   .baseMipLevel   = 0U,
+                   .levelCount     = 1U,
+                   .baseArrayLayer = 0U,
+                   .layerCount     = 1U,
+            },
+        };
+        ( acquires ? acquire_barriers : release_barriers ).push_back( barrier );
+    }
+
+    // The render pass expects the presented layout, which the image doesn't have
+    // before its first render. Its contents are discarded either way.
+    if ( nullptr != target.discarded_image )
+    {
+        auto const barrier = VkImageMemoryBarrier{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext               = nullptr,
+            .srcAccessMask       = VK_ACCESS_NONE,
+            .dstAccessMask       = VK_ACCESS_NONE,
+            .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout           = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .image = image.color_image,
-            .subresourceRange = VkImageSubresourceRange{
+            .image               = target.discarded_image,
+            .subresourceRange    = VkImageSubresourceRange{
                    .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
                    .baseMipLevel   = 0U,
                    .levelCount     = 1U,
@@ -122,8 +295,8 @@ auto render(
         };
         ::vkCmdPipelineBarrier(
             command_buffer,
-            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
             0U,
             0U,
             nullptr,
@@ -134,6 +307,23 @@ auto render(
         );
     }
 
+    // Take ownership of the images from their producers, all in one barrier.
+    if ( !acquire_barriers.empty( ) )
+    {
+        ::vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0U,
+            0U,
+            nullptr,
+            0U,
+            nullptr,
+            static_cast< uint32 >( acquire_barriers.size( ) ),
+            acquire_barriers.data( )
+        );
+    }
+
     auto const clear_values = std::array{
         VkClearValue{
             .color = VkClearColorValue{ .float32 = { 0.0F, 0.0F, 0.0F, 0.0F } },
@@ -143,104 +333,372 @@ auto render(
         .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
         .pNext           = nullptr,
         .renderPass      = output.render_pass,
-        .framebuffer     = framebuffer,
-        .renderArea      = VkRect2D{
-             .offset = VkOffset2D{ .x = 0, .y = 0 },
-             .extent = output.framebuffer_size,
-        },
+        .framebuffer     = target.framebuffer,
+        .renderArea      = target.render_area,
         .clearValueCount = static_cast< uint32 >( clear_values.size( ) ),
         .pClearValues    = clear_values.data( ),
     };
-    ::vkCmdBeginRenderPass( command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
-    ::vkCmdBindPipeline( command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline );
 
-    auto const viewport = VkViewport{
-        .x        = 0.0F,
-        .y        = 0.0F,
-        .width    = static_cast< float32 >( output.framebuffer_size.width ),
-        .height   = static_cast< float32 >( output.framebuffer_size.height ),
-        .minDepth = 0.0F,
-        .maxDepth = 1.0F,
-    };
-    auto constexpr first_viewport = 0U;
-    auto constexpr viewport_count = 1U;
-    ::vkCmdSetViewport( command_buffer, first_viewport, viewport_count, &viewport );
+    // Composite layers are split between the recording threads, which each record
+    // their share into a secondary buffer. Others are recorded into the render pass.
+    auto const records_in_parallel = ( Pipeline::Composite == pipeline_type )
+                                  && ( nullptr != target.recording_threads )
+                                  && ( target.recording_threads->thread_count > 1U )
+                                  && ( layers.size( ) > 1U );
 
-    auto const scissors = VkRect2D{
-        .offset = VkOffset2D{ .x = 0, .y = 0 },
-        .extent = output.framebuffer_size,
-    };
-    auto constexpr first_scissor = 0U;
-    auto constexpr scissor_count = 1U;
-    ::vkCmdSetScissor( command_buffer, first_scissor, scissor_count, &scissors );
-
-    if constexpr ( Pipeline::Triangle == pipeline_type )
+    if ( records_in_parallel )
     {
-        ::vkCmdPushConstants(
+        ::vkCmdBeginRenderPass(
             command_buffer,
-            pipeline.pipeline_layout,
-            VK_SHADER_STAGE_VERTEX_BIT,
-            0,
-            sizeof( pipeline.model_uniforms ),
-            &pipeline.model_uniforms
+            &render_pass_info,
+            VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
         );
 
-        ::vkCmdPushConstants(
+        auto secondary_count = uint32{ 0 };
+        CHECK_TRUE( record_draws_in_parallel( secondary_count, pipeline, layers, output, target ) );
+        ::vkCmdExecuteCommands(
             command_buffer,
-            pipeline.pipeline_layout,
-            VK_SHADER_STAGE_FRAGMENT_BIT,
-            sizeof( pipeline.model_uniforms ),
-            sizeof( pipeline.display_uniforms ),
-            &pipeline.display_uniforms
+            secondary_count,
+            target.secondary_command_buffers.data( )
         );
     }
     else
     {
-        auto constexpr first_set            = 0U;
-        auto constexpr descriptor_set_count = 1U;
-        auto constexpr dynamic_offset_count = 0U;
-        auto constexpr dynamic_offsets      = nullptr;
-        ::vkCmdBindDescriptorSets(
+        ::vkCmdBeginRenderPass( command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
+        record_draws( command_buffer, pipeline, layers, output, target );
+    }
+
+    ::vkCmdEndRenderPass( command_buffer );
+
+    // The second timestamp is written once every draw has finished.
+    if ( nullptr != target.timestamp_queries )
+    {
+        ::vkCmdWriteTimestamp(
             command_buffer,
-            VK_PIPELINE_BIND_POINT_GRAPHICS,
-            pipeline.pipeline_layout,
-            first_set,
-            descriptor_set_count,
-            &pipeline.descriptor_sets[ sync.current_frame ],
-            dynamic_offset_count,
-            dynamic_offsets
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            target.timestamp_queries,
+            target.first_timestamp_query + 1U
         );
     }
 
-    auto constexpr vertex_count   = PipelineData< pipeline_type >::vertex_count;
-    auto constexpr instance_count = 1U;
-    auto constexpr first_vertex   = 0U;
-    auto constexpr first_instance = 0U;
-    ::vkCmdDraw( command_buffer, vertex_count, instance_count, first_vertex, first_instance );
-
-    ::vkCmdEndRenderPass( command_buffer );
+    // Hand ownership of the images to the consumers that wait on the signaled timeline.
+    if ( !release_barriers.empty( ) )
+    {
+        ::vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0U,
+            0U,
+            nullptr,
+            0U,
+            nullptr,
+            static_cast< uint32 >( release_barriers.size( ) ),
+            release_barriers.data( )
+        );
+    }
 
     CHECK_VK( ::vkEndCommandBuffer( command_buffer ) );
 
+    return true;
+}
+
+template < AppType setup_app_type, Pipeline pipeline_type, AppType output_app_type >
+auto render(
+    SetupData< setup_app_type > const&   setup,
+    PipelineData< pipeline_type > const& pipeline,
+    OutputData< output_app_type > const& output,
+    SyncData< output_app_type >&         sync
+) -> bool
+{
+    return render( setup, pipeline, ImageData< ExternalMemory::None >{ }, output, sync );
+}
+
+template <
+    AppType        setup_app_type,
+    Pipeline       pipeline_type,
+    ExternalMemory mem_type,
+    AppType        output_app_type >
+auto render(
+    SetupData< setup_app_type > const&   setup,
+    PipelineData< pipeline_type > const& pipeline,
+    ImageData< mem_type > const&         image,
+    OutputData< output_app_type > const& output,
+    SyncData< output_app_type >&         sync
+) -> bool
+{
+    auto layer = RenderLayer{
+        .image            = image.color_image,
+        .transfer         = OwnershipTransfer::None,
+        .descriptor_index = 0U,
+        .uniforms         = { },
+        .variant          = { },
+    };
+
+    // Imported images are only acquired on frames that wait on a new producer frame,
+    // and exported images are only released by renders that signal the consumer.
+    if constexpr ( ( ExternalMemory::Import == mem_type )
+                   && ( AppType::Windowed == output_app_type ) )
+    {
+        if ( !sync.wait_timelines.empty( ) )
+        {
+            layer.transfer = OwnershipTransfer::Acquire;
+        }
+    }
+    else if constexpr ( ( ExternalMemory::Export == mem_type )
+                        && ( AppType::Headless == output_app_type ) )
+    {
+        if ( nullptr != sync.signal_timeline )
+        {
+            layer.transfer = OwnershipTransfer::Release;
+        }
+    }
+
+    return render( setup, pipeline, std::span< RenderLayer const >{ &layer, 1U }, output, sync );
+}
+
+template < AppType setup_app_type, Pipeline pipeline_type, AppType output_app_type >
+auto render(
+    SetupData< setup_app_type > const&   setup,
+    PipelineData< pipeline_type > const& pipeline,
+    std::span< RenderLayer const > const layers,
+    OutputData< output_app_type > const& output,
+    SyncData< output_app_type >&         sync
+) -> bool
+{
+    auto* graphics_queue_fence  = VkFence{ };
+    auto* signal_timeline       = VkSemaphore{ };
+    auto  first_timestamp_query = uint32{ 0 };
+
     if constexpr ( AppType::Windowed == output_app_type )
     {
-        auto constexpr semaphore_stage
-            = VkPipelineStageFlags{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+        graphics_queue_fence  = sync.graphics_queue_fences[ sync.current_frame ];
+        first_timestamp_query = sync.current_frame * timestamp_queries_per_render;
+    }
+    else
+    {
+        graphics_queue_fence  = sync.graphics_queue_fence;
+        signal_timeline       = sync.signal_timeline;
+        first_timestamp_query = sync.first_timestamp_query;
+    }
+
+    auto const graphics_fences = std::array{ graphics_queue_fence };
+
+    // Headless renders into shared images reuse the command buffer once the timeline
+    // reaches the value it signaled last, so the fence isn't waited on or reset.
+    // The consumer's credit for the image is waited on at the same time.
+    auto const uses_reuse_timeline
+        = ( AppType::Headless == output_app_type ) && ( nullptr != signal_timeline );
+
+    if ( uses_reuse_timeline )
+    {
+        if constexpr ( AppType::Headless == output_app_type )
+        {
+            auto const timelines   = std::array{ sync.signal_timeline, sync.credit_timeline };
+            auto const values      = std::array{ sync.reuse_value, sync.credit_value };
+            auto const has_credits = ( nullptr != sync.credit_timeline );
+
+            auto const wait_info = VkSemaphoreWaitInfo{
+                .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .pNext          = nullptr,
+                .flags          = 0U,
+                .semaphoreCount = has_credits ? 2U : 1U,
+                .pSemaphores    = timelines.data( ),
+                .pValues        = values.data( ),
+            };
+            CHECK_VK( ::vkWaitSemaphores( setup.device, &wait_info, max_possible_timeout ) );
+        }
+    }
+    else
+    {
+        CHECK_VK( ::vkWaitForFences(
+            setup.device,
+            static_cast< uint32 >( graphics_fences.size( ) ),
+            graphics_fences.data( ),
+            VK_TRUE,
+            max_possible_timeout
+        ) );
+    }
+
+    auto  swapchain_image_index = uint32{ 0 };
+    auto* command_buffer        = VkCommandBuffer{ };
+    auto  target                = RenderTarget{
+        .framebuffer = { },
+        .render_area = VkRect2D{
+            .offset = VkOffset2D{ .x = 0, .y = 0 },
+            .extent = output.framebuffer_size,
+        },
+        .discarded_image       = { },
+        .frame_index           = 0U,
+        .timestamp_queries     = sync.timestamp_queries,
+        .first_timestamp_query = first_timestamp_query,
+    };
+
+    if constexpr ( AppType::Windowed == output_app_type )
+    {
+        CHECK_VK( ::vkAcquireNextImageKHR(
+            setup.device,
+            output.swapchain,
+            max_possible_timeout,
+            sync.image_available_semaphores[ sync.current_frame ],
+            nullptr,
+            &swapchain_image_index
+        ) );
+        target.framebuffer = output.framebuffers[ swapchain_image_index ];
+        target.frame_index = sync.current_frame;
+        command_buffer     = sync.command_buffers[ sync.current_frame ];
+
+        // The frame's last render has finished, so its pools are reset whole, along with
+        // every buffer allocated from them. Each recording thread has its own pool.
+        auto const thread_count = sync.recording_threads.thread_count;
+        auto const first_pool   = sync.current_frame * thread_count;
+        for ( auto pool = first_pool; pool < ( first_pool + thread_count ); ++pool )
+        {
+            auto constexpr reset_flags = VkCommandPoolResetFlags{ 0U };
+            CHECK_VK(
+                ::vkResetCommandPool( setup.device, sync.command_pools[ pool ], reset_flags )
+            );
+        }
+
+        auto const secondary_buffers     = std::span{ sync.secondary_command_buffers };
+        target.recording_threads         = &sync.recording_threads;
+        target.secondary_command_buffers = secondary_buffers.subspan( first_pool, thread_count );
+
+        // Every image collects this frame's damage, then the acquired image's is redrawn.
+        sync.image_damage.resize( output.swapchain_images.size( ) );
+        for ( auto& image_damage : sync.image_damage )
+        {
+            image_damage = ( image_damage && sync.damage )
+                             ? std::optional{ unite( image_damage.value( ), sync.damage.value( ) ) }
+                             : std::nullopt;
+        }
+
+        // Images drawn in full don't need their old contents. Otherwise the render area
+        // can't be empty, so a frame that changes nothing still draws a single pixel.
+        auto& image_damage = sync.image_damage[ swapchain_image_index ];
+        if ( image_damage )
+        {
+            target.render_area = clip( image_damage.value( ), output.framebuffer_size );
+            if ( is_empty( target.render_area ) )
+            {
+                target.render_area.extent = VkExtent2D{ .width = 1U, .height = 1U };
+            }
+        }
+        else
+        {
+            target.discarded_image = output.swapchain_images[ swapchain_image_index ];
+        }
+        image_damage = VkRect2D{ };
+    }
+    else
+    {
+        target.framebuffer = output.framebuffer;
+        target.frame_index = sync.frame_index;
+        command_buffer     = sync.command_buffer;
+    }
+
+    if ( !uses_reuse_timeline )
+    {
+        CHECK_VK( ::vkResetFences(
+            setup.device,
+            static_cast< uint32 >( graphics_fences.size( ) ),
+            graphics_fences.data( )
+        ) );
+    }
+
+    // The frame's last render has finished, so its uniforms can be replaced.
+    if constexpr ( Pipeline::Triangle == pipeline_type )
+    {
+        update_uniforms( pipeline, target.frame_index );
+    }
+
+    // Headless renders that reuse their commands only record them again when something
+    // other than the uniforms changes, which leaves a single submit for most frames.
+    if constexpr ( AppType::Headless == output_app_type )
+    {
+        auto recording = RecordedCommands{
+            .pipeline_layout       = pipeline.pipeline_layout,
+            .framebuffer           = target.framebuffer,
+            .frame_index           = target.frame_index,
+            .timestamp_queries     = target.timestamp_queries,
+            .first_timestamp_query = target.first_timestamp_query,
+            .layers                = { layers.begin( ), layers.end( ) },
+        };
+        if ( !sync.reuses_commands || ( sync.recording != recording ) )
+        {
+            sync.recording = std::nullopt;
+
+            auto constexpr reset_flags = VkCommandBufferResetFlags{ 0U };
+            CHECK_VK( ::vkResetCommandBuffer( command_buffer, reset_flags ) );
+            CHECK_TRUE( record_render( command_buffer, setup, pipeline, layers, output, target ) );
+            if ( sync.reuses_commands )
+            {
+                sync.recording = std::move( recording );
+            }
+        }
+    }
+    else
+    {
+        CHECK_TRUE( record_render( command_buffer, setup, pipeline, layers, output, target ) );
+    }
+
+    if constexpr ( AppType::Windowed == output_app_type )
+    {
+        // Timeline values are ignored for the binary semaphores. The color attachment
+        // stage must wait for the image acquisition to finish and the fragment stage
+        // must wait for every external image to be ready.
+        auto wait_semaphores = std::vector{ sync.image_available_semaphores[ sync.current_frame ] };
+        auto wait_values     = std::vector{ uint64{ 0 } };
+        auto wait_stages
+            = std::vector{ VkPipelineStageFlags{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT } };
+        wait_semaphores.insert(
+            wait_semaphores.end( ),
+            sync.wait_timelines.begin( ),
+            sync.wait_timelines.end( )
+        );
+        wait_values.insert(
+            wait_values.end( ),
+            sync.wait_values.begin( ),
+            sync.wait_values.end( )
+        );
+        wait_stages.resize( wait_semaphores.size( ), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+
+        auto signal_semaphores
+            = std::vector{ sync.render_finished_semaphores[ sync.current_frame ] };
+        auto signal_values = std::vector{ uint64{ 0 } };
+        signal_semaphores.insert(
+            signal_semaphores.end( ),
+            sync.signal_timelines.begin( ),
+            sync.signal_timelines.end( )
+        );
+        signal_values.insert(
+            signal_values.end( ),
+            sync.signal_values.begin( ),
+            sync.signal_values.end( )
+        );
+
+        auto const timeline_submit_info = VkTimelineSemaphoreSubmitInfo{
+            .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext                     = nullptr,
+            .waitSemaphoreValueCount   = static_cast< uint32 >( wait_values.size( ) ),
+            .pWaitSemaphoreValues      = wait_values.data( ),
+            .signalSemaphoreValueCount = static_cast< uint32 >( signal_values.size( ) ),
+            .pSignalSemaphoreValues    = signal_values.data( ),
+        };
 
         auto const submit_info = VkSubmitInfo{
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext = nullptr,
-            // Color attachment stage must wait for the image acquisition to finish.
-            .waitSemaphoreCount = 1U,
-            .pWaitSemaphores    = &sync.image_available_semaphores[ sync.current_frame ],
-            .pWaitDstStageMask  = &semaphore_stage,
+            .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext              = &timeline_submit_info,
+            .waitSemaphoreCount = static_cast< uint32 >( wait_semaphores.size( ) ),
+            .pWaitSemaphores    = wait_semaphores.data( ),
+            .pWaitDstStageMask  = wait_stages.data( ),
             // The commands being submitted to the graphics device.
             .commandBufferCount = 1U,
             .pCommandBuffers    = &command_buffer,
-            // Signal the render finished semaphore so future
-            // commands waiting on this step can proceed.
-            .signalSemaphoreCount = 1U,
-            .pSignalSemaphores    = &sync.render_finished_semaphores[ sync.current_frame ],
+            // Signal the render finished semaphore so future commands waiting on this
+            // step can proceed, and let other processes know their images were released.
+            .signalSemaphoreCount = static_cast< uint32 >( signal_semaphores.size( ) ),
+            .pSignalSemaphores    = signal_semaphores.data( ),
         };
 
         // Use the fence to block future CPU code that also references this fence.
@@ -267,23 +725,35 @@ auto render(
     }
     else
     {
+        // Signal the shared timeline (if any) so another process can wait on the frame.
+        auto const signal_semaphore_count = ( nullptr == signal_timeline ) ? 0U : 1U;
+
+        auto const timeline_submit_info = VkTimelineSemaphoreSubmitInfo{
+            .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .pNext                     = nullptr,
+            .waitSemaphoreValueCount   = 0U,
+            .pWaitSemaphoreValues      = nullptr,
+            .signalSemaphoreValueCount = signal_semaphore_count,
+            .pSignalSemaphoreValues    = &sync.signal_value,
+        };
+
         auto const submit_info = VkSubmitInfo{
             .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext                = nullptr,
+            .pNext                = &timeline_submit_info,
             .waitSemaphoreCount   = 0,
             .pWaitSemaphores      = nullptr,
             .pWaitDstStageMask    = nullptr,
             .commandBufferCount   = 1,
             .pCommandBuffers      = &command_buffer,
-            .signalSemaphoreCount = 0,
-            .pSignalSemaphores    = nullptr,
+            .signalSemaphoreCount = signal_semaphore_count,
+            .pSignalSemaphores    = &signal_timeline,
         };
         auto constexpr submit_count = 1;
         CHECK_VK( ::vkQueueSubmit(
             setup.graphics_queue,
             submit_count,
             &submit_info,
-            graphics_queue_fence
+            uses_reuse_timeline ? nullptr : graphics_queue_fence
         ) );
     }
 
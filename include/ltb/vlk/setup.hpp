@@ -4,14 +4,27 @@
 #pragma once
 
 // project
-#include "ltb/vlk/vlk.hpp"
+#include "ltb/vlk/allocator.hpp"
 
 // standard
 #include <array>
+#include <filesystem>
+#include <memory>
+#include <optional>
 
 namespace ltb::vlk
 {
 
+/// \brief Identifies a physical device across processes and APIs. Memory and semaphores
+///        can only be shared between devices whose device and driver UUIDs both match.
+struct DeviceId
+{
+    std::array< uint8, VK_UUID_SIZE > device_uuid = { };
+    std::array< uint8, VK_UUID_SIZE > driver_uuid = { };
+
+    auto operator==( DeviceId const& ) const -> bool = default;
+};
+
 template < AppType app_type >
 struct SetupData;
 
@@ -28,6 +41,7 @@ struct SetupData< AppType::Windowed >
     VkDebugUtilsMessengerEXT            debug_messenger                 = { };
     VkSurfaceKHR                        surface                         = { };
     VkPhysicalDevice                    physical_device                 = { };
+    DeviceId                            device_id                       = { };
     uint32                              graphics_queue_family_index     = { };
     uint32                              surface_queue_family_index      = { };
     VkDevice                            device                          = { };
@@ -35,6 +49,15 @@ struct SetupData< AppType::Windowed >
     VkQueue                             surface_queue                   = { };
     VkCommandPool                       graphics_command_pool           = { };
     VkSurfaceFormatKHR                  surface_format                  = { };
+    bool                                supports_dma_buf                = false;
+    bool                                supports_calibrated_timestamps  = false;
+
+    // Compiled pipelines, saved when the setup is destroyed and loaded by the next run.
+    VkPipelineCache       pipeline_cache      = { };
+    std::filesystem::path pipeline_cache_path = { };
+
+    // Shared by everything created from the setup, so it's allocated from through a const setup.
+    std::unique_ptr< AllocatorData > allocator = { };
 };
 
 template <>
@@ -48,16 +71,40 @@ struct SetupData< AppType::Headless >
     PFN_vkDestroyDebugUtilsMessengerEXT vkDestroyDebugUtilsMessengerEXT = nullptr;
     VkDebugUtilsMessengerEXT            debug_messenger                 = { };
     VkPhysicalDevice                    physical_device                 = { };
+    DeviceId                            device_id                       = { };
     uint32                              graphics_queue_family_index     = { };
     VkDevice                            device                          = { };
     VkQueue                             graphics_queue                  = { };
     VkCommandPool                       graphics_command_pool           = { };
     VkFormat                            color_format                    = { };
+    bool                                supports_dma_buf                = false;
+    bool                                supports_calibrated_timestamps  = false;
+
+    // Compiled pipelines, saved when the setup is destroyed and loaded by the next run.
+    VkPipelineCache       pipeline_cache      = { };
+    std::filesystem::path pipeline_cache_path = { };
+
+    // Shared by everything created from the setup, so it's allocated from through a const setup.
+    std::unique_ptr< AllocatorData > allocator = { };
 };
 
 /// \brief Initialize all the fields of a SetupData struct.
+///
+/// \param physical_device_index the device used if no device matches the matching id.
+/// \param matching_device_id the device of another process to share memory with, if any.
 template < AppType app_type >
-auto initialize( SetupData< app_type >& setup, uint32 physical_device_index ) -> bool;
+auto initialize(
+    SetupData< app_type >&           setup,
+    uint32                           physical_device_index,
+    std::optional< DeviceId > const& matching_device_id
+) -> bool;
+
+/// \brief A wrapper function around the main initialize function.
+template < AppType app_type >
+auto initialize( SetupData< app_type >& setup, uint32 const physical_device_index ) -> bool
+{
+    return initialize( setup, physical_device_index, std::nullopt );
+}
 
 /// \brief Destroy all the fields of a SetupData struct.
 template < AppType app_type >
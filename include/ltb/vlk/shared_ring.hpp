@@ -0,0 +1,398 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/net/shared_memory.hpp"
+#include "ltb/net/spsc_ring.hpp"
+#include "ltb/vlk/damage.hpp"
+#include "ltb/vlk/image.hpp"
+#include "ltb/vlk/import_cache.hpp"
+#include "ltb/vlk/synchronization.hpp"
+
+// standard
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace ltb::vlk
+{
+
+auto constexpr max_shared_ring_slots = 8U;
+auto constexpr frame_record_capacity = 64U;
+
+/// \brief Everything the producer knows about a frame, published before the frame is submitted.
+///
+/// `ready_value` is what the ready timeline reaches once the frame is rendered, and
+/// `cpu_timestamp_ns` is the producer's steady clock when the frame was submitted.
+/// No damage rects means the whole frame changed.
+struct FrameRecord
+{
+    uint64                                     frame_id         = 0U;
+    uint64                                     ready_value      = 0U;
+    int64                                      cpu_timestamp_ns = 0;
+    uint32                                     slot             = 0U;
+    uint32                                     damage_count     = 0U;
+    std::array< DamageRect, max_damage_rects > damage           = { };
+};
+
+/// \brief When the producer's GPU started and finished rendering a frame, published
+///        once the frame's timestamps are available. Times are on the steady clock.
+struct FrameTiming
+{
+    uint64 frame_id        = 0U;
+    int64  render_start_ns = 0;
+    int64  render_end_ns   = 0;
+};
+
+/// \brief How the consumer of a ring takes the producer's frames.
+enum class RingMode : uint32
+{
+    Fifo,    // Every frame is displayed, and the producer waits for slots to be released.
+    Mailbox, // The newest finished frame is displayed, and the producer never waits.
+};
+
+/// \brief The block of shared memory describing a ring.
+///
+/// The producer signals the "ready" timeline with N + 1 once frame N is rendered.
+/// Per-frame metadata travels alongside in a lock-free queue of frame records, and
+/// the GPU timings of rendered frames follow in a second queue when they're traced.
+///
+/// In FIFO rings, frame N is rendered into slot N % slot_count and the consumer signals
+/// the "released" timeline with N once it no longer samples any frame before N.
+///
+/// In mailbox rings, the producer renders into any slot the consumer doesn't hold and
+/// stores the frame's ready value in `slot_ready_values` before rendering. The consumer
+/// sets a slot's bit in `consumer_slots` before sampling it and clears it once its frames
+/// in flight are done with it. Both sides check the other's word after writing their own,
+/// so a slot is never sampled and rendered at the same time.
+struct SharedRingControl
+{
+    uint32   slot_count = 0U;
+    RingMode mode       = RingMode::Fifo;
+
+    std::array< std::atomic< uint64 >, max_shared_ring_slots > slot_ready_values = { };
+    std::atomic< uint32 >                                      consumer_slots    = { };
+
+    net::SpscRing< FrameRecord, frame_record_capacity > frames  = { };
+    net::SpscRing< FrameTiming, frame_record_capacity > timings = { };
+};
+
+auto constexpr shared_ring_message_magic   = uint32{ 0x4C54'4252 }; // "LTBR"
+auto constexpr shared_ring_message_version = uint32{ 6 };
+
+/// \brief The header sent along with every file descriptor of a ring so the
+///        whole ring is handed over in a single message.
+///
+/// The file descriptors are sent in the order the consumer imports them: the control
+/// block, the ready timeline, the released timeline, then the images. Pooled images
+/// share a single allocation and so a single file descriptor, otherwise there is one
+/// per image slot.
+struct SharedRingMessage
+{
+    uint32 magic      = shared_ring_message_magic;
+    uint32 version    = shared_ring_message_version;
+    uint32 slot_count = 0U;
+    uint32 fd_count   = 0U;
+    uint64 generation = 0U;
+    uint32 pooled     = 0U; // bool
+    uint32 reserved   = 0U;
+
+    std::array< ExternalImageDescription, max_shared_ring_slots > images = { };
+};
+
+static_assert( std::is_trivially_copyable_v< SharedRingMessage > );
+static_assert( std::is_standard_layout_v< SharedRingMessage > );
+static_assert(
+    ( 32U + ( max_shared_ring_slots * sizeof( ExternalImageDescription ) ) )
+        == sizeof( SharedRingMessage ),
+    "The layout must not change without bumping the version"
+);
+
+/// \brief The control block and timelines come before the images in a ring message.
+auto constexpr shared_ring_message_image_fd_offset = 3U;
+
+/// \brief How far a producer ran ahead of its consumer since the last report. The depth
+///        is the number of frames handed to the ring that the consumer hasn't released.
+struct QueueDepthStats
+{
+    uint64                                sample_count = 0U;
+    uint64                                depth_sum    = 0U;
+    uint64                                max_depth    = 0U;
+    uint64                                stall_count  = 0U;
+    std::chrono::steady_clock::duration   stall_time   = { };
+    std::chrono::steady_clock::time_point report_time  = { };
+};
+
+template < ExternalMemory mem_type >
+struct SharedRingData;
+
+template <>
+struct SharedRingData< ExternalMemory::Export >
+{
+    std::vector< ImageData< ExternalMemory::Export > > images            = { };
+    ImagePoolData< ExternalMemory::Export >            image_pool        = { };
+    net::SharedMemory                                  memory            = { };
+    SharedRingControl*                                 control           = nullptr;
+    VkSemaphore                                        ready_timeline    = { };
+    VkSemaphore                                        released_timeline = { };
+    uint64                                             generation        = 0U;
+    uint64                                             next_frame_id     = 0U;
+    std::optional< uint32 >                            newest_slot       = { };
+    QueueDepthStats                                    stats             = { };
+};
+
+template <>
+struct SharedRingData< ExternalMemory::Import >
+{
+    std::vector< ImageData< ExternalMemory::Import > > images            = { };
+    ImagePoolData< ExternalMemory::Import >            image_pool        = { };
+    net::SharedMemory                                  memory            = { };
+    SharedRingControl*                                 control           = nullptr;
+    VkSemaphore                                        ready_timeline    = { };
+    VkSemaphore                                        released_timeline = { };
+    uint64                                             generation        = 0U;
+    uint64                                             next_frame_id     = 0U;
+    std::optional< uint64 >                            latched_frame_id  = { };
+    std::optional< uint32 >                            latched_slot      = { };
+    std::optional< FrameRecord >                       latched_record    = { };
+
+    // Set when the images are owned by an import cache, which the ring releases them to.
+    ImportCacheData* image_cache = nullptr;
+    uint32           producer_id = 0U;
+
+    // The slot sampled by each frame in flight. Only used by mailbox rings.
+    std::vector< std::optional< uint32 > > frame_slots = { };
+
+    // Frames the producer finished that were never displayed, and frames that were.
+    uint64 dropped_frame_count = 0U;
+    uint64 latched_frame_count = 0U;
+
+    // Finished frames still waiting to be displayed after the last latch.
+    uint64 queue_depth = 0U;
+
+    // The most recent timings published by the producer, oldest first.
+    std::deque< FrameTiming > frame_timings = { };
+};
+
+/// \brief Create the exported images and the shared control block of a producer ring.
+auto initialize(
+    SharedRingData< ExternalMemory::Export >& ring,
+    AllocatorData&                            allocator,
+    VkDevice const&                           device,
+    VkExtent3D                                image_extents,
+    VkFormat                                  color_format,
+    ExternalHandle                            handle_type,
+    RingMode                                  mode,
+    uint32                                    slot_count
+) -> bool;
+
+/// \brief A wrapper function around the main initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    SharedRingData< ExternalMemory::Export >& ring,
+    SetupData< setup_app_type > const&        setup,
+    VkExtent3D                                image_extents,
+    ExternalHandle                            handle_type,
+    RingMode                                  mode,
+    uint32                                    slot_count
+) -> bool
+{
+    auto color_format = VkFormat{ };
+    if constexpr ( setup_app_type == AppType::Windowed )
+    {
+        color_format = setup.surface_format.format;
+    }
+    else
+    {
+        color_format = setup.color_format;
+    }
+    return initialize(
+        ring,
+        *setup.allocator,
+        setup.device,
+        image_extents,
+        color_format,
+        handle_type,
+        mode,
+        slot_count
+    );
+}
+
+/// \brief Map the control block and import the timelines and images of a producer ring,
+///        as described by the message the file descriptors were received with.
+///        The file descriptors are owned by the ring once this is called, even on failure.
+auto initialize(
+    SharedRingData< ExternalMemory::Import >& ring,
+    AllocatorData&                            allocator,
+    VkInstance const&                         instance,
+    VkDevice const&                           device,
+    SharedRingMessage const&                  message,
+    std::span< int32 const >                  file_descriptors
+) -> bool;
+
+/// \brief A wrapper function around the main initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    SharedRingData< ExternalMemory::Import >& ring,
+    SetupData< setup_app_type > const&        setup,
+    SharedRingMessage const&                  message,
+    std::span< int32 const >                  file_descriptors
+) -> bool
+{
+    return initialize(
+        ring,
+        *setup.allocator,
+        setup.instance,
+        setup.device,
+        message,
+        file_descriptors
+    );
+}
+
+/// \brief Import a producer ring like the main initialize function, but reuse the images
+///        of the producer's allocation generation if they're already in the cache. New
+///        imports are added to the cache, and the ring releases its images to it when
+///        destroyed. The cache must outlive the ring.
+auto initialize(
+    SharedRingData< ExternalMemory::Import >& ring,
+    AllocatorData&                            allocator,
+    VkInstance const&                         instance,
+    VkDevice const&                           device,
+    SharedRingMessage const&                  message,
+    std::span< int32 const >                  file_descriptors,
+    ImportCacheData&                          cache,
+    uint32                                    producer_id
+) -> bool;
+
+/// \brief A wrapper function around the cached initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    SharedRingData< ExternalMemory::Import >& ring,
+    SetupData< setup_app_type > const&        setup,
+    SharedRingMessage const&                  message,
+    std::span< int32 const >                  file_descriptors,
+    ImportCacheData&                          cache,
+    uint32                                    producer_id
+) -> bool
+{
+    return initialize(
+        ring,
+        *setup.allocator,
+        setup.instance,
+        setup.device,
+        message,
+        file_descriptors,
+        cache,
+        producer_id
+    );
+}
+
+/// \brief Describe a producer ring and export its file descriptors, in the
+///        order listed by the message. The caller owns the file descriptors.
+auto get_message(
+    SharedRingMessage&                              message,
+    std::vector< int32 >&                           file_descriptors,
+    VkInstance const&                               instance,
+    VkDevice const&                                 device,
+    SharedRingData< ExternalMemory::Export > const& ring
+) -> bool;
+
+/// \brief A wrapper function around the main get_message function.
+template < AppType setup_app_type >
+auto get_message(
+    SharedRingMessage&                              message,
+    std::vector< int32 >&                           file_descriptors,
+    SetupData< setup_app_type > const&              setup,
+    SharedRingData< ExternalMemory::Export > const& ring
+) -> bool
+{
+    return get_message( message, file_descriptors, setup.instance, setup.device, ring );
+}
+
+/// \brief Wait for at most `timeout` until the consumer grants a credit for the next frame.
+///
+/// FIFO rings start with one credit per slot, and the consumer grants one back every time
+/// it releases a frame by signaling the released timeline. Mailbox rings never wait.
+///
+/// \param has_credit set to false if the consumer still hasn't granted one.
+auto wait_for_credit(
+    SharedRingData< ExternalMemory::Export >& ring,
+    VkDevice const&                           device,
+    std::chrono::nanoseconds                  timeout,
+    bool&                                     has_credit
+) -> bool;
+
+/// \brief Claim the slot of the next frame. FIFO rings always hand out the next slot, and
+///        the frame's render must wait for the credit value on the released timeline.
+///        Mailbox rings return false without blocking if the consumer holds every slot
+///        but the newest frame's.
+///
+/// \param ready_value the value to signal on the ready timeline once the frame is rendered.
+/// \param credit_value the released value the consumer must reach before the slot is reused.
+auto acquire_render_slot(
+    SharedRingData< ExternalMemory::Export >& ring,
+    uint32&                                   slot,
+    uint64&                                   ready_value,
+    uint64&                                   credit_value
+) -> bool;
+
+/// \brief Publish the metadata of a frame to the consumer. Must be called before the
+///        frame is submitted so the record is visible by the time the frame is ready.
+///
+/// \returns false without blocking if the consumer has fallen too far behind to take it.
+auto publish_frame( SharedRingData< ExternalMemory::Export >& ring, FrameRecord const& record )
+    -> bool;
+
+/// \brief Add a changed region to a frame's record. A record without damage rects stands
+///        for the whole frame, so the first rect narrows it down. Rects past the last one
+///        that fits are merged into it, so the damage only ever grows.
+auto add_damage( FrameRecord& record, VkRect2D const& rect ) -> void;
+
+/// \brief Add the damage of a skipped frame to the record of the frame that replaces it.
+auto merge_damage( FrameRecord& record, FrameRecord const& skipped_record ) -> void;
+
+/// \brief Publish the GPU timing of a rendered frame to the consumer.
+///
+/// \returns false without blocking if the consumer isn't reading timings fast enough.
+auto publish_timing( SharedRingData< ExternalMemory::Export >& ring, FrameTiming const& timing )
+    -> bool;
+
+/// \brief Find the GPU timing the producer published for a frame. Timings arrive a few
+///        frames late, so the most recent ones are kept until they're looked up.
+auto find_frame_timing( SharedRingData< ExternalMemory::Import >& ring, uint64 frame_id )
+    -> std::optional< FrameTiming >;
+
+/// \brief Latch the next frame the producer has finished rendering, if any. Mailbox
+///        rings latch the newest finished frame instead and count the skipped ones as
+///        dropped. Must be called once per frame after the frame's fence was waited on.
+///        The ring's timelines are appended to the sync so the next submit waits on
+///        the frame and releases the frames before it. Nothing is appended if nothing
+///        new was latched, and the caller clears the sync's lists before every frame.
+///        The frame's record, if it was published, becomes the latched record, along
+///        with the damage of any frames skipped since the last latch.
+///
+/// \returns the slot to sample from, or nothing if no frame has arrived yet.
+auto latch_ready_slot(
+    SharedRingData< ExternalMemory::Import >& ring,
+    VkDevice const&                           device,
+    SyncData< AppType::Windowed >&            sync
+) -> std::optional< uint32 >;
+
+/// \brief Destroy all the fields of a SharedRingData struct.
+template < ExternalMemory mem_type >
+auto destroy( SharedRingData< mem_type >& ring, VkDevice const& device ) -> void;
+
+/// \brief A wrapper function around the main destroy function.
+template < ExternalMemory mem_type, AppType setup_app_type >
+auto destroy( SharedRingData< mem_type >& ring, SetupData< setup_app_type > const& setup ) -> void
+{
+    return destroy( ring, setup.device );
+}
+
+} // namespace ltb::vlk
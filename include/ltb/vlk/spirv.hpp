@@ -0,0 +1,32 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/utils/types.hpp"
+
+// standard
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace ltb::vlk
+{
+
+/// \brief Shaders are read from `<dir>/<name>.spv` instead when this is set to a directory.
+auto constexpr spirv_shader_dir_variable = "LTB_VLK_SHADER_DIR";
+
+/// \brief Get the SPIR-V of a shader, e.g. "triangle.vert". Every shader is compiled into
+///        the library, so nothing is read from disk unless `spirv_shader_dir_variable`
+///        overrides them, which lets shaders be iterated on without a rebuild.
+///
+/// \param override_code holds the shader when it's read from disk. `spirv` points into it,
+///                      so it must outlive any use of `spirv`.
+auto get_spirv(
+    std::span< uint32 const >& spirv,
+    std::vector< uint32 >&     override_code,
+    std::string_view           shader_name
+) -> bool;
+
+} // namespace ltb::vlk
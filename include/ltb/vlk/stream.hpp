@@ -0,0 +1,150 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/net/tcp_stream.hpp"
+#include "ltb/vlk/host_ring.hpp"
+#include "ltb/vlk/layer.hpp"
+
+// standard
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace ltb::vlk
+{
+
+/// \brief The port consumers listen on for streamed frames.
+auto constexpr default_stream_port = uint16{ 47'800 };
+
+auto constexpr stream_frame_magic   = uint32{ 0x4C54'4246 }; // "LTBF"
+auto constexpr stream_frame_version = uint32{ 1 };
+
+/// \brief Sent ahead of every streamed frame, followed by `encoded_size` bytes of frame delta.
+///
+/// A stream starts with the producer's LayerMessage. Every frame after it is encoded as
+/// the changes since the frame before it, so a connection's frames must all be decoded.
+struct StreamFrameHeader
+{
+    uint32      magic        = stream_frame_magic;
+    uint32      version      = stream_frame_version;
+    uint32      format       = 0U; // VkFormat
+    uint32      width        = 0U;
+    uint32      height       = 0U;
+    uint32      reserved     = 0U;
+    uint64      row_pitch    = 0U;
+    uint64      encoded_size = 0U;
+    FrameRecord record       = { };
+};
+
+static_assert( std::is_trivially_copyable_v< StreamFrameHeader > );
+static_assert( std::is_standard_layout_v< StreamFrameHeader > );
+
+/// \brief How much has been streamed since the last report.
+struct StreamStats
+{
+    uint64                                frame_count   = 0U;
+    uint64                                raw_bytes     = 0U;
+    uint64                                encoded_bytes = 0U;
+    std::chrono::steady_clock::time_point report_time   = { };
+};
+
+/// \brief A frame encoded by the producer's encoding thread, waiting to be sent.
+struct EncodedFrame
+{
+    StreamFrameHeader        header = { };
+    std::vector< std::byte > bytes  = { };
+};
+
+template < ExternalMemory mem_type >
+struct StreamData;
+
+/// \brief Streams the frames published to a host ring to a consumer on another machine.
+///
+/// The host ring already reads frames back asynchronously. One thread takes the published
+/// frames, encodes them, and releases their slots, while a second thread sends the encoded
+/// frames, so reading back, encoding, and sending consecutive frames all overlap.
+template <>
+struct StreamData< ExternalMemory::Export >
+{
+    net::TcpStream   socket    = { };
+    HostRingControl* control   = nullptr;
+    std::byte const* pixels    = nullptr;
+    uint64           slot_size = 0U;
+
+    StreamFrameHeader frame_header = { };
+
+    // Encoded frames move from the encoding thread to the sending thread, and their
+    // buffers move back to be reused.
+    std::mutex                              mutex          = { };
+    std::condition_variable_any             queue_changed  = { };
+    std::deque< EncodedFrame >              encoded_frames = { };
+    std::vector< std::vector< std::byte > > free_buffers   = { };
+
+    std::atomic< bool > failed = false;
+    StreamStats         stats  = { };
+
+    std::jthread encoder = { };
+    std::jthread sender  = { };
+};
+
+/// \brief Receives streamed frames on a thread and writes them into a local host ring,
+///        which the consumer imports like any other host ring. A new ring is made for
+///        every connection, so producers can restart with a different frame size.
+template <>
+struct StreamData< ExternalMemory::Import >
+{
+    net::TcpListener listener = { };
+    net::TcpStream   socket   = { };
+
+    // The ring of the newest connection, until the consumer takes it.
+    std::mutex                       mutex        = { };
+    std::optional< LayerMessage >    layer        = { };
+    std::optional< HostRingMessage > ring_message = { };
+    int32                            ring_fd      = -1;
+
+    std::jthread receiver = { };
+};
+
+/// \brief Connect to a consumer and start streaming the frames published to a host ring.
+auto initialize(
+    StreamData< ExternalMemory::Export >&         stream,
+    HostRingData< ExternalMemory::Export > const& ring,
+    LayerMessage const&                           layer,
+    std::string_view                              address,
+    uint16                                        port
+) -> bool;
+
+/// \brief Listen for a streaming producer and start receiving its frames.
+auto initialize(
+    StreamData< ExternalMemory::Import >& stream,
+    std::string_view                      address,
+    uint16                                port
+) -> bool;
+
+/// \brief Check whether a producer's stream has stopped because of an error.
+auto has_failed( StreamData< ExternalMemory::Export > const& stream ) -> bool;
+
+/// \brief Take the host ring of a newly connected producer, if any.
+///
+/// \param memory_fd owned by the caller once this returns true.
+/// \returns true if a new producer connected since the last call.
+auto take_ring(
+    StreamData< ExternalMemory::Import >& stream,
+    LayerMessage&                         layer,
+    HostRingMessage&                      message,
+    int32&                                memory_fd
+) -> bool;
+
+/// \brief Stop the stream's threads and close its connection.
+template < ExternalMemory mem_type >
+auto destroy( StreamData< mem_type >& stream ) -> void;
+
+} // namespace ltb::vlk
@@ -4,14 +4,30 @@
 #pragma once
 
 // project
-#include "ltb/vlk/setup.hpp"
+#include "ltb/vlk/pipeline.hpp"
+#include "ltb/vlk/recording.hpp"
 
 // standard
+#include <optional>
 #include <vector>
 
 namespace ltb::vlk
 {
 
+/// \brief What a command buffer was recorded with. Its commands are the same for as long as
+///        these are, since per-frame uniforms are read from a buffer instead.
+struct RecordedCommands
+{
+    VkPipelineLayout           pipeline_layout       = { }; // Identifies the pipeline.
+    VkFramebuffer              framebuffer           = { };
+    uint32                     frame_index           = 0U;
+    VkQueryPool                timestamp_queries     = { };
+    uint32                     first_timestamp_query = 0U;
+    std::vector< RenderLayer > layers                = { };
+
+    auto operator==( RecordedCommands const& ) const -> bool = default;
+};
+
 template < AppType app_type >
 struct SyncData;
 
@@ -23,6 +39,33 @@ struct SyncData< AppType::Windowed >
     std::vector< VkSemaphore >     render_finished_semaphores = { };
     std::vector< VkFence >         graphics_queue_fences      = { };
     uint32                         current_frame              = 0U;
+
+    // Timeline semaphores shared with other processes. The next submit waits for each
+    // wait timeline to reach its value before sampling external images, and signals
+    // each signal timeline with its value once it's done. Both lists may be empty.
+    std::vector< VkSemaphore > wait_timelines   = { };
+    std::vector< uint64 >      wait_values      = { };
+    std::vector< VkSemaphore > signal_timelines = { };
+    std::vector< uint64 >      signal_values    = { };
+
+    // Timestamps written around the render pass of each frame in flight, when set.
+    // The current frame writes the two queries starting at twice its index.
+    VkQueryPool timestamp_queries = { };
+
+    // The region of the output the next frame changes, or nothing if it may change all of
+    // it. Swapchain images are handed out in any order, so each image collects the damage
+    // of every frame since it was last rendered and only that region is drawn again.
+    // Images that were never rendered have no region and are drawn in full.
+    std::optional< VkRect2D >                damage       = { };
+    std::vector< std::optional< VkRect2D > > image_damage = { };
+
+    // One command pool per recording thread per frame in flight, grouped by frame. A frame's
+    // pools are reset together once its fence is signaled, which resets every buffer in them.
+    // Each frame's primary command buffer comes from its first pool, and each pool has one
+    // secondary command buffer its thread records layers into.
+    std::vector< VkCommandPool >   command_pools             = { };
+    std::vector< VkCommandBuffer > secondary_command_buffers = { };
+    RecordingThreadsData           recording_threads         = { };
 };
 
 template <>
@@ -30,14 +73,43 @@ struct SyncData< AppType::Headless >
 {
     VkCommandBuffer command_buffer       = { };
     VkFence         graphics_queue_fence = { };
+
+    // A timeline semaphore shared with another process. When set, the next submit signals
+    // the signal value, and the command buffer is reused once the timeline reaches the
+    // reuse value (the value it signaled last) instead of waiting on and resetting the fence.
+    VkSemaphore signal_timeline = { };
+    uint64      signal_value    = 0U;
+    uint64      reuse_value     = 0U;
+
+    // A timeline semaphore the consumer of the render grants credits on. When set along
+    // with the signal timeline, the command buffer is also only reused once the credit
+    // timeline reaches the credit value, so the producer stalls only when it's behind.
+    VkSemaphore credit_timeline = { };
+    uint64      credit_value    = 0U;
+
+    // Timestamps written around the render pass, when set, starting at the first query.
+    VkQueryPool timestamp_queries     = { };
+    uint32      first_timestamp_query = 0U;
+
+    // The pipeline's frame in flight the render uses, which picks its uniforms and
+    // descriptor sets. Syncs that render at the same time must use different frames.
+    uint32 frame_index = 0U;
+
+    // When set, the command buffer is recorded once and submitted again by every render
+    // until what it was recorded with changes. Anything the recorded commands use must
+    // outlive the sync, or the recording must be cleared when it's destroyed.
+    bool                              reuses_commands = false;
+    std::optional< RecordedCommands > recording       = { };
 };
 
-/// \brief Initialize all the fields of a windowed SyncData struct.
+/// \brief Initialize all the fields of a windowed SyncData struct. Composite renders
+///        record their layers on `recording_thread_count` threads.
 auto initialize(
     SyncData< AppType::Windowed >& sync,
     VkDevice const&                device,
-    VkCommandPool const&           command_pool,
-    uint32                         max_frames_in_flight
+    uint32                         graphics_queue_family_index,
+    uint32                         max_frames_in_flight,
+    uint32                         recording_thread_count
 ) -> bool;
 
 /// \brief Initialize all the fields of a headless SyncData struct.
@@ -51,7 +123,8 @@ auto initialize(
 auto initialize(
     SyncData< AppType::Windowed >&        sync,
     SetupData< AppType::Windowed > const& setup,
-    uint32                                max_frames_in_flight
+    uint32                                max_frames_in_flight,
+    uint32                                recording_thread_count
 ) -> bool;
 
 /// \brief A wrapper function around the main initialize function.
@@ -62,7 +135,39 @@ auto initialize( SyncData< AppType::Headless >& sync, SetupData< setup_app_type
     return initialize( sync, setup.device, setup.graphics_command_pool );
 }
 
-/// \brief Destroy all the fields of an SyncData struct.
+/// \brief Create a timeline semaphore starting at zero. Use ExternalMemory::Export
+///        to create a semaphore that can be shared with another process.
+auto initialize_timeline(
+    VkSemaphore&    timeline,
+    VkDevice const& device,
+    ExternalMemory  semaphore_type
+) -> bool;
+
+/// \brief Import a timeline semaphore exported by another process.
+auto import_timeline(
+    VkSemaphore&      timeline,
+    VkInstance const& instance,
+    VkDevice const&   device,
+    int32             import_timeline_fd
+) -> bool;
+
+/// \brief Export a semaphore created with ExternalMemory::Export.
+auto get_file_descriptor(
+    int32&             file_descriptor,
+    VkInstance const&  instance,
+    VkDevice const&    device,
+    VkSemaphore const& semaphore
+) -> bool;
+
+/// \brief Read the current value of a timeline semaphore without blocking.
+auto get_timeline_value( uint64& value, VkDevice const& device, VkSemaphore const& timeline )
+    -> bool;
+
+/// \brief Destroy a semaphore created by initialize_timeline or import_timeline.
+auto destroy_timeline( VkSemaphore& timeline, VkDevice const& device ) -> void;
+
+/// \brief Destroy all the fields of an SyncData struct. Windowed syncs free their
+///        command buffers with their own pools, so `graphics_command_pool` isn't used.
 template < AppType app_type >
 auto destroy(
     SyncData< app_type >& sync,
@@ -0,0 +1,104 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#pragma once
+
+// project
+#include "ltb/vlk/setup.hpp"
+
+// standard
+#include <chrono>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ltb::vlk
+{
+
+/// \brief Renders write one timestamp before and one after their render pass.
+auto constexpr timestamp_queries_per_render = 2U;
+
+/// \brief A pool of GPU timestamp queries and what's needed to convert
+///        their results to the CPU's steady clock.
+///
+/// Converted timestamps are in the same clock as `std::chrono::steady_clock`,
+/// so they can be compared with timestamps taken by other processes.
+struct TimestampData
+{
+    VkQueryPool query_pool  = { };
+    uint32      query_count = 0U;
+    float64     ns_per_tick = 0.0;
+    uint64      valid_mask  = 0U;
+
+    PFN_vkGetCalibratedTimestampsEXT vkGetCalibratedTimestampsEXT = nullptr;
+
+    // A GPU tick and a steady clock time sampled at the same moment.
+    uint64                                calibration_ticks = 0U;
+    int64                                 calibration_ns    = 0;
+    std::chrono::steady_clock::time_point calibration_time  = { };
+};
+
+/// \brief Latency samples, logged as percentiles every few seconds.
+struct LatencyHistogram
+{
+    std::string                           name        = { };
+    std::vector< int64 >                  samples_ns  = { };
+    std::chrono::steady_clock::time_point report_time = { };
+};
+
+/// \brief Create the query pool of a TimestampData struct. If the device can't calibrate
+///        its timestamps against the CPU's clock, no pool is created and tracing is off.
+auto initialize(
+    TimestampData&          timestamps,
+    VkInstance const&       instance,
+    VkPhysicalDevice const& physical_device,
+    VkDevice const&         device,
+    uint32                  queue_family_index,
+    bool                    supports_calibrated_timestamps,
+    uint32                  query_count
+) -> bool;
+
+/// \brief A wrapper function around the main initialize function.
+template < AppType setup_app_type >
+auto initialize(
+    TimestampData&                     timestamps,
+    SetupData< setup_app_type > const& setup,
+    uint32                             query_count
+) -> bool
+{
+    return initialize(
+        timestamps,
+        setup.instance,
+        setup.physical_device,
+        setup.device,
+        setup.graphics_queue_family_index,
+        setup.supports_calibrated_timestamps,
+        query_count
+    );
+}
+
+/// \brief Read consecutive timestamps without blocking, in steady clock nanoseconds.
+///
+/// \param available set to false if the GPU hasn't written every timestamp yet.
+auto get_timestamps_ns(
+    std::span< int64 > timestamps_ns,
+    TimestampData&     timestamps,
+    VkDevice const&    device,
+    uint32             first_query,
+    bool&              available
+) -> bool;
+
+/// \brief Add a sample to a histogram, logging its p50, p95, and p99 once enough time passed.
+auto record_latency( LatencyHistogram& histogram, int64 latency_ns ) -> void;
+
+/// \brief Destroy all the fields of a TimestampData struct.
+auto destroy( TimestampData& timestamps, VkDevice const& device ) -> void;
+
+/// \brief A wrapper function around the main destroy function.
+template < AppType setup_app_type >
+auto destroy( TimestampData& timestamps, SetupData< setup_app_type > const& setup ) -> void
+{
+    return destroy( timestamps, setup.device );
+}
+
+} // namespace ltb::vlk
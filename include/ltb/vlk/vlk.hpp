@@ -28,6 +28,15 @@ enum class ExternalMemory
     Export,
 };
 
+/// \brief How externally shared memory is passed between processes. Opaque fds only
+///        work between identical drivers. Dma-bufs carry an explicit DRM format
+///        modifier and plane layout, so other drivers and APIs can import them too.
+enum class ExternalHandle
+{
+    OpaqueFd,
+    DmaBuf,
+};
+
 enum class Pipeline
 {
     Triangle,
@@ -1,10 +1,22 @@
 #version 450
 
+// Specialization
+// Every branch on these is resolved when the pipeline is created.
+layout(constant_id = 0) const uint blend = 0;// 0: straight, 1: premultiplied, 2: opaque
+layout(constant_id = 1) const uint color = 0;// 0: linear, 1: sRGB-encoded
+
+const uint BLEND_PREMULTIPLIED = 1;
+const uint BLEND_OPAQUE        = 2;
+const uint COLOR_SRGB_ENCODED  = 1;
+
 // Uniforms
-layout(binding = 0) uniform sampler2D tex_sampler1;
-//layout(binding = 2) uniform sampler2D tex_sampler2;
-//layout(binding = 3) uniform sampler2D tex_sampler3;
-//layout(binding = 4) uniform sampler2D tex_sampler4;
+layout(binding = 0) uniform sampler2D tex_sampler;
+
+layout(push_constant) uniform LayerUniforms
+{
+    vec4  rect;// x, y, width, height as fractions of the output
+    float opacity;
+} layer;
 
 // Inputs
 layout(location = 0) in vec2 texture_coordinates;
@@ -13,19 +25,33 @@ layout(location = 0) in vec2 texture_coordinates;
 layout(location = 0) out vec4 out_color;
 
 // Logic
-void update_color(in sampler2D tex)
+vec3 srgb_to_linear(vec3 srgb)
 {
-    vec4 color = texture(tex, texture_coordinates).rgba;
-    out_color.rgb = mix(out_color.rgb, color.rgb, color.a);
+    vec3 low  = srgb / 12.92F;
+    vec3 high = pow((srgb + 0.055F) / 1.055F, vec3(2.4F));
+    return mix(high, low, lessThanEqual(srgb, vec3(0.04045F)));
 }
 
 void main()
 {
-    out_color = vec4(texture_coordinates, 1.0F, 1.0F);
-    //    out_color = vec4(0.0F, 0.0F, 0.0F, 1.0F);
+    // Each layer is one draw, blended over the layers below it by the pipeline.
+    vec4 color_sample = texture(tex_sampler, texture_coordinates).rgba;
+
+    if (color == COLOR_SRGB_ENCODED)
+    {
+        color_sample.rgb = srgb_to_linear(color_sample.rgb);
+    }
 
-    update_color(tex_sampler1);
-    //    update_color(tex_sampler2);
-    //    update_color(tex_sampler3);
-    //    update_color(tex_sampler4);
+    if (blend == BLEND_OPAQUE)
+    {
+        out_color = vec4(color_sample.rgb, 1.0F);
+    }
+    else if (blend == BLEND_PREMULTIPLIED)
+    {
+        out_color = color_sample * layer.opacity;
+    }
+    else
+    {
+        out_color = vec4(color_sample.rgb, color_sample.a * layer.opacity);
+    }
 }
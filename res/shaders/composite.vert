@@ -1,5 +1,12 @@
 #version 450
 
+// Uniforms
+layout(push_constant) uniform LayerUniforms
+{
+    vec4  rect;// x, y, width, height as fractions of the output
+    float opacity;
+} layer;
+
 // Output
 layout(location = 0) out vec2 texture_coordinates;
 
@@ -10,31 +17,30 @@ void main()
     {
         // Bottom left
         case 0:
-        gl_Position         = vec4(-1.0F, +1.0F, 0.0F, 1.0F);
         texture_coordinates = vec2(0.0F, 1.0F);
         break;
 
         // Bottom right
         case 1:
-        gl_Position         = vec4(+1.0F, +1.0F, 0.0F, 1.0F);
         texture_coordinates = vec2(1.0F, 1.0F);
         break;
 
         // Top left
         case 2:
-        gl_Position         = vec4(-1.0F, -1.0F, 0.0F, 1.0F);
         texture_coordinates = vec2(0.0F, 0.0F);
         break;
 
         // Top right
         case 3:
-        gl_Position         = vec4(+1.0F, -1.0F, 0.0F, 1.0F);
         texture_coordinates = vec2(1.0F, 0.0F);
         break;
 
         default :
-        gl_Position         = vec4(vec3(0.0F), 1.0F);
         texture_coordinates = vec2(0.0F);
         break;
     }
+
+    // The quad covers the layer's rect, mapped from [0, 1] to clip space.
+    vec2 position = layer.rect.xy + (texture_coordinates * layer.rect.zw);
+    gl_Position   = vec4((position * 2.0F) - 1.0F, 0.0F, 1.0F);
 }
@@ -1,14 +1,15 @@
 #version 450
 
 // Uniforms
-layout (push_constant, std430) uniform Display {
-    layout (offset = 16) vec4 color;// offset must be the size of previous push_constants
-} display;
+layout (set = 0, binding = 0) uniform Triangle {
+    vec4 scale_rotation_translation;
+    vec4 color;
+} triangle;
 
 // Outputs
 layout (location = 0) out vec4 out_color;
 
 // Logic
 void main() {
-    out_color = display.color;
+    out_color = triangle.color;
 }
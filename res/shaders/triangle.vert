@@ -4,17 +4,18 @@
 const float PI = 3.14159265359F;
 
 // Uniforms
-layout (push_constant) uniform Model
+layout (set = 0, binding = 0) uniform Triangle
 {
     vec4 scale_rotation_translation;
-} model;
+    vec4 color;
+} triangle;
 
 // Logic
 void main()
 {
-    const float scale      = model.scale_rotation_translation.x;
-    const float rotation   = model.scale_rotation_translation.y;
-    const vec2  translation = model.scale_rotation_translation.zw;
+    const float scale      = triangle.scale_rotation_translation.x;
+    const float rotation   = triangle.scale_rotation_translation.y;
+    const vec2  translation = triangle.scale_rotation_translation.zw;
 
     const float angle = rotation - PI * 2.0F / 3.0F * float(gl_VertexIndex);
 
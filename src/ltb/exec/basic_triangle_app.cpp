@@ -36,7 +36,7 @@ auto App::initialize( uint32 const physical_device_index ) -> bool
     CHECK_TRUE( vlk::initialize( setup_, physical_device_index ) );
     CHECK_TRUE( vlk::initialize( output_, setup_ ) );
     CHECK_TRUE( vlk::initialize( pipeline_, setup_, output_, max_frames_in_flight ) );
-    CHECK_TRUE( vlk::initialize( sync_, setup_, max_frames_in_flight ) );
+    CHECK_TRUE( vlk::initialize( sync_, setup_, max_frames_in_flight, 1U ) );
 
     return true;
 }
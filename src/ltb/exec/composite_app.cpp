@@ -3,376 +3,1043 @@
 // /////////////////////////////////////////////////////////////
 
 // project
-#include "ltb/net/fd_socket.hpp"
+#include "ltb/net/fd_server.hpp"
 #include "ltb/utils/args.hpp"
 #include "ltb/utils/ignore.hpp"
 #include "ltb/vlk/check.hpp"
+#include "ltb/vlk/device_message.hpp"
+#include "ltb/vlk/host_ring.hpp"
+#include "ltb/vlk/import_cache.hpp"
+#include "ltb/vlk/layer.hpp"
 #include "ltb/vlk/render.hpp"
+#include "ltb/vlk/shared_ring.hpp"
+#include "ltb/vlk/stream.hpp"
+#include "ltb/vlk/timing.hpp"
 
 // standard
-#include <cerrno>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// platform
+#include <unistd.h>
 
 namespace ltb
 {
 namespace
 {
 
-auto constexpr image_extents = VkExtent3D{
-    .width  = 1920,
-    .height = 1080,
-    .depth  = 1,
+constexpr auto max_frames_in_flight = uint32_t{ 2 };
+
+auto constexpr frame_count_report_interval = std::chrono::seconds( 5 );
+
+auto constexpr socket_path = "socket";
+
+using ImportRing = vlk::SharedRingData< vlk::ExternalMemory::Import >;
+using HostRing   = vlk::HostRingData< vlk::ExternalMemory::Import >;
+
+// A producer's place in the composited output and the rings it's displayed from.
+//
+// A restarted producer's ring is imported next to the current one and only replaces
+// it once its first frame is ready, so the last good frame stays on screen in the
+// meantime. Producers that can't share device memory copy their frames through a
+// host ring instead, and at most one of the two is displayed.
+struct Layer
+{
+    std::unique_ptr< ImportRing > ring              = { };
+    std::unique_ptr< ImportRing > pending_ring      = { };
+    std::unique_ptr< HostRing >   host_ring         = { };
+    std::unique_ptr< HostRing >   pending_host_ring = { };
+
+    // The connection of the producer currently feeding the layer, if any.
+    std::optional< uint64 > connection = { };
+
+    uint32             descriptor_index = 0U;
+    int32              z_order          = 0;
+    vlk::LayerUniforms uniforms         = { };
+
+    // The ring slot each of the layer's descriptor sets currently points to.
+    std::vector< std::optional< uint32 > > descriptor_slots = { };
+
+    // When the displayed and dropped frame counts of the layer were last logged.
+    std::chrono::steady_clock::time_point report_time = { };
+
+    // The last frame of the displayed ring whose latency was traced.
+    std::optional< uint64 > traced_frame_id = { };
+
+    // The last frame of the displayed ring whose damage was composited.
+    std::optional< uint64 > damaged_frame_id = { };
 };
 
-constexpr auto max_frames_in_flight = uint32_t{ 2 };
+// A newly displayed frame, traced once the composite that drew it is done. The generation
+// is only set for shared rings, whose producers also publish the frame's GPU timing.
+struct TracedFrame
+{
+    uint32                  layer_id        = 0U;
+    std::optional< uint64 > ring_generation = { };
+    vlk::FrameRecord        record          = { };
+};
 
-struct SurfaceFormatEquals
+// A ring that is no longer displayed but may still be read by frames in flight.
+// Only one of the two rings is set.
+struct RetiredRing
 {
-    VkSurfaceFormatKHR const& format;
+    std::unique_ptr< ImportRing > ring           = { };
+    std::unique_ptr< HostRing >   host_ring      = { };
+    uint32                        pending_frames = 0U; // One bit per frame in flight.
+};
+
+// Both rings display the very same imported images, which only happens when they were
+// both imported from the same cached allocation generation.
+auto has_same_images( ImportRing const& lhs, ImportRing const& rhs ) -> bool
+{
+    return std::ranges::equal(
+        lhs.images,
+        rhs.images,
+        []( auto const& lhs_image, auto const& rhs_image )
+        { return lhs_image.color_image_view == rhs_image.color_image_view; }
+    );
+}
 
-    auto operator( )( VkSurfaceFormatKHR const& surface_format ) const -> bool
+// Host producers upload pixels as they're meant to be displayed, which is sRGB-encoded.
+// Sampling an sRGB format decodes them, but a UNORM format hands them over encoded.
+auto get_host_color( VkFormat const color_format ) -> vlk::CompositeColor
+{
+    switch ( color_format )
     {
-        return ( surface_format.format == format.format )
-            && ( surface_format.colorSpace == format.colorSpace );
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+            return vlk::CompositeColor::SrgbEncoded;
+        default:
+            return vlk::CompositeColor::Linear;
+    }
+}
+
+auto is_valid( vlk::LayerMessage const& message ) -> bool
+{
+    auto const [ x, y, width, height ] = message.rect;
+    return ( vlk::layer_message_version == message.version ) && std::isfinite( x )
+        && std::isfinite( y ) && ( width > 0.0F ) && ( height > 0.0F )
+        && ( message.opacity >= 0.0F ) && ( message.opacity <= 1.0F );
+}
+
+// The region of the output changed by a layer's frame. Frames without damage rects
+// changed everywhere. Layers are sampled with linear filtering, so every changed texel
+// also changes the output a texel around it.
+auto get_output_damage(
+    vlk::LayerUniforms const&                uniforms,
+    VkExtent2D const&                        image_size,
+    std::optional< vlk::FrameRecord > const& record,
+    VkExtent2D const&                        output_size
+) -> VkRect2D
+{
+    auto const [ x, y, width, height ] = uniforms.rect;
+
+    // Positions are clamped to just outside the output first so the conversions can't overflow.
+    auto const to_output = []( float32 const position, uint32 const size )
+    {
+        auto const pixels = position * static_cast< float32 >( size );
+        return std::clamp( pixels, -1.0F, static_cast< float32 >( size ) + 1.0F );
+    };
+    auto const to_output_rect = [ & ]( vlk::DamageRect const& damage )
+    {
+        if ( vlk::is_empty( vlk::to_rect( damage ) ) )
+        {
+            return VkRect2D{ };
+        }
+        auto const image_width  = static_cast< float32 >( image_size.width );
+        auto const image_height = static_cast< float32 >( image_size.height );
+
+        auto const left   = static_cast< float32 >( damage.x ) - 1.0F;
+        auto const top    = static_cast< float32 >( damage.y ) - 1.0F;
+        auto const right  = left + static_cast< float32 >( damage.width ) + 2.0F;
+        auto const bottom = top + static_cast< float32 >( damage.height ) + 2.0F;
+
+        auto const min_u = left / image_width;
+        auto const min_v = top / image_height;
+        auto const max_u = right / image_width;
+        auto const max_v = bottom / image_height;
+
+        auto const min_x = std::floor( to_output( x + ( min_u * width ), output_size.width ) );
+        auto const min_y = std::floor( to_output( y + ( min_v * height ), output_size.height ) );
+        auto const max_x = std::ceil( to_output( x + ( max_u * width ), output_size.width ) );
+        auto const max_y = std::ceil( to_output( y + ( max_v * height ), output_size.height ) );
+
+        auto const rect = VkRect2D{
+            .offset = VkOffset2D{
+                .x = static_cast< int32 >( min_x ),
+                .y = static_cast< int32 >( min_y ),
+            },
+            .extent = VkExtent2D{
+                .width  = static_cast< uint32 >( max_x - min_x ),
+                .height = static_cast< uint32 >( max_y - min_y ),
+            },
+        };
+        return vlk::clip( rect, output_size );
+    };
+
+    if ( !record || ( 0U == record->damage_count ) )
+    {
+        return to_output_rect( vlk::DamageRect{
+            .x      = 0,
+            .y      = 0,
+            .width  = image_size.width,
+            .height = image_size.height,
+        } );
     }
-};
+
+    auto damage             = VkRect2D{ };
+    auto const damage_count = std::min( record->damage_count, vlk::max_damage_rects );
+    for ( auto index = 0U; index < damage_count; ++index )
+    {
+        damage = vlk::unite( damage, to_output_rect( record->damage[ index ] ) );
+    }
+    return damage;
+}
 
 } // namespace
 
 class App
 {
 public:
-    App( )                               = default;
-    App( App const& )                    = delete;
-    App( App&& )                         = delete;
-    auto operator=( App const& ) -> App& = delete;
-    auto operator=( App&& ) -> App&      = delete;
-    ~App( );
-
-    auto initialize( uint32 physical_device_index ) -> bool;
-
+    auto initialize( uint32 physical_device_index, bool listens_for_streams ) -> bool;
+    auto destroy( ) -> void;
     auto run( ) -> bool;
 
 private:
+    // Vulkan data
     vlk::SetupData< vlk::AppType::Windowed >      setup_    = { };
-    vlk::PipelineData< vlk::Pipeline::Composite > pipeline_ = { };
     vlk::OutputData< vlk::AppType::Windowed >     output_   = { };
+    vlk::PipelineData< vlk::Pipeline::Composite > pipeline_ = { };
     vlk::SyncData< vlk::AppType::Windowed >       sync_     = { };
 
-    // Imported Image
-    VkImage        color_image_         = { };
-    VkDeviceMemory color_image_memory_  = { };
-    VkImageView    color_image_view_    = { };
-    VkSampler      color_image_sampler_ = { };
+    // Shared images, one layer per producer, keyed by layer id.
+    std::map< uint32, Layer >  layers_              = { };
+    std::vector< RetiredRing > retired_rings_       = { };
+    VkSampler                  color_image_sampler_ = { };
+
+    // Imported images are kept so a ring announced again doesn't import them again.
+    vlk::ImportCacheData import_cache_ = { };
+
+    // The frames newly drawn by each frame in flight, traced once their timestamps are read.
+    vlk::TimestampData                        timestamps_    = { };
+    std::vector< std::vector< TracedFrame > > traced_frames_ = { };
+
+    vlk::LatencyHistogram composite_latency_ = { .name = "Producer submit to composite end" };
+    vlk::LatencyHistogram queue_latency_     = { .name = "Producer render end to composite end" };
+
+    // Networking. Producers describe their layer before sending their ring,
+    // and producers that don't are drawn full screen as layer 0.
+    net::FdServer                                   server_             = { };
+    std::vector< net::FdServerEvent >               server_events_      = { };
+    std::unordered_map< uint64, vlk::LayerMessage > layer_descriptions_ = { };
+    std::unordered_map< uint64, uint32 >            connection_layers_  = { };
 
-    // Networking
-    net::FdSocket socket_         = { };
-    int32         color_image_fd_ = -1;
+    // Producers on other machines stream their frames into a local host ring.
+    vlk::StreamData< vlk::ExternalMemory::Import > stream_ = { };
+
+    // Set when layers are added, moved, or switch rings, so the next frame is drawn in full.
+    bool damages_output_ = true;
+
+    auto poll_producers( ) -> bool;
+    auto accept_message( net::FdServerEvent& event ) -> bool;
+    auto accept_layer( net::FdServerEvent& event ) -> bool;
+    auto accept_stream( ) -> bool;
+    auto find_or_add_layer( vlk::LayerMessage const& description ) -> Layer*;
+    auto send_device( uint64 connection_id ) -> bool;
+    auto send_reply( uint64 connection_id, vlk::TransportStatus status ) -> bool;
+    auto get_layer( uint64 connection_id ) -> Layer*;
+    auto take_over_layer( Layer& layer, uint64 connection_id ) -> void;
+    auto import_ring( uint32 layer_id, Layer& layer, net::FdServerEvent& event ) -> bool;
+    auto import_host_ring( Layer& layer, net::FdServerEvent& event ) -> bool;
+    auto import_host_ring( Layer& layer, vlk::HostRingMessage const& message, int32 memory_fd )
+        -> bool;
+    auto destroy_pending_rings( Layer& layer ) -> void;
+    auto retire_displayed_rings( Layer& layer ) -> void;
+    auto latch_frame( Layer& layer ) -> std::optional< uint32 >;
+    auto destroy_retired_rings( ) -> void;
+    auto report_frame_counts( uint32 layer_id, Layer& layer ) -> void;
+    auto update_descriptor_set(
+        uint32             frame_index,
+        Layer&             layer,
+        VkImageView const& image_view,
+        uint32             slot
+    ) -> void;
+    auto trace_frames( uint32 frame_index ) -> bool;
+    auto render_frame( ) -> bool;
 };
 
-App::~App( )
+auto App::initialize( uint32 const physical_device_index, bool const listens_for_streams )
+    -> bool
 {
-    if ( -1 != color_image_fd_ )
+    CHECK_TRUE( vlk::initialize( setup_, physical_device_index ) );
+    CHECK_TRUE( vlk::initialize( output_, setup_ ) );
+    CHECK_TRUE( vlk::initialize( pipeline_, setup_, output_, max_frames_in_flight ) );
+
+    // Layers are recorded on every core, but never on more threads than there are layers.
+    auto const recording_thread_count
+        = std::min( vlk::get_recording_thread_count( ), vlk::max_composite_layers );
+    CHECK_TRUE( vlk::initialize( sync_, setup_, max_frames_in_flight, recording_thread_count ) );
+
+    CHECK_TRUE( vlk::initialize(
+        timestamps_,
+        setup_,
+        max_frames_in_flight * vlk::timestamp_queries_per_render
+    ) );
+    sync_.timestamp_queries = timestamps_.query_pool;
+    traced_frames_.resize( max_frames_in_flight );
+
+    // Producers connect whenever they start, so startup doesn't wait for one.
+    CHECK_TRUE( server_.initialize( socket_path ) );
+    if ( listens_for_streams )
     {
-        utils::ignore( ::close( color_image_fd_ ) );
+        CHECK_TRUE( vlk::initialize( stream_, "0.0.0.0", vlk::default_stream_port ) );
     }
+    spdlog::info( "Waiting for producers..." );
 
-    if ( nullptr != color_image_sampler_ )
+    auto physical_device_properties = VkPhysicalDeviceProperties{ };
+    ::vkGetPhysicalDeviceProperties( setup_.physical_device, &physical_device_properties );
+
+    auto const sampler_info = VkSamplerCreateInfo{
+        .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext                   = nullptr,
+        .flags                   = 0U,
+        .magFilter               = VK_FILTER_LINEAR,
+        .minFilter               = VK_FILTER_LINEAR,
+        .mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .addressModeU            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias              = 0.0F,
+        .anisotropyEnable        = VK_TRUE,
+        .maxAnisotropy           = physical_device_properties.limits.maxSamplerAnisotropy,
+        .compareEnable           = VK_FALSE,
+        .compareOp               = VK_COMPARE_OP_ALWAYS,
+        .minLod                  = 0.0F,
+        .maxLod                  = 0.0F,
+        .borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+    CHECK_VK( ::vkCreateSampler( setup_.device, &sampler_info, nullptr, &color_image_sampler_ ) );
+
+    return true;
+}
+
+auto App::poll_producers( ) -> bool
+{
+    CHECK_TRUE( server_.poll( server_events_ ) );
+
+    for ( auto& event : server_events_ )
     {
-        ::vkDestroySampler( setup_.device, color_image_sampler_, nullptr );
-        spdlog::debug( "vkDestroySampler()" );
+        switch ( event.type )
+        {
+            case net::FdServerEventType::Connected:
+                // Producers pick their device to match this one before sending anything.
+                if ( !send_device( event.connection_id ) )
+                {
+                    server_.disconnect( event.connection_id );
+                }
+                break;
+
+            case net::FdServerEventType::Message:
+                if ( !accept_message( event ) )
+                {
+                    server_.disconnect( event.connection_id );
+                }
+                break;
+
+            case net::FdServerEventType::Disconnected:
+                layer_descriptions_.erase( event.connection_id );
+                if ( auto* layer = get_layer( event.connection_id ); nullptr != layer )
+                {
+                    spdlog::info( "Producer disconnected, keeping its last frame" );
+                    layer->connection = std::nullopt;
+                }
+                connection_layers_.erase( event.connection_id );
+                break;
+        }
     }
+    return accept_stream( );
+}
 
-    if ( nullptr != color_image_view_ )
+auto App::accept_message( net::FdServerEvent& event ) -> bool
+{
+    auto magic = uint32{ 0 };
+    if ( event.payload.size( ) >= sizeof( magic ) )
     {
-        ::vkDestroyImageView( setup_.device, color_image_view_, nullptr );
-        spdlog::debug( "vkDestroyImageView()" );
+        utils::ignore( std::memcpy( &magic, event.payload.data( ), sizeof( magic ) ) );
     }
 
-    if ( nullptr != color_image_memory_ )
+    if ( vlk::layer_message_magic == magic )
     {
-        ::vkFreeMemory( setup_.device, color_image_memory_, nullptr );
-        spdlog::debug( "vkFreeMemory()" );
+        return accept_layer( event );
     }
 
-    if ( nullptr != color_image_ )
+    auto const is_ring_message
+        = ( vlk::shared_ring_message_magic == magic ) || ( vlk::host_ring_message_magic == magic );
+
+    // Each producer feeds a single layer with a single ring.
+    if ( is_ring_message && connection_layers_.contains( event.connection_id ) )
     {
-        ::vkDestroyImage( setup_.device, color_image_, nullptr );
-        spdlog::debug( "vkDestroyImage()" );
+        spdlog::warn( "Ignoring message from connection {}", event.connection_id );
+        net::close_all( event.fds );
+        return true;
     }
 
-    vlk::destroy( setup_, sync_ );
-    vlk::destroy( setup_, output_ );
-    vlk::destroy( setup_, pipeline_ );
-    vlk::destroy( setup_ );
+    if ( !is_ring_message )
+    {
+        spdlog::error( "Unknown message from connection {}", event.connection_id );
+        net::close_all( event.fds );
+        return false;
+    }
+
+    auto const description = layer_descriptions_.contains( event.connection_id )
+                               ? layer_descriptions_.at( event.connection_id )
+                               : vlk::LayerMessage{ };
+
+    auto* const layer = find_or_add_layer( description );
+    if ( nullptr == layer )
+    {
+        net::close_all( event.fds );
+        return false;
+    }
+
+    // A shared ring that can't be imported isn't fatal, the producer is
+    // asked to fall back to copying its frames through host memory.
+    if ( vlk::shared_ring_message_magic == magic )
+    {
+        auto const imported = import_ring( description.layer_id, *layer, event );
+        auto const status
+            = imported ? vlk::TransportStatus::Accepted : vlk::TransportStatus::Fallback;
+        CHECK_TRUE( send_reply( event.connection_id, status ) );
+
+        if ( imported )
+        {
+            take_over_layer( *layer, event.connection_id );
+            connection_layers_[ event.connection_id ] = description.layer_id;
+        }
+        return true;
+    }
+
+    CHECK_TRUE( import_host_ring( *layer, event ) );
+    CHECK_TRUE( send_reply( event.connection_id, vlk::TransportStatus::Accepted ) );
+    take_over_layer( *layer, event.connection_id );
+    connection_layers_[ event.connection_id ] = description.layer_id;
+    return true;
 }
 
-auto App::initialize( uint32 const physical_device_index ) -> bool
+auto App::accept_stream( ) -> bool
 {
-    CHECK_TRUE( vlk::initialize( physical_device_index, setup_ ) );
-    CHECK_TRUE( vlk::initialize< vlk::AppType::Windowed >(
-        max_frames_in_flight,
-        setup_.surface_format.format,
-        setup_.device,
-        pipeline_
-    ) );
-    CHECK_TRUE( vlk::initialize( setup_, pipeline_, output_ ) );
-    CHECK_TRUE(
-        vlk::initialize( max_frames_in_flight, setup_.device, setup_.graphics_command_pool, sync_ )
-    );
+    auto description = vlk::LayerMessage{ };
+    auto message     = vlk::HostRingMessage{ };
+    auto memory_fd   = int32{ -1 };
+    if ( !vlk::take_ring( stream_, description, message, memory_fd ) )
+    {
+        return true;
+    }
+
+    auto* const layer = is_valid( description ) ? find_or_add_layer( description ) : nullptr;
+    if ( nullptr == layer )
+    {
+        spdlog::error( "Can't composite the streamed layer {}", description.layer_id );
+        utils::ignore( ::close( memory_fd ) );
+        return true;
+    }
 
-    auto constexpr socket_path = "socket";
+    // Streamed layers replace any local producer of the same layer.
+    if ( import_host_ring( *layer, message, memory_fd ) && layer->connection )
+    {
+        connection_layers_.erase( layer->connection.value( ) );
+        server_.disconnect( layer->connection.value( ) );
+        layer->connection = std::nullopt;
+    }
+    return true;
+}
 
-    if ( ::unlink( socket_path ) < 0 )
+auto App::find_or_add_layer( vlk::LayerMessage const& description ) -> Layer*
+{
+    auto layer = layers_.find( description.layer_id );
+    if ( layers_.end( ) == layer )
     {
-        if ( errno != ENOENT )
+        if ( layers_.size( ) >= vlk::max_composite_layers )
         {
-            spdlog::error( "unlink() failed: {}", std::strerror( errno ) );
-            return false;
+            spdlog::error( "Can't composite more than {} layers", vlk::max_composite_layers );
+            return nullptr;
         }
+
+        // Layers are never removed, so the next descriptor index is always free.
+        layer = layers_.emplace( description.layer_id, Layer{ } ).first;
+        layer->second.descriptor_index = static_cast< uint32 >( layers_.size( ) - 1U );
+        layer->second.descriptor_slots.assign( max_frames_in_flight, std::nullopt );
     }
+    layer->second.z_order  = description.z_order;
+    layer->second.uniforms = vlk::LayerUniforms{
+        .rect    = description.rect,
+        .opacity = description.opacity,
+    };
+    damages_output_ = true;
+    return &layer->second;
+}
 
-    if ( !socket_.initialize( ) )
+auto App::accept_layer( net::FdServerEvent& event ) -> bool
+{
+    auto message = vlk::LayerMessage{ };
+    if ( ( sizeof( message ) != event.payload.size( ) ) || !event.fds.empty( ) )
     {
+        spdlog::error( "Unexpected layer message size: {}", event.payload.size( ) );
+        net::close_all( event.fds );
         return false;
     }
-    if ( !socket_.bind_and_receive( socket_path, color_image_fd_ ) )
+    utils::ignore( std::memcpy( &message, event.payload.data( ), sizeof( message ) ) );
+
+    if ( !is_valid( message ) )
     {
+        spdlog::error( "Invalid layer message from connection {}", event.connection_id );
         return false;
     }
 
-    spdlog::debug( "Received color image FD: {}", color_image_fd_ );
-
-    auto constexpr external_memory_handle_type = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
-    auto constexpr color_format                = VK_FORMAT_B8G8R8A8_SRGB;
+    layer_descriptions_[ event.connection_id ] = message;
+    spdlog::info(
+        "Connection {} is layer {} at z-order {}",
+        event.connection_id,
+        message.layer_id,
+        message.z_order
+    );
+    return true;
+}
 
-    auto const external_color_image_info = VkExternalMemoryImageCreateInfo{
-        .sType       = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
-        .pNext       = nullptr,
-        .handleTypes = external_memory_handle_type,
+auto App::send_device( uint64 const connection_id ) -> bool
+{
+    auto const message = vlk::DeviceMessage{
+        .magic     = vlk::device_message_magic,
+        .version   = vlk::device_message_version,
+        .device_id = setup_.device_id,
     };
-    auto const color_image_create_info = VkImageCreateInfo{
-        .sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        .pNext                 = &external_color_image_info,
-        .flags                 = 0U,
-        .imageType             = VK_IMAGE_TYPE_2D,
-        .format                = color_format,
-        .extent                = image_extents,
-        .mipLevels             = 1U,
-        .arrayLayers           = 1U,
-        .samples               = VK_SAMPLE_COUNT_1_BIT,
-        .tiling                = VK_IMAGE_TILING_OPTIMAL,
-        .usage                 = VK_IMAGE_USAGE_SAMPLED_BIT,
-        .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
-        .queueFamilyIndexCount = 0U,
-        .pQueueFamilyIndices   = nullptr,
-        .initialLayout         = VK_IMAGE_LAYOUT_UNDEFINED,
+    return server_.send( connection_id, std::as_bytes( std::span{ &message, 1U } ), { } );
+}
+
+auto App::send_reply( uint64 const connection_id, vlk::TransportStatus const status ) -> bool
+{
+    auto const reply = vlk::TransportReply{
+        .magic  = vlk::transport_reply_magic,
+        .status = status,
     };
+    return server_.send( connection_id, std::as_bytes( std::span{ &reply, 1U } ), { } );
+}
+
+auto App::get_layer( uint64 const connection_id ) -> Layer*
+{
+    if ( auto const iter = connection_layers_.find( connection_id );
+         connection_layers_.end( ) != iter )
+    {
+        return &layers_.at( iter->second );
+    }
+    return nullptr;
+}
 
-    CHECK_VK( ::vkCreateImage( setup_.device, &color_image_create_info, nullptr, &color_image_ ) );
-    spdlog::debug( "vkCreateImage()" );
+auto App::take_over_layer( Layer& layer, uint64 const connection_id ) -> void
+{
+    // The previous producer's ring is replaced, so it can't keep rendering into it.
+    if ( layer.connection && ( layer.connection.value( ) != connection_id ) )
+    {
+        spdlog::info( "Connection {} took over the layer", connection_id );
+        connection_layers_.erase( layer.connection.value( ) );
+        server_.disconnect( layer.connection.value( ) );
+    }
+    layer.connection = connection_id;
+}
 
-    auto color_image_mem_reqs = VkMemoryRequirements{ };
-    ::vkGetImageMemoryRequirements( setup_.device, color_image_, &color_image_mem_reqs );
+auto App::import_ring( uint32 const layer_id, Layer& layer, net::FdServerEvent& event ) -> bool
+{
+    if ( sizeof( vlk::SharedRingMessage ) != event.payload.size( ) )
+    {
+        spdlog::error( "Unexpected shared ring message size: {}", event.payload.size( ) );
+        net::close_all( event.fds );
+        return false;
+    }
 
-    auto memory_props = VkPhysicalDeviceMemoryProperties{ };
-    ::vkGetPhysicalDeviceMemoryProperties( setup_.physical_device, &memory_props );
-    auto const mem_prop_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    // The message describes every image, so nothing about the producer is hardcoded here.
+    auto message = vlk::SharedRingMessage{ };
+    utils::ignore( std::memcpy( &message, event.payload.data( ), sizeof( message ) ) );
 
-    auto memory_type_index = std::optional< uint32 >{ };
-    for ( auto i = 0U; i < memory_props.memoryTypeCount; ++i )
+    destroy_pending_rings( layer );
+    layer.pending_ring = std::make_unique< ImportRing >( );
+
+    // The ring owns the fds from here on, even if the import fails. Each layer has a
+    // single producer at a time, so the layer id identifies the producer in the cache.
+    auto const imported = vlk::initialize(
+        *layer.pending_ring,
+        setup_,
+        message,
+        event.fds,
+        import_cache_,
+        layer_id
+    );
+    event.fds.clear( );
+
+    if ( !imported )
     {
-        auto const type_is_suitable
-            = ( 0U != ( color_image_mem_reqs.memoryTypeBits & ( 1U << i ) ) );
-        auto const props_exist
-            = ( memory_props.memoryTypes[ i ].propertyFlags & mem_prop_flags ) == mem_prop_flags;
+        vlk::destroy( *layer.pending_ring, setup_ );
+        layer.pending_ring = nullptr;
+        return false;
+    }
+    spdlog::info( "Received shared ring with {} slots", layer.pending_ring->images.size( ) );
 
-        if ( ( !memory_type_index ) && type_is_suitable && props_exist )
+    return true;
+}
+
+auto App::import_host_ring( Layer& layer, net::FdServerEvent& event ) -> bool
+{
+    if ( ( sizeof( vlk::HostRingMessage ) != event.payload.size( ) )
+         || ( 1U != event.fds.size( ) ) )
+    {
+        spdlog::error(
+            "Unexpected host ring message: {} bytes, {} fds",
+            event.payload.size( ),
+            event.fds.size( )
+        );
+        net::close_all( event.fds );
+        return false;
+    }
+
+    auto message = vlk::HostRingMessage{ };
+    utils::ignore( std::memcpy( &message, event.payload.data( ), sizeof( message ) ) );
+
+    auto const memory_fd = event.fds.front( );
+    event.fds.clear( );
+    return import_host_ring( layer, message, memory_fd );
+}
+
+auto App::import_host_ring(
+    Layer&                      layer,
+    vlk::HostRingMessage const& message,
+    int32 const                 memory_fd
+) -> bool
+{
+    destroy_pending_rings( layer );
+    layer.pending_host_ring = std::make_unique< HostRing >( );
+
+    // The ring owns the fd from here on, even if the import fails.
+    auto const imported = vlk::initialize( *layer.pending_host_ring, setup_, message, memory_fd );
+
+    if ( !imported )
+    {
+        vlk::destroy( *layer.pending_host_ring, setup_ );
+        layer.pending_host_ring = nullptr;
+        return false;
+    }
+    spdlog::info( "Received host ring with {} slots", message.slot_count );
+
+    return true;
+}
+
+auto App::destroy_pending_rings( Layer& layer ) -> void
+{
+    // A pending ring is promoted as soon as it's first submitted, so it can go right away.
+    if ( layer.pending_ring )
+    {
+        vlk::destroy( *layer.pending_ring, setup_ );
+        layer.pending_ring = nullptr;
+    }
+    if ( layer.pending_host_ring )
+    {
+        vlk::destroy( *layer.pending_host_ring, setup_ );
+        layer.pending_host_ring = nullptr;
+    }
+}
+
+auto App::retire_displayed_rings( Layer& layer ) -> void
+{
+    // Frames in flight may still sample the old ring, so it's destroyed later.
+    if ( layer.ring || layer.host_ring )
+    {
+        retired_rings_.push_back( RetiredRing{
+            .ring           = std::move( layer.ring ),
+            .host_ring      = std::move( layer.host_ring ),
+            .pending_frames = ( 1U << max_frames_in_flight ) - 1U,
+        } );
+    }
+
+    // Slot indices of the new ring point at different image views,
+    // and the new ring's frame ids start over.
+    layer.descriptor_slots.assign( max_frames_in_flight, std::nullopt );
+    layer.traced_frame_id  = std::nullopt;
+    layer.damaged_frame_id = std::nullopt;
+    damages_output_        = true;
+}
+
+auto App::latch_frame( Layer& layer ) -> std::optional< uint32 >
+{
+    if ( layer.pending_ring )
+    {
+        if ( auto const slot = vlk::latch_ready_slot( *layer.pending_ring, setup_.device, sync_ );
+             slot )
         {
-            memory_type_index = uint32{ i };
+            // Descriptors still point at the right views if the images were reused.
+            auto const reuses_images
+                = layer.ring && has_same_images( *layer.ring, *layer.pending_ring );
+            auto descriptor_slots = layer.descriptor_slots;
+
+            retire_displayed_rings( layer );
+            layer.ring = std::move( layer.pending_ring );
+            if ( reuses_images )
+            {
+                layer.descriptor_slots = std::move( descriptor_slots );
+            }
+            spdlog::info( "Switched to the new producer's ring" );
+            return slot;
         }
     }
 
-    if ( !memory_type_index )
+    if ( layer.pending_host_ring )
     {
-        spdlog::error( "No suitable memory type found" );
-        return false;
+        if ( vlk::latch_ready_frame(
+                 *layer.pending_host_ring,
+                 setup_.device,
+                 setup_.graphics_queue
+             ) )
+        {
+            retire_displayed_rings( layer );
+            layer.host_ring = std::move( layer.pending_host_ring );
+            spdlog::info( "Switched to the new producer's host ring" );
+            return 0U;
+        }
     }
 
-    auto const import_memory_info = VkImportMemoryFdInfoKHR{
-        .sType      = VK_STRUCTURE_TYPE_IMPORT_MEMORY_WIN32_HANDLE_INFO_KHR,
-        .pNext      = nullptr,
-        .handleType = external_memory_handle_type,
-        .fd         = color_image_fd_
-    };
-    auto const color_image_alloc_info = VkMemoryAllocateInfo{
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext           = &import_memory_info,
-        .allocationSize  = color_image_mem_reqs.size,
-        .memoryTypeIndex = memory_type_index.value( ),
-    };
-    CHECK_VK(
-        ::vkAllocateMemory( setup_.device, &color_image_alloc_info, nullptr, &color_image_memory_ )
-    );
-    spdlog::debug( "vkAllocateMemory()" );
+    if ( layer.host_ring )
+    {
+        // Host rings are uploaded to a single image.
+        if ( vlk::latch_ready_frame( *layer.host_ring, setup_.device, setup_.graphics_queue ) )
+        {
+            return 0U;
+        }
+        return std::nullopt;
+    }
+
+    if ( layer.ring )
+    {
+        return vlk::latch_ready_slot( *layer.ring, setup_.device, sync_ );
+    }
+    return std::nullopt;
+}
+
+auto App::destroy_retired_rings( ) -> void
+{
+    for ( auto& retired : retired_rings_ )
+    {
+        for ( auto frame = 0U; frame < max_frames_in_flight; ++frame )
+        {
+            auto const frame_bit = 1U << frame;
+            auto const& fence    = sync_.graphics_queue_fences[ frame ];
+
+            // A signaled fence means nothing submitted for that frame is still running.
+            if ( ( 0U != ( retired.pending_frames & frame_bit ) )
+                 && ( VK_SUCCESS == ::vkGetFenceStatus( setup_.device, fence ) ) )
+            {
+                retired.pending_frames &= ~frame_bit;
+            }
+        }
 
-    auto constexpr memory_offset = VkDeviceSize{ 0 };
-    CHECK_VK( ::vkBindImageMemory( setup_.device, color_image_, color_image_memory_, memory_offset )
+        if ( 0U == retired.pending_frames )
+        {
+            if ( retired.ring )
+            {
+                vlk::destroy( *retired.ring, setup_ );
+                retired.ring = nullptr;
+            }
+            if ( retired.host_ring )
+            {
+                vlk::destroy( *retired.host_ring, setup_ );
+                retired.host_ring = nullptr;
+            }
+        }
+    }
+
+    std::erase_if(
+        retired_rings_,
+        []( RetiredRing const& retired ) { return !retired.ring && !retired.host_ring; }
     );
-    spdlog::debug( "vkBindImageMemory()" );
-
-    auto const command_buffer_alloc_info = VkCommandBufferAllocateInfo{
-        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .pNext              = nullptr,
-        .commandPool        = setup_.graphics_command_pool,
-        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1U,
-    };
+}
+
+auto App::report_frame_counts( uint32 const layer_id, Layer& layer ) -> void
+{
+    auto const now = std::chrono::steady_clock::now( );
+    if ( !layer.ring || ( ( now - layer.report_time ) < frame_count_report_interval ) )
+    {
+        return;
+    }
+    layer.report_time = now;
 
-    auto* command_buffer = VkCommandBuffer{ };
-    CHECK_VK(
-        ::vkAllocateCommandBuffers( setup_.device, &command_buffer_alloc_info, &command_buffer )
+    // Dropped frames are expected in mailbox rings, where only the newest frame is shown.
+    spdlog::info(
+        "Layer {}: {} frames displayed, {} dropped, {} queued",
+        layer_id,
+        layer.ring->latched_frame_count,
+        layer.ring->dropped_frame_count,
+        layer.ring->queue_depth
     );
+}
 
-    auto const begin_info = VkCommandBufferBeginInfo{
-        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext            = nullptr,
-        .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-        .pInheritanceInfo = nullptr,
+auto App::update_descriptor_set(
+    uint32 const       frame_index,
+    Layer&             layer,
+    VkImageView const& image_view,
+    uint32 const       slot
+) -> void
+{
+    auto const image_info = VkDescriptorImageInfo{
+        .sampler     = color_image_sampler_,
+        .imageView   = image_view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
     };
-    CHECK_VK( ::vkBeginCommandBuffer( command_buffer, &begin_info ) );
-
-    auto const barrier = VkImageMemoryBarrier{
-        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .pNext = nullptr,
-        .srcAccessMask = VK_ACCESS_NONE,
-        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image = color_image_,
-        .subresourceRange = VkImageSubresourceRange{
-               .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-               .baseMipLevel   = 0U,
-               .levelCount     = 1U,
-               .baseArrayLayer = 0U,
-               .layerCount     = 1U,
+    auto const descriptor_writes = std::array{
+        VkWriteDescriptorSet{
+            .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext            = nullptr,
+            .dstSet = vlk::get_descriptor_set( pipeline_, frame_index, layer.descriptor_index ),
+            .dstBinding       = 0U,
+            .dstArrayElement  = 0U,
+            .descriptorCount  = 1U,
+            .descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo       = &image_info,
+            .pBufferInfo      = nullptr,
+            .pTexelBufferView = nullptr,
         },
     };
-    ::vkCmdPipelineBarrier(
-        command_buffer,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        0U,
-        0U,
-        nullptr,
+    ::vkUpdateDescriptorSets(
+        setup_.device,
+        static_cast< uint32_t >( descriptor_writes.size( ) ),
+        descriptor_writes.data( ),
         0U,
-        nullptr,
-        1U,
-        &barrier
+        nullptr
     );
+    layer.descriptor_slots[ frame_index ] = slot;
+}
 
-    CHECK_VK( ::vkEndCommandBuffer( command_buffer ) );
-
-    auto const submit_info = VkSubmitInfo{
-        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext                = nullptr,
-        .waitSemaphoreCount   = 0,
-        .pWaitSemaphores      = nullptr,
-        .pWaitDstStageMask    = nullptr,
-        .commandBufferCount   = 1U,
-        .pCommandBuffers      = &command_buffer,
-        .signalSemaphoreCount = 0U,
-        .pSignalSemaphores    = nullptr,
-    };
-    CHECK_VK( ::vkQueueSubmit( setup_.graphics_queue, 1, &submit_info, nullptr ) );
-    CHECK_VK( ::vkQueueWaitIdle( setup_.graphics_queue ) );
-
-    ::vkFreeCommandBuffers( setup_.device, setup_.graphics_command_pool, 1U, &command_buffer );
-
-    auto const color_image_view_create_info = VkImageViewCreateInfo{
-        .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-        .pNext            = nullptr,
-        .flags            = 0,
-        .image            = color_image_,
-        .viewType         = VK_IMAGE_VIEW_TYPE_2D,
-        .format           = color_format,
-        .components       = VkComponentMapping{ },
-        .subresourceRange = VkImageSubresourceRange{
-            .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-            .baseMipLevel   = 0,
-            .levelCount     = 1,
-            .baseArrayLayer = 0,
-            .layerCount     = 1,
-        },
-    };
-    CHECK_VK( ::vkCreateImageView(
+auto App::trace_frames( uint32 const frame_index ) -> bool
+{
+    auto& traced_frames = traced_frames_[ frame_index ];
+    if ( traced_frames.empty( ) )
+    {
+        return true;
+    }
+
+    // The frame's fence was waited on, so its timestamps are already written.
+    auto timestamps_ns = std::array< int64, vlk::timestamp_queries_per_render >{ };
+    auto available     = false;
+    CHECK_TRUE( vlk::get_timestamps_ns(
+        timestamps_ns,
+        timestamps_,
         setup_.device,
-        &color_image_view_create_info,
-        nullptr,
-        &color_image_view_
+        frame_index * vlk::timestamp_queries_per_render,
+        available
     ) );
-    spdlog::debug( "vkCreateImageView()" );
 
-    auto physical_device_properties = VkPhysicalDeviceProperties{ };
-    ::vkGetPhysicalDeviceProperties( setup_.physical_device, &physical_device_properties );
+    // Without calibrated timestamps, nothing is ever available.
+    if ( !available )
+    {
+        traced_frames.clear( );
+        return true;
+    }
 
-    auto const sampler_info = VkSamplerCreateInfo{
-        .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-        .pNext                   = nullptr,
-        .flags                   = 0U,
-        .magFilter               = VK_FILTER_LINEAR,
-        .minFilter               = VK_FILTER_LINEAR,
-        .mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-        .addressModeU            = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-        .addressModeV            = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-        .addressModeW            = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-        .mipLodBias              = 0.0F,
-        .anisotropyEnable        = VK_TRUE,
-        .maxAnisotropy           = physical_device_properties.limits.maxSamplerAnisotropy,
-        .compareEnable           = VK_FALSE,
-        .compareOp               = VK_COMPARE_OP_ALWAYS,
-        .minLod                  = 0.0F,
-        .maxLod                  = 0.0F,
-        .borderColor             = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
-        .unnormalizedCoordinates = VK_FALSE,
-    };
-    CHECK_VK( ::vkCreateSampler( setup_.device, &sampler_info, nullptr, &color_image_sampler_ ) );
+    // The end of the composite pass stands in for the frame reaching the display.
+    auto const composite_end_ns = timestamps_ns[ 1 ];
+    for ( auto const& traced : traced_frames )
+    {
+        auto const submit_ns = traced.record.cpu_timestamp_ns;
+        vlk::record_latency( composite_latency_, composite_end_ns - submit_ns );
+
+        auto const& layer = layers_.at( traced.layer_id );
+        if ( !traced.ring_generation || !layer.ring
+             || ( layer.ring->generation != traced.ring_generation.value( ) ) )
+        {
+            continue;
+        }
+
+        if ( auto const timing = vlk::find_frame_timing( *layer.ring, traced.record.frame_id );
+             timing )
+        {
+            vlk::record_latency( queue_latency_, composite_end_ns - timing->render_end_ns );
+        }
+    }
+    traced_frames.clear( );
+    return true;
+}
+
+auto App::render_frame( ) -> bool
+{
+    auto const frame = sync_.current_frame;
+
+    CHECK_TRUE( trace_frames( frame ) );
 
-    for ( auto i = 0U; i < max_frames_in_flight; ++i )
+    // Every layer's timelines are gathered into the one submit. Host ring uploads
+    // are ordered by the queue, so they don't use the shared timelines.
+    sync_.wait_timelines.clear( );
+    sync_.wait_values.clear( );
+    sync_.signal_timelines.clear( );
+    sync_.signal_values.clear( );
+
+    auto drawn_layers  = std::vector< std::pair< int32, vlk::RenderLayer > >{ };
+    auto traced_frames = std::vector< TracedFrame >{ };
+
+    // Only the parts of the output changed by newly latched frames are drawn again.
+    auto damage = damages_output_ ? std::optional< VkRect2D >{ } : std::optional{ VkRect2D{ } };
+    for ( auto& [ layer_id, layer ] : layers_ )
     {
-        auto const image_info = VkDescriptorImageInfo{
-            .sampler     = color_image_sampler_,
-            .imageView   = color_image_view_,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        };
-        auto const descriptor_writes = std::array{
-            VkWriteDescriptorSet{
-                .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                .pNext            = nullptr,
-                .dstSet           = pipeline_.descriptor_sets[ i ],
-                .dstBinding       = 0U,
-                .dstArrayElement  = 0U,
-                .descriptorCount  = 1U,
-                .descriptorType   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .pImageInfo       = &image_info,
-                .pBufferInfo      = nullptr,
-                .pTexelBufferView = nullptr,
-            },
-        };
+        auto const wait_count = sync_.wait_timelines.size( );
+        auto const slot       = latch_frame( layer );
+        report_frame_counts( layer_id, layer );
+        if ( !slot )
+        {
+            continue;
+        }
 
-        ::vkUpdateDescriptorSets(
-            setup_.device,
-            static_cast< uint32_t >( descriptor_writes.size( ) ),
-            descriptor_writes.data( ),
-            0U,
-            nullptr
+        auto* image      = VkImage{ };
+        auto* image_view = VkImageView{ };
+        auto  image_size = VkExtent2D{ };
+        auto  variant    = vlk::CompositeVariant{ };
+        if ( layer.host_ring )
+        {
+            image         = layer.host_ring->image.color_image;
+            image_view    = layer.host_ring->image.color_image_view;
+            image_size    = layer.host_ring->image.image_size;
+            variant.color = get_host_color( layer.host_ring->image.color_format );
+        }
+        else
+        {
+            image      = layer.ring->images[ slot.value( ) ].color_image;
+            image_view = layer.ring->images[ slot.value( ) ].color_image_view;
+            image_size = layer.ring->images[ slot.value( ) ].image_size;
+        }
+
+        if ( layer.descriptor_slots[ frame ] != slot )
+        {
+            update_descriptor_set( frame, layer, image_view, slot.value( ) );
+        }
+
+        // Each frame is traced by the first composite that draws it.
+        auto const& record = layer.host_ring ? layer.host_ring->latched_record
+                                             : layer.ring->latched_record;
+        if ( record && ( layer.traced_frame_id != record->frame_id ) )
+        {
+            layer.traced_frame_id = record->frame_id;
+            traced_frames.push_back( TracedFrame{
+                .layer_id        = layer_id,
+                .ring_generation = layer.host_ring ? std::nullopt
+                                                   : std::optional{ layer.ring->generation },
+                .record          = record.value( ),
+            } );
+        }
+
+        auto const& frame_id = layer.host_ring ? layer.host_ring->latched_frame_id
+                                               : layer.ring->latched_frame_id;
+        if ( layer.damaged_frame_id != frame_id )
+        {
+            layer.damaged_frame_id = frame_id;
+            if ( damage )
+            {
+                auto const layer_damage = get_output_damage(
+                    layer.uniforms,
+                    image_size,
+                    record,
+                    output_.framebuffer_size
+                );
+                damage = vlk::unite( damage.value( ), layer_damage );
+            }
+        }
+
+        // Only images of frames that were just latched change hands.
+        auto const acquires = ( nullptr == layer.host_ring )
+                           && ( sync_.wait_timelines.size( ) > wait_count );
+
+        drawn_layers.emplace_back(
+            layer.z_order,
+            vlk::RenderLayer{
+                .image            = image,
+                .transfer         = acquires ? vlk::OwnershipTransfer::Acquire
+                                             : vlk::OwnershipTransfer::None,
+                .descriptor_index = layer.descriptor_index,
+                .uniforms         = layer.uniforms,
+                .variant          = variant,
+            }
         );
     }
 
+    if ( drawn_layers.empty( ) )
+    {
+        return true;
+    }
+
+    // Layers are already in id order, so equal z-orders are drawn by id.
+    std::stable_sort(
+        drawn_layers.begin( ),
+        drawn_layers.end( ),
+        []( auto const& lhs, auto const& rhs ) { return lhs.first < rhs.first; }
+    );
+
+    auto render_layers = std::vector< vlk::RenderLayer >{ };
+    render_layers.reserve( drawn_layers.size( ) );
+    for ( auto const& drawn_layer : drawn_layers )
+    {
+        render_layers.push_back( drawn_layer.second );
+    }
+
+    sync_.damage = damage;
+    CHECK_TRUE( vlk::render(
+        setup_,
+        pipeline_,
+        std::span< vlk::RenderLayer const >{ render_layers },
+        output_,
+        sync_
+    ) );
+    traced_frames_[ frame ] = std::move( traced_frames );
+    damages_output_         = false;
+
+    sync_.current_frame = ( sync_.current_frame + 1U ) % max_frames_in_flight;
     return true;
 }
 
+auto App::destroy( ) -> void
+{
+    // Renders still in flight when run() failed may use anything destroyed below.
+    if ( nullptr != setup_.device )
+    {
+        utils::ignore( ::vkDeviceWaitIdle( setup_.device ) );
+    }
+
+    if ( nullptr != color_image_sampler_ )
+    {
+        ::vkDestroySampler( setup_.device, color_image_sampler_, nullptr );
+        spdlog::debug( "vkDestroySampler()" );
+    }
+
+    vlk::destroy( stream_ );
+
+    for ( auto& [ layer_id, layer ] : layers_ )
+    {
+        destroy_pending_rings( layer );
+        retire_displayed_rings( layer );
+    }
+    layers_.clear( );
+    for ( auto& retired : retired_rings_ )
+    {
+        retired.pending_frames = 0U;
+    }
+    destroy_retired_rings( );
+    vlk::destroy( import_cache_, setup_ );
+
+    vlk::destroy( timestamps_, setup_ );
+    vlk::destroy( sync_, setup_ );
+    vlk::destroy( pipeline_, setup_ );
+    vlk::destroy( output_, setup_ );
+    vlk::destroy( setup_ );
+}
+
 auto App::run( ) -> bool
 {
     spdlog::info( "Running render loop..." );
@@ -381,11 +1048,21 @@ auto App::run( ) -> bool
     while ( !should_exit )
     {
         ::glfwPollEvents( );
+        CHECK_TRUE( poll_producers( ) );
+
+        // The descriptor set of this frame can't change until the GPU is done with it.
+        CHECK_VK( ::vkWaitForFences(
+            setup_.device,
+            1U,
+            &sync_.graphics_queue_fences[ sync_.current_frame ],
+            VK_TRUE,
+            vlk::max_possible_timeout
+        ) );
 
-        // Render pipeline here.
-        CHECK_TRUE( vlk::render( setup_, pipeline_, output_, sync_ ) );
+        destroy_retired_rings( );
+        vlk::destroy_evicted( import_cache_, setup_.device );
 
-        sync_.current_frame = ( sync_.current_frame + 1U ) % max_frames_in_flight;
+        CHECK_TRUE( render_frame( ) );
 
         // This GLFW_KEY_ESCAPE bit shouldn't exist in a final product.
         should_exit = ( GLFW_TRUE == ::glfwWindowShouldClose( setup_.window ) )
@@ -404,22 +1081,28 @@ auto main( ltb::int32 const argc, char const* argv[] ) -> ltb::int32
 {
     spdlog::set_level( spdlog::level::debug );
 
+    auto arg_list = std::vector< char const* >( argv, argv + argc );
+
+    // Producers on other machines can stream to consumers started with --listen.
+    auto const listens_for_streams = ltb::utils::take_flag_from_args( arg_list, "--listen" );
+
+    // Usage: composite_app [--listen] [device index]
     auto physical_device_index = ltb::uint32{ 0 };
-    if ( !ltb::utils::get_physical_device_index_from_args(
-             { argv, static_cast< size_t >( argc ) },
-             physical_device_index
-         ) )
+    if ( !ltb::utils::get_physical_device_index_from_args( arg_list, physical_device_index ) )
     {
         return EXIT_FAILURE;
     }
 
-    if ( auto app = ltb::App( ); app.initialize( physical_device_index ) && app.run( ) )
+    if ( auto app = ltb::App( );
+         app.initialize( physical_device_index, listens_for_streams ) && app.run( ) )
     {
         spdlog::info( "Done." );
+        app.destroy( );
         return EXIT_SUCCESS;
     }
     else
     {
+        app.destroy( );
         return EXIT_FAILURE;
     }
 }
@@ -40,6 +40,7 @@ private:
     vlk::OutputData< vlk::AppType::Headless >     headless_output_   = { };
     vlk::PipelineData< vlk::Pipeline::Triangle >  triangle_pipeline_ = { };
     vlk::SyncData< vlk::AppType::Headless >       headless_sync_     = { };
+    VkSemaphore                                   frame_timeline_    = { };
 
     int32                                         color_image_fd_      = -1;
     vlk::ImageData< vlk::ExternalMemory::Import > imported_image_      = { };
@@ -64,17 +65,29 @@ auto App::initialize( uint32 const physical_device_index ) -> bool
     CHECK_TRUE( vlk::initialize( exported_image_, windowed_setup_, image_extents, unused_image_fd )
     );
     CHECK_TRUE( vlk::initialize( headless_output_, windowed_setup_, exported_image_ ) );
-    CHECK_TRUE( vlk::initialize( triangle_pipeline_, windowed_setup_, headless_output_ ) );
     CHECK_TRUE( vlk::initialize( headless_sync_, windowed_setup_ ) );
 
     // Display pipeline objects
+    CHECK_TRUE( vlk::initialize( windowed_sync_, windowed_setup_, max_frames_in_flight, 1U ) );
+
+    // Both render passes exist now, so the pipelines of both outputs are compiled together.
     CHECK_TRUE( vlk::initialize(
+        triangle_pipeline_,
         composite_pipeline_,
         windowed_setup_,
+        headless_output_,
+        1U,
         windowed_output_,
         max_frames_in_flight
     ) );
-    CHECK_TRUE( vlk::initialize( windowed_sync_, windowed_setup_, max_frames_in_flight ) );
+
+    // The offscreen render signals its frame number, which the display render waits on.
+    auto constexpr local_semaphore = vlk::ExternalMemory::None;
+    CHECK_TRUE( vlk::initialize_timeline( frame_timeline_, windowed_setup_.device, local_semaphore )
+    );
+    headless_sync_.signal_timeline = frame_timeline_;
+    windowed_sync_.wait_timelines  = { frame_timeline_ };
+    windowed_sync_.wait_values     = { 0U };
 
     CHECK_TRUE( initialize_image( ) );
 
@@ -134,7 +147,7 @@ auto App::initialize_image( ) -> bool
             VkWriteDescriptorSet{
                 .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
                 .pNext            = nullptr,
-                .dstSet           = composite_pipeline_.descriptor_sets[ i ],
+                .dstSet           = vlk::get_descriptor_set( composite_pipeline_, i, 0U ),
                 .dstBinding       = 0U,
                 .dstArrayElement  = 0U,
                 .descriptorCount  = 1U,
@@ -169,6 +182,7 @@ auto App::destroy( ) -> void
     // }
     vlk::destroy( imported_image_, windowed_setup_ );
 
+    vlk::destroy_timeline( frame_timeline_, windowed_setup_.device );
     vlk::destroy( headless_sync_, windowed_setup_ );
     vlk::destroy( triangle_pipeline_, windowed_setup_ );
     vlk::destroy( headless_output_, windowed_setup_ );
@@ -202,10 +216,19 @@ auto App::run( ) -> bool
         triangle_pipeline_.model_uniforms.scale_rotation_translation[ 1 ]
             = M_PI_2f * angular_velocity_rps * current_duration_s;
 
-        // Render offline triangle.
-        CHECK_TRUE(
-            vlk::render( windowed_setup_, triangle_pipeline_, headless_output_, headless_sync_ )
-        );
+        // Render offline triangle, signaling the next frame number on the timeline.
+        headless_sync_.reuse_value = headless_sync_.signal_value;
+        ++headless_sync_.signal_value;
+        CHECK_TRUE( vlk::render(
+            windowed_setup_,
+            triangle_pipeline_,
+            exported_image_,
+            headless_output_,
+            headless_sync_
+        ) );
+
+        // Every offline frame is displayed, so every display frame waits on it.
+        windowed_sync_.wait_values.front( ) = headless_sync_.signal_value;
 
         // Render pipeline here.
         CHECK_TRUE( vlk::render(
@@ -48,10 +48,7 @@ auto App::initialize( uint32 const physical_device_index ) -> bool
 
     // Display pipeline objects
     CHECK_TRUE( vlk::initialize( windowed_output_, setup_ ) );
-    CHECK_TRUE(
-        vlk::initialize( composite_pipeline_, setup_, windowed_output_, max_frames_in_flight )
-    );
-    CHECK_TRUE( vlk::initialize( windowed_sync_, setup_, max_frames_in_flight ) );
+    CHECK_TRUE( vlk::initialize( windowed_sync_, setup_, max_frames_in_flight, 1U ) );
 
     // Offscreen pipeline objects
     auto constexpr unused_image_fd = -1;
@@ -66,9 +63,19 @@ auto App::initialize( uint32 const physical_device_index ) -> bool
         unused_image_fd
     ) );
     CHECK_TRUE( vlk::initialize( headless_output_, setup_, shared_image_ ) );
-    CHECK_TRUE( vlk::initialize( triangle_pipeline_, setup_, headless_output_ ) );
     CHECK_TRUE( vlk::initialize( headless_sync_, setup_ ) );
 
+    // Both render passes exist now, so the pipelines of both outputs are compiled together.
+    CHECK_TRUE( vlk::initialize(
+        triangle_pipeline_,
+        composite_pipeline_,
+        setup_,
+        headless_output_,
+        1U,
+        windowed_output_,
+        max_frames_in_flight
+    ) );
+
     auto physical_device_properties = VkPhysicalDeviceProperties{ };
     ::vkGetPhysicalDeviceProperties( setup_.physical_device, &physical_device_properties );
 
@@ -105,7 +112,7 @@ auto App::initialize( uint32 const physical_device_index ) -> bool
             VkWriteDescriptorSet{
                 .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
                 .pNext            = nullptr,
-                .dstSet           = composite_pipeline_.descriptor_sets[ i ],
+                .dstSet           = vlk::get_descriptor_set( composite_pipeline_, i, 0U ),
                 .dstBinding       = 0U,
                 .dstArrayElement  = 0U,
                 .descriptorCount  = 1U,
@@ -3,13 +3,27 @@
 // /////////////////////////////////////////////////////////////
 
 // project
+#include "ltb/net/fd_message.hpp"
 #include "ltb/net/fd_socket.hpp"
 #include "ltb/utils/args.hpp"
+#include "ltb/utils/ignore.hpp"
 #include "ltb/vlk/check.hpp"
+#include "ltb/vlk/device_message.hpp"
+#include "ltb/vlk/host_ring.hpp"
+#include "ltb/vlk/layer.hpp"
 #include "ltb/vlk/render.hpp"
+#include "ltb/vlk/shared_ring.hpp"
+#include "ltb/vlk/stream.hpp"
+#include "ltb/vlk/timing.hpp"
 
 // standard
+#include <algorithm>
 #include <cerrno>
+#include <cmath>
+#include <limits>
+
+// platform
+#include <unistd.h>
 
 namespace ltb
 {
@@ -22,62 +36,388 @@ auto constexpr image_extents = VkExtent3D{
     .depth  = 1,
 };
 
-auto constexpr external_memory_handle_type = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+// One slot sampled by the consumer, one ready, one being rendered.
+auto constexpr ring_slot_count = 3U;
+
+// Mailbox consumers may sample a different slot in each of their frames in flight.
+auto constexpr mailbox_ring_slot_count = 4U;
+
+auto constexpr socket_path = "socket";
+
+// Short enough to keep polling for input while the consumer is behind.
+auto constexpr credit_timeout = std::chrono::milliseconds( 100 );
+
+// Stamped with the producer's steady clock when the frame is submitted.
+auto make_frame_record( uint64 const frame_id, uint32 const slot ) -> vlk::FrameRecord
+{
+    auto const submit_time = std::chrono::steady_clock::now( ).time_since_epoch( );
+
+    return vlk::FrameRecord{
+        .frame_id         = frame_id,
+        .ready_value      = frame_id + 1U,
+        .cpu_timestamp_ns = std::chrono::nanoseconds( submit_time ).count( ),
+        .slot             = slot,
+        .damage_count     = 0U,
+        .damage           = { },
+    };
+}
+
+// The pixels the triangle covers, matching the triangle shader, padded by a
+// pixel so rasterization at the edges is always inside.
+auto get_triangle_bounds( vlk::ModelUniforms const& model ) -> VkRect2D
+{
+    auto const [ scale, rotation, x, y ] = model.scale_rotation_translation;
+    auto constexpr vertex_count = vlk::PipelineData< vlk::Pipeline::Triangle >::vertex_count;
+
+    auto min_position = std::array{
+        std::numeric_limits< float32 >::max( ),
+        std::numeric_limits< float32 >::max( ),
+    };
+    auto max_position = std::array{
+        std::numeric_limits< float32 >::lowest( ),
+        std::numeric_limits< float32 >::lowest( ),
+    };
+    for ( auto vertex = 0U; vertex < vertex_count; ++vertex )
+    {
+        auto const angle = rotation - ( 2.0F * M_PIf / 3.0F * static_cast< float32 >( vertex ) );
+        auto const position = std::array{
+            ( std::cos( angle ) * scale ) + x,
+            ( std::sin( angle ) * scale ) + y,
+        };
+        for ( auto axis = 0U; axis < 2U; ++axis )
+        {
+            min_position[ axis ] = std::min( min_position[ axis ], position[ axis ] );
+            max_position[ axis ] = std::max( max_position[ axis ], position[ axis ] );
+        }
+    }
+
+    // Clip space runs from -1 to 1 across the image. Positions are clamped to just
+    // outside the image first so the conversions can't overflow.
+    auto const to_pixels = []( float32 const position, uint32 const size )
+    {
+        auto const pixels = ( position + 1.0F ) * 0.5F * static_cast< float32 >( size );
+        return std::clamp( pixels, -1.0F, static_cast< float32 >( size ) + 1.0F );
+    };
+    auto const width  = image_extents.width;
+    auto const height = image_extents.height;
+
+    auto const min_x = static_cast< int32 >( std::floor( to_pixels( min_position[ 0 ], width ) ) );
+    auto const min_y = static_cast< int32 >( std::floor( to_pixels( min_position[ 1 ], height ) ) );
+    auto const max_x = static_cast< int32 >( std::ceil( to_pixels( max_position[ 0 ], width ) ) );
+    auto const max_y = static_cast< int32 >( std::ceil( to_pixels( max_position[ 1 ], height ) ) );
+
+    auto const bounds = VkRect2D{
+        .offset = VkOffset2D{ .x = min_x - 1, .y = min_y - 1 },
+        .extent = VkExtent2D{
+            .width  = static_cast< uint32 >( max_x - min_x + 2 ),
+            .height = static_cast< uint32 >( max_y - min_y + 2 ),
+        },
+    };
+    return vlk::clip( bounds, VkExtent2D{ .width = width, .height = height } );
+}
+
+// Whether the last render submitted with the sync has finished running on the GPU.
+auto has_finished(
+    vlk::SyncData< vlk::AppType::Headless > const& sync,
+    VkDevice const&                                device,
+    bool&                                          finished
+) -> bool
+{
+    if ( nullptr != sync.signal_timeline )
+    {
+        auto value = uint64{ 0 };
+        CHECK_TRUE( vlk::get_timeline_value( value, device, sync.signal_timeline ) );
+        finished = ( value >= sync.signal_value );
+        return true;
+    }
+    finished = ( VK_SUCCESS == ::vkGetFenceStatus( device, sync.graphics_queue_fence ) );
+    return true;
+}
 
 } // namespace
 
 class App
 {
 public:
-    App( )                               = default;
-    App( App const& )                    = delete;
-    App( App&& )                         = delete;
-    auto operator=( App const& ) -> App& = delete;
-    auto operator=( App&& ) -> App&      = delete;
-    ~App( );
-
-    auto initialize( uint32 physical_device_index ) -> bool;
-
+    auto initialize(
+        uint32                                   physical_device_index,
+        vlk::LayerMessage const&                 layer,
+        vlk::RingMode                            ring_mode,
+        std::optional< std::string_view > const& stream_address
+    ) -> bool;
+    auto destroy( ) -> void;
     auto run( ) -> bool;
 
 private:
-    // Vulkan
-    vlk::SetupData< vlk::AppType::Headless >     setup_    = { };
-    vlk::PipelineData< vlk::Pipeline::Triangle > pipeline_ = { };
-    vlk::OutputData< vlk::AppType::Headless >    output_   = { };
-    vlk::SyncData< vlk::AppType::Headless >      sync_     = { };
+    // Vulkan data
+    vlk::SetupData< vlk::AppType::Headless >                 setup_    = { };
+    std::vector< vlk::OutputData< vlk::AppType::Headless > > outputs_  = { };
+    vlk::PipelineData< vlk::Pipeline::Triangle >             pipeline_ = { };
+    std::vector< vlk::SyncData< vlk::AppType::Headless > >   syncs_    = { };
+
+    // Frames are rendered straight into shared device memory whenever the consumer can
+    // import it, and are copied through shared host memory otherwise.
+    vlk::SharedRingData< vlk::ExternalMemory::Export > ring_           = { };
+    vlk::HostRingData< vlk::ExternalMemory::Export >   host_ring_      = { };
+    bool                                               uses_host_ring_ = false;
+
+    // Consumers on other machines are streamed the frames copied to the host ring.
+    vlk::StreamData< vlk::ExternalMemory::Export > stream_ = { };
+
+    // The record of the last frame rendered into each slot, until its timestamps are read.
+    vlk::TimestampData                               timestamps_    = { };
+    std::vector< std::optional< vlk::FrameRecord > > traced_frames_ = { };
+
+    vlk::LatencyHistogram render_latency_ = { .name = "Producer submit to render end" };
+
+    // Where the triangle was drawn in the last frame handed to the consumer.
+    std::optional< VkRect2D > previous_bounds_ = { };
 
     // Networking
-    net::FdSocket socket_         = { };
-    int32         color_image_fd_ = -1;
+    net::FdSocket socket_ = { };
+
+    auto initialize_stream( vlk::LayerMessage const& layer, std::string_view address ) -> bool;
+    auto receive_device( vlk::DeviceId& consumer_device_id ) -> bool;
+    auto share_device_memory( vlk::RingMode ring_mode, vlk::TransportStatus& status ) -> bool;
+    auto share_host_memory( ) -> bool;
+    auto receive_reply( vlk::TransportStatus& status ) -> bool;
+
+    template < vlk::ExternalMemory mem_type >
+    auto initialize_outputs( std::vector< vlk::ImageData< mem_type > > const& images ) -> bool;
+
+    auto trace_frames( ) -> bool;
+    auto add_triangle_damage( vlk::FrameRecord& record ) -> void;
+    auto render_to_shared_ring( ) -> bool;
+    auto render_to_host_ring( ) -> bool;
 };
 
-App::~App( )
+auto App::initialize(
+    uint32 const                             physical_device_index,
+    vlk::LayerMessage const&                 layer,
+    vlk::RingMode const                      ring_mode,
+    std::optional< std::string_view > const& stream_address
+) -> bool
 {
-    if ( ( -1 != color_image_fd_ ) && ( ::close( color_image_fd_ ) < 0 ) )
+    if ( stream_address )
     {
-        spdlog::error( "close(color_image_fd) failed: {}", std::strerror( errno ) );
+        CHECK_TRUE( vlk::initialize( setup_, physical_device_index ) );
+        return initialize_stream( layer, stream_address.value( ) );
     }
 
-    vlk::destroy( setup_, sync_ );
-    vlk::destroy( setup_, output_ );
-    vlk::destroy( setup_, pipeline_ );
-    vlk::destroy( setup_ );
+    CHECK_TRUE( socket_.initialize( ) && socket_.connect( socket_path ) );
+
+    // The device the consumer renders with is used whenever it's available here,
+    // and the index is only used if it isn't.
+    auto consumer_device_id = vlk::DeviceId{ };
+    CHECK_TRUE( receive_device( consumer_device_id ) );
+    CHECK_TRUE( vlk::initialize( setup_, physical_device_index, consumer_device_id ) );
+
+    // The consumer composites every producer, so it's told where this one goes first.
+    CHECK_TRUE( socket_.send( std::as_bytes( std::span{ &layer, 1U } ), { } ) );
+
+    // Rings on another device could never be imported, so they aren't offered.
+    auto status = vlk::TransportStatus::Fallback;
+    if ( setup_.device_id == consumer_device_id )
+    {
+        CHECK_TRUE( share_device_memory( ring_mode, status ) );
+    }
+
+    if ( vlk::TransportStatus::Accepted == status )
+    {
+        CHECK_TRUE( initialize_outputs( ring_.images ) );
+
+        // Renders signal the frame number on the ring's timeline instead of using the
+        // fence, and wait for the consumer's credit on the released timeline.
+        for ( auto& sync : syncs_ )
+        {
+            sync.signal_timeline = ring_.ready_timeline;
+            sync.credit_timeline = ring_.released_timeline;
+        }
+    }
+    else
+    {
+        vlk::destroy( ring_, setup_ );
+        CHECK_TRUE( share_host_memory( ) );
+        CHECK_TRUE( initialize_outputs( host_ring_.images ) );
+        uses_host_ring_ = true;
+    }
+
+    return true;
 }
 
-auto App::initialize( uint32 const physical_device_index ) -> bool
+auto App::initialize_stream( vlk::LayerMessage const& layer, std::string_view const address )
+    -> bool
 {
-    CHECK_TRUE( vlk::initialize( physical_device_index, setup_ ) );
-    CHECK_TRUE(
-        vlk::initialize< vlk::AppType::Headless >( setup_.color_format, setup_.device, pipeline_ )
+    // Frames are read back through a host ring as usual, then streamed from there.
+    CHECK_TRUE( vlk::initialize( host_ring_, setup_, image_extents, ring_slot_count ) );
+    CHECK_TRUE( initialize_outputs( host_ring_.images ) );
+    CHECK_TRUE( vlk::initialize( stream_, host_ring_, layer, address, vlk::default_stream_port ) );
+    uses_host_ring_ = true;
+
+    return true;
+}
+
+auto App::receive_device( vlk::DeviceId& consumer_device_id ) -> bool
+{
+    auto message = vlk::DeviceMessage{ };
+    auto fds     = std::vector< int32 >{ };
+    CHECK_TRUE( socket_.receive( std::as_writable_bytes( std::span{ &message, 1U } ), fds ) );
+
+    // Device messages never carry file descriptors.
+    net::close_all( fds );
+
+    if ( ( vlk::device_message_magic != message.magic )
+         || ( vlk::device_message_version != message.version ) )
+    {
+        spdlog::error( "Unexpected device message" );
+        return false;
+    }
+    consumer_device_id = message.device_id;
+    return true;
+}
+
+auto App::share_device_memory( vlk::RingMode const ring_mode, vlk::TransportStatus& status )
+    -> bool
+{
+    // Dma-bufs can be imported by other drivers and APIs, so they're used whenever possible.
+    auto const handle_type
+        = setup_.supports_dma_buf ? vlk::ExternalHandle::DmaBuf : vlk::ExternalHandle::OpaqueFd;
+
+    auto const slot_count
+        = ( vlk::RingMode::Mailbox == ring_mode ) ? mailbox_ring_slot_count : ring_slot_count;
+
+    if ( !vlk::initialize( ring_, setup_, image_extents, handle_type, ring_mode, slot_count ) )
+    {
+        spdlog::warn( "Device memory can't be exported, falling back to host memory" );
+        status = vlk::TransportStatus::Fallback;
+        return true;
+    }
+
+    auto message  = vlk::SharedRingMessage{ };
+    auto ring_fds = std::vector< int32 >{ };
+    CHECK_TRUE( vlk::get_message( message, ring_fds, setup_, ring_ ) );
+
+    // The whole ring is handed over in a single message.
+    auto const sent = socket_.send( std::as_bytes( std::span{ &message, 1U } ), ring_fds );
+    net::close_all( ring_fds );
+    CHECK_TRUE( sent );
+
+    CHECK_TRUE( receive_reply( status ) );
+    if ( vlk::TransportStatus::Accepted == status )
+    {
+        spdlog::info( "Sent shared ring with {} slots", ring_.images.size( ) );
+    }
+    else
+    {
+        spdlog::warn( "The consumer can't import device memory, falling back to host memory" );
+    }
+    return true;
+}
+
+auto App::share_host_memory( ) -> bool
+{
+    CHECK_TRUE( vlk::initialize( host_ring_, setup_, image_extents, ring_slot_count ) );
+
+    auto message   = vlk::HostRingMessage{ };
+    auto memory_fd = int32{ -1 };
+    CHECK_TRUE( vlk::get_message( message, memory_fd, host_ring_ ) );
+
+    auto const sent = socket_.send(
+        std::as_bytes( std::span{ &message, 1U } ),
+        std::span{ &memory_fd, 1U }
     );
+    utils::ignore( ::close( memory_fd ) );
+    CHECK_TRUE( sent );
+
+    auto status = vlk::TransportStatus::Fallback;
+    CHECK_TRUE( receive_reply( status ) );
+    if ( vlk::TransportStatus::Accepted != status )
+    {
+        spdlog::error( "The consumer refused the host ring" );
+        return false;
+    }
+    spdlog::info( "Sent host ring with {} slots", host_ring_.images.size( ) );
+
+    return true;
+}
+
+auto App::receive_reply( vlk::TransportStatus& status ) -> bool
+{
+    auto reply = vlk::TransportReply{ };
+    auto fds   = std::vector< int32 >{ };
+    CHECK_TRUE( socket_.receive( std::as_writable_bytes( std::span{ &reply, 1U } ), fds ) );
+
+    // Replies never carry file descriptors.
+    net::close_all( fds );
+
+    if ( ( vlk::transport_reply_magic != reply.magic )
+         || ( ( vlk::TransportStatus::Accepted != reply.status )
+              && ( vlk::TransportStatus::Fallback != reply.status ) ) )
+    {
+        spdlog::error( "Unexpected transport reply" );
+        return false;
+    }
+    status = reply.status;
+    return true;
+}
+
+template < vlk::ExternalMemory mem_type >
+auto App::initialize_outputs( std::vector< vlk::ImageData< mem_type > > const& images ) -> bool
+{
+    // One framebuffer and one command buffer per slot so
+    // each slot can be rendered independently of the others.
+    outputs_.resize( images.size( ) );
+    syncs_.resize( images.size( ) );
+    traced_frames_.resize( images.size( ) );
+
+    auto const slot_count = static_cast< uint32 >( images.size( ) );
     CHECK_TRUE(
-        vlk::initialize( image_extents, vlk::ExternalMemory::Yes, setup_, pipeline_, output_ )
+        vlk::initialize( timestamps_, setup_, slot_count * vlk::timestamp_queries_per_render )
     );
-    CHECK_TRUE( vlk::initialize( setup_.device, setup_.graphics_command_pool, sync_ ) );
+
+    for ( auto slot = 0U; slot < slot_count; ++slot )
+    {
+        CHECK_TRUE( vlk::initialize( outputs_[ slot ], setup_, images[ slot ] ) );
+        CHECK_TRUE( vlk::initialize( syncs_[ slot ], setup_ ) );
+
+        syncs_[ slot ].timestamp_queries     = timestamps_.query_pool;
+        syncs_[ slot ].first_timestamp_query = slot * vlk::timestamp_queries_per_render;
+
+        // Slots are rendered at the same time, so each reads its own uniforms. Only the
+        // triangle's uniforms change between frames, so the commands are recorded once.
+        syncs_[ slot ].frame_index     = slot;
+        syncs_[ slot ].reuses_commands = true;
+    }
+    CHECK_TRUE( vlk::initialize( pipeline_, setup_, outputs_.front( ), slot_count ) );
+
     return true;
 }
 
+auto App::destroy( ) -> void
+{
+    for ( auto& sync : syncs_ )
+    {
+        vlk::destroy( sync, setup_ );
+    }
+    syncs_.clear( );
+    traced_frames_.clear( );
+
+    vlk::destroy( timestamps_, setup_ );
+    vlk::destroy( pipeline_, setup_ );
+
+    for ( auto& output : outputs_ )
+    {
+        vlk::destroy( output, setup_ );
+    }
+    outputs_.clear( );
+
+    // The stream reads the host ring's memory until its threads stop.
+    vlk::destroy( stream_ );
+    vlk::destroy( host_ring_, setup_ );
+    vlk::destroy( ring_, setup_ );
+    vlk::destroy( setup_ );
+}
+
 auto App::run( ) -> bool
 {
     auto app_should_exit = false;
@@ -104,58 +444,157 @@ auto App::run( ) -> bool
             spdlog::error( "read() failed: {}", std::strerror( errno ) );
             app_should_exit = true;
         }
+
+        auto const current_duration = start_time - std::chrono::steady_clock::now( );
+        auto const current_duration_s
+            = std::chrono::duration_cast< FloatSeconds >( current_duration ).count( );
+
+        pipeline_.model_uniforms.scale_rotation_translation[ 1 ]
+            = M_PI_2f * angular_velocity_rps * current_duration_s;
+
+        CHECK_TRUE( trace_frames( ) );
+
+        if ( vlk::has_failed( stream_ ) )
+        {
+            spdlog::error( "Streaming to the consumer failed" );
+            return false;
+        }
+
+        if ( uses_host_ring_ )
+        {
+            CHECK_TRUE( render_to_host_ring( ) );
+        }
         else
         {
-            // The buffer is empty or EAGAIN was returned (implying non-blocking input checks)
+            CHECK_TRUE( render_to_shared_ring( ) );
+        }
+    }
+
+    CHECK_VK( ::vkDeviceWaitIdle( setup_.device ) );
+    spdlog::info( "Exiting..." );
+    return true;
+}
+
+auto App::trace_frames( ) -> bool
+{
+    for ( auto slot = 0U; slot < traced_frames_.size( ); ++slot )
+    {
+        auto& traced_frame = traced_frames_[ slot ];
+        if ( !traced_frame )
+        {
+            continue;
+        }
 
-            auto const current_duration = start_time - std::chrono::steady_clock::now( );
-            auto const current_duration_s
-                = std::chrono::duration_cast< FloatSeconds >( current_duration ).count( );
+        // The queries are reset by the commands of the slot's new render, so until it's
+        // finished, the slot's timestamps may still be the previous frame's.
+        auto finished = false;
+        CHECK_TRUE( has_finished( syncs_[ slot ], setup_.device, finished ) );
+        if ( !finished )
+        {
+            continue;
+        }
 
-            pipeline_.model_uniforms.scale_rotation_translation[ 1 ]
-                = M_PI_2f * angular_velocity_rps * current_duration_s;
+        auto timestamps_ns = std::array< int64, vlk::timestamp_queries_per_render >{ };
+        auto available     = false;
+        CHECK_TRUE( vlk::get_timestamps_ns(
+            timestamps_ns,
+            timestamps_,
+            setup_.device,
+            syncs_[ slot ].first_timestamp_query,
+            available
+        ) );
+        if ( !available )
+        {
+            continue;
         }
 
-        // Render pipeline here.
-        CHECK_TRUE( vlk::render( setup_, pipeline_, output_, sync_ ) );
+        vlk::record_latency( render_latency_, timestamps_ns[ 1 ] - traced_frame->cpu_timestamp_ns );
 
-        if ( -1 == color_image_fd_ )
+        // The consumer measures how long finished frames wait before they're composited.
+        auto const timing = vlk::FrameTiming{
+            .frame_id        = traced_frame->frame_id,
+            .render_start_ns = timestamps_ns[ 0 ],
+            .render_end_ns   = timestamps_ns[ 1 ],
+        };
+        if ( !uses_host_ring_ && !vlk::publish_timing( ring_, timing ) )
         {
-            CHECK_VK( ::vkDeviceWaitIdle( setup_.device ) );
-
-            auto* const vkGetMemoryFdKHR = reinterpret_cast< PFN_vkGetMemoryFdKHR >(
-                ::vkGetInstanceProcAddr( setup_.instance, "vkGetMemoryFdKHR" )
-            );
-            if ( nullptr == vkGetMemoryFdKHR )
-            {
-                spdlog::error( "vkGetInstanceProcAddr() failed" );
-                return false;
-            }
-
-            auto const memory_info = VkMemoryGetFdInfoKHR{
-                .sType      = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
-                .pNext      = nullptr,
-                .memory     = output_.color_image_memory,
-                .handleType = external_memory_handle_type,
-            };
-            CHECK_VK( vkGetMemoryFdKHR( setup_.device, &memory_info, &color_image_fd_ ) );
-            spdlog::debug( "vkGetMemoryFdKHR()" );
-
-            spdlog::info( "Color image file descriptor: {}", color_image_fd_ );
-
-            if ( !socket_.initialize( ) )
-            {
-                return false;
-            }
-            if ( !socket_.connect_and_send( "socket", color_image_fd_ ) )
-            {
-                return false;
-            }
+            spdlog::debug( "Frame timing queue is full, skipping timing" );
         }
+        traced_frame = std::nullopt;
     }
+    return true;
+}
 
-    CHECK_VK( ::vkDeviceWaitIdle( setup_.device ) );
-    spdlog::info( "Exiting..." );
+auto App::add_triangle_damage( vlk::FrameRecord& record ) -> void
+{
+    // The triangle is cleared where it was and drawn where it is. The first
+    // frame has nothing to compare against, so all of it is damaged.
+    auto const bounds = get_triangle_bounds( pipeline_.model_uniforms );
+    if ( previous_bounds_ )
+    {
+        vlk::add_damage( record, previous_bounds_.value( ) );
+        vlk::add_damage( record, bounds );
+    }
+    previous_bounds_ = bounds;
+}
+
+auto App::render_to_shared_ring( ) -> bool
+{
+    // Only stall while the consumer holds every slot, and only for a bit so input is polled.
+    auto has_credit = false;
+    CHECK_TRUE( vlk::wait_for_credit( ring_, setup_.device, credit_timeout, has_credit ) );
+
+    // Skip this iteration if there's still no credit, or no free slot in mailbox rings.
+    auto slot         = uint32{ 0 };
+    auto ready_value  = uint64{ 0 };
+    auto credit_value = uint64{ 0 };
+    if ( has_credit && vlk::acquire_render_slot( ring_, slot, ready_value, credit_value ) )
+    {
+        // The slot's command buffer can be reused once its last frame is ready
+        // and the consumer released the frame that last used the slot.
+        auto& sync        = syncs_[ slot ];
+        sync.reuse_value  = sync.signal_value;
+        sync.signal_value = ready_value;
+        sync.credit_value = credit_value;
+
+        auto record = make_frame_record( ready_value - 1U, slot );
+        add_triangle_damage( record );
+        if ( !vlk::publish_frame( ring_, record ) )
+        {
+            spdlog::debug( "Frame record queue is full, skipping metadata" );
+        }
+
+        CHECK_TRUE(
+            vlk::render( setup_, pipeline_, ring_.images[ slot ], outputs_[ slot ], sync )
+        );
+        traced_frames_[ slot ] = record;
+    }
+    return true;
+}
+
+auto App::render_to_host_ring( ) -> bool
+{
+    // Finished readbacks are handed to the consumer before their slots are reused.
+    CHECK_TRUE( vlk::publish_frames( host_ring_, setup_.device ) );
+
+    auto slot     = uint32{ 0 };
+    auto frame_id = uint64{ 0 };
+    if ( vlk::acquire_render_slot( host_ring_, slot, frame_id ) )
+    {
+        auto record = make_frame_record( frame_id, slot );
+        add_triangle_damage( record );
+        CHECK_TRUE( vlk::render(
+            setup_,
+            pipeline_,
+            host_ring_.images[ slot ],
+            outputs_[ slot ],
+            syncs_[ slot ]
+        ) );
+        CHECK_TRUE(
+            vlk::submit_readback( host_ring_, setup_.device, setup_.graphics_queue, record )
+        );
+        traced_frames_[ slot ] = record;
+    }
     return true;
 }
 
@@ -163,24 +602,51 @@ auto App::run( ) -> bool
 
 auto main( ltb::int32 const argc, char const* argv[] ) -> ltb::int32
 {
-    spdlog::set_level( spdlog::level::trace );
+    spdlog::set_level( spdlog::level::debug );
+
+    auto arg_list = std::vector< char const* >( argv, argv + argc );
+
+    // Live previews pass --mailbox to always show the newest frame instead of every frame.
+    auto const ring_mode = ltb::utils::take_flag_from_args( arg_list, "--mailbox" )
+                             ? ltb::vlk::RingMode::Mailbox
+                             : ltb::vlk::RingMode::Fifo;
+
+    // Consumers on other machines are streamed to with --stream <IPv4 address>.
+    auto stream_address = std::optional< std::string_view >{ };
+    if ( !ltb::utils::take_option_from_args( arg_list, "--stream", stream_address ) )
+    {
+        return EXIT_FAILURE;
+    }
 
+    // The device index is only used if no device matches the consumer's.
+    // Usage: frames_app [--mailbox] [--stream address] [device index] [layer id] [z-order]
+    //                   [x] [y] [width] [height] [opacity]
+    auto const args = std::span< char const* >{ arg_list };
     auto physical_device_index = ltb::uint32{ 0 };
-    if ( !ltb::utils::get_physical_device_index_from_args(
-             { argv, static_cast< size_t >( argc ) },
-             physical_device_index
-         ) )
+    auto layer                 = ltb::vlk::LayerMessage{ };
+    if ( !ltb::utils::get_physical_device_index_from_args( args, physical_device_index )
+         || !ltb::utils::get_number_from_args( args, 2U, layer.layer_id )
+         || !ltb::utils::get_number_from_args( args, 3U, layer.z_order )
+         || !ltb::utils::get_number_from_args( args, 4U, layer.rect[ 0 ] )
+         || !ltb::utils::get_number_from_args( args, 5U, layer.rect[ 1 ] )
+         || !ltb::utils::get_number_from_args( args, 6U, layer.rect[ 2 ] )
+         || !ltb::utils::get_number_from_args( args, 7U, layer.rect[ 3 ] )
+         || !ltb::utils::get_number_from_args( args, 8U, layer.opacity ) )
     {
         return EXIT_FAILURE;
     }
 
-    if ( auto app = ltb::App( ); app.initialize( physical_device_index ) && app.run( ) )
+    if ( auto app = ltb::App( );
+         app.initialize( physical_device_index, layer, ring_mode, stream_address )
+         && app.run( ) )
     {
         spdlog::info( "Done." );
+        app.destroy( );
         return EXIT_SUCCESS;
     }
     else
     {
+        app.destroy( );
         return EXIT_FAILURE;
     }
 }
@@ -0,0 +1,204 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/net/fd_message.hpp"
+
+// project
+#include "ltb/utils/ignore.hpp"
+
+// external
+#include <spdlog/spdlog.h>
+
+// standard
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+// platform
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ltb::net
+{
+namespace
+{
+
+struct Data
+{
+    msghdr                 msg = { };
+    std::array< iovec, 1 > iov = { };
+
+    alignas( cmsghdr ) std::array< char, CMSG_SPACE( sizeof( int32 ) * max_fds_per_message ) > cmsg
+        = { };
+
+    explicit Data( std::span< std::byte const > const payload )
+    {
+        // The same iovec is the source for sendmsg() and the destination for recvmsg().
+        iov[ 0 ].iov_base = const_cast< std::byte* >( payload.data( ) );
+        iov[ 0 ].iov_len  = payload.size( );
+
+        msg.msg_control    = cmsg.data( );
+        msg.msg_controllen = sizeof( cmsg );
+        msg.msg_name       = nullptr;
+        msg.msg_namelen    = 0;
+        msg.msg_flags      = 0;
+        msg.msg_iov        = iov.data( );
+        msg.msg_iovlen     = iov.size( );
+    }
+};
+
+} // namespace
+
+auto initialize_socket_name( std::string_view const socket_path, sockaddr_un& socket_name )
+    -> bool
+{
+    if ( socket_path.length( ) > ( sizeof( sockaddr_un::sun_path ) - 1 ) )
+    {
+        spdlog::error( "socket path too long" );
+        return false;
+    }
+
+    socket_name.sun_family = AF_UNIX;
+    utils::ignore( std::strncpy( socket_name.sun_path, socket_path.data( ), socket_path.length( ) )
+    );
+
+    return true;
+}
+
+auto send_message(
+    int32 const                        socket_fd,
+    std::span< std::byte const > const payload,
+    std::span< int32 const > const     fds
+) -> bool
+{
+    if ( fds.size( ) > max_fds_per_message )
+    {
+        spdlog::error( "Too many file descriptors: {}", fds.size( ) );
+        return false;
+    }
+    if ( payload.size( ) > max_message_payload_size )
+    {
+        spdlog::error( "Payload too large: {} bytes", payload.size( ) );
+        return false;
+    }
+    if ( payload.empty( ) && fds.empty( ) )
+    {
+        // An empty message is indistinguishable from the connection closing.
+        spdlog::error( "Nothing to send" );
+        return false;
+    }
+
+    auto data = Data{ payload };
+
+    if ( fds.empty( ) )
+    {
+        data.msg.msg_control    = nullptr;
+        data.msg.msg_controllen = 0U;
+    }
+    else
+    {
+        // Only the space needed for these fds is sent.
+        auto const fds_byte_count = fds.size_bytes( );
+        data.msg.msg_controllen   = CMSG_SPACE( fds_byte_count );
+
+        auto* const cmptr = CMSG_FIRSTHDR( &data.msg );
+        if ( nullptr == cmptr )
+        {
+            spdlog::error( "CMSG_FIRSTHDR() failed" );
+            return false;
+        }
+        cmptr->cmsg_len   = CMSG_LEN( fds_byte_count );
+        cmptr->cmsg_level = SOL_SOCKET;
+        cmptr->cmsg_type  = SCM_RIGHTS;
+        utils::ignore( std::memcpy( CMSG_DATA( cmptr ), fds.data( ), fds_byte_count ) );
+    }
+
+    // MSG_NOSIGNAL turns a closed peer into an EPIPE error instead of killing the process.
+    if ( ::sendmsg( socket_fd, &data.msg, MSG_NOSIGNAL ) < 0 )
+    {
+        spdlog::error( "sendmsg() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+    spdlog::debug( "sendmsg() w/ {} bytes and {} fds", payload.size( ), fds.size( ) );
+
+    return true;
+}
+
+auto receive_message(
+    int32 const                  socket_fd,
+    std::span< std::byte > const payload,
+    size_t&                      payload_size,
+    std::vector< int32 >&        fds_out
+) -> ReceiveStatus
+{
+    payload_size = 0U;
+    fds_out.clear( );
+
+    auto data = Data{ payload };
+
+    // Received fds are close-on-exec so they don't leak into child processes.
+    auto const bytes_received = ::recvmsg( socket_fd, &data.msg, MSG_CMSG_CLOEXEC );
+    if ( bytes_received < 0 )
+    {
+        if ( ( EAGAIN == errno ) || ( EWOULDBLOCK == errno ) )
+        {
+            return ReceiveStatus::WouldBlock;
+        }
+        if ( ECONNRESET == errno )
+        {
+            return ReceiveStatus::Closed;
+        }
+        spdlog::error( "recvmsg() failed: {}", std::strerror( errno ) );
+        return ReceiveStatus::Failed;
+    }
+
+    // Take ownership of any fds before validating so they can be closed on failure.
+    for ( auto* cmptr = CMSG_FIRSTHDR( &data.msg ); nullptr != cmptr;
+          cmptr       = CMSG_NXTHDR( &data.msg, cmptr ) )
+    {
+        if ( ( SOL_SOCKET == cmptr->cmsg_level ) && ( SCM_RIGHTS == cmptr->cmsg_type ) )
+        {
+            auto const fd_count = ( cmptr->cmsg_len - CMSG_LEN( 0U ) ) / sizeof( int32 );
+            auto const offset   = fds_out.size( );
+            fds_out.resize( offset + fd_count );
+            utils::ignore( std::memcpy(
+                fds_out.data( ) + offset,
+                CMSG_DATA( cmptr ),
+                fd_count * sizeof( int32 )
+            ) );
+        }
+    }
+
+    if ( ( 0 == bytes_received ) && fds_out.empty( ) )
+    {
+        return ReceiveStatus::Closed;
+    }
+    spdlog::debug( "recvmsg() w/ {} bytes and {} fds", bytes_received, fds_out.size( ) );
+
+    if ( 0 != ( data.msg.msg_flags & MSG_CTRUNC ) )
+    {
+        spdlog::error( "Received too many file descriptors" );
+        close_all( fds_out );
+        return ReceiveStatus::Failed;
+    }
+    if ( 0 != ( data.msg.msg_flags & MSG_TRUNC ) )
+    {
+        spdlog::error( "Received a payload larger than {} bytes", payload.size( ) );
+        close_all( fds_out );
+        return ReceiveStatus::Failed;
+    }
+
+    payload_size = static_cast< size_t >( bytes_received );
+    return ReceiveStatus::Received;
+}
+
+auto close_all( std::vector< int32 >& fds ) -> void
+{
+    for ( auto const fd : fds )
+    {
+        utils::ignore( ::close( fd ) );
+    }
+    fds.clear( );
+}
+
+} // namespace ltb::net
@@ -0,0 +1,284 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/net/fd_server.hpp"
+
+// project
+#include "ltb/utils/ignore.hpp"
+
+// external
+#include <spdlog/spdlog.h>
+
+// standard
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+// platform
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ltb::net
+{
+namespace
+{
+
+// Connection ids start at 1 so the listening socket can use 0.
+auto constexpr listen_socket_id = uint64{ 0 };
+
+auto constexpr max_events_per_poll = 64U;
+auto constexpr listen_backlog      = 64;
+
+} // namespace
+
+FdServer::~FdServer( )
+{
+    while ( !connections_.empty( ) )
+    {
+        close_connection( connections_.begin( )->first );
+    }
+
+    if ( -1 != epoll_fd_ )
+    {
+        utils::ignore( ::close( epoll_fd_ ) );
+    }
+
+    if ( -1 != listen_socket_fd_ )
+    {
+        utils::ignore( ::close( listen_socket_fd_ ) );
+        utils::ignore( ::unlink( socket_path_.c_str( ) ) );
+    }
+}
+
+auto FdServer::initialize( std::string_view const socket_path ) -> bool
+{
+    auto socket_name = sockaddr_un{ };
+    if ( !initialize_socket_name( socket_path, socket_name ) )
+    {
+        return false;
+    }
+    socket_path_ = std::string( socket_path );
+
+    if ( ( ::unlink( socket_path_.c_str( ) ) < 0 ) && ( ENOENT != errno ) )
+    {
+        spdlog::error( "unlink() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    if ( listen_socket_fd_ = ::socket( PF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+         listen_socket_fd_ < 0 )
+    {
+        spdlog::error( "socket() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    spdlog::debug( "Binding to socket: {}", socket_name.sun_path );
+    if ( ::bind(
+             listen_socket_fd_,
+             reinterpret_cast< sockaddr* >( &socket_name ),
+             sizeof( socket_name )
+         )
+         < 0 )
+    {
+        spdlog::error( "bind() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    if ( ::listen( listen_socket_fd_, listen_backlog ) < 0 )
+    {
+        spdlog::error( "listen() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    if ( epoll_fd_ = ::epoll_create1( EPOLL_CLOEXEC ); epoll_fd_ < 0 )
+    {
+        spdlog::error( "epoll_create1() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    auto listen_event     = epoll_event{ };
+    listen_event.events   = EPOLLIN;
+    listen_event.data.u64 = listen_socket_id;
+    if ( ::epoll_ctl( epoll_fd_, EPOLL_CTL_ADD, listen_socket_fd_, &listen_event ) < 0 )
+    {
+        spdlog::error( "epoll_ctl() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    receive_buffer_.resize( max_message_payload_size );
+
+    return true;
+}
+
+auto FdServer::poll( std::vector< FdServerEvent >& events ) -> bool
+{
+    events.clear( );
+
+    auto       ready_events = std::array< epoll_event, max_events_per_poll >{ };
+    auto const ready_count
+        = ::epoll_wait( epoll_fd_, ready_events.data( ), max_events_per_poll, 0 );
+    if ( ready_count < 0 )
+    {
+        if ( EINTR == errno )
+        {
+            return true;
+        }
+        spdlog::error( "epoll_wait() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    for ( auto i = 0U; i < static_cast< uint32 >( ready_count ); ++i )
+    {
+        auto const& ready_event = ready_events[ i ];
+        auto const  id          = ready_event.data.u64;
+
+        if ( listen_socket_id == id )
+        {
+            if ( !accept_connections( events ) )
+            {
+                return false;
+            }
+            continue;
+        }
+
+        // Anything still buffered is read before a hangup is handled.
+        auto still_connected = read_messages( id, events );
+        if ( 0U != ( ready_event.events & ( EPOLLHUP | EPOLLRDHUP | EPOLLERR ) ) )
+        {
+            still_connected = false;
+        }
+
+        if ( !still_connected )
+        {
+            spdlog::info(
+                "Connection {} closed after {} messages",
+                id,
+                connections_.at( id ).messages_received
+            );
+            close_connection( id );
+            events.push_back( FdServerEvent{
+                .type          = FdServerEventType::Disconnected,
+                .connection_id = id,
+                .payload       = { },
+                .fds           = { },
+            } );
+        }
+    }
+
+    return true;
+}
+
+auto FdServer::send(
+    uint64 const                       connection_id,
+    std::span< std::byte const > const payload,
+    std::span< int32 const > const     fds
+) -> bool
+{
+    auto const connection = connections_.find( connection_id );
+    if ( connections_.end( ) == connection )
+    {
+        spdlog::error( "Unknown connection: {}", connection_id );
+        return false;
+    }
+    return send_message( connection->second.socket_fd, payload, fds );
+}
+
+auto FdServer::disconnect( uint64 const connection_id ) -> void
+{
+    if ( connections_.contains( connection_id ) )
+    {
+        close_connection( connection_id );
+    }
+}
+
+auto FdServer::connection_count( ) const -> size_t
+{
+    return connections_.size( );
+}
+
+auto FdServer::accept_connections( std::vector< FdServerEvent >& events ) -> bool
+{
+    // The listening socket is non-blocking, so accept until nothing is pending.
+    while ( true )
+    {
+        auto const socket_fd
+            = ::accept4( listen_socket_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+        if ( socket_fd < 0 )
+        {
+            if ( ( EAGAIN == errno ) || ( EWOULDBLOCK == errno ) || ( ECONNABORTED == errno ) )
+            {
+                return true;
+            }
+            spdlog::error( "accept4() failed: {}", std::strerror( errno ) );
+            return false;
+        }
+
+        auto const id = next_connection_id_++;
+
+        auto connection_event     = epoll_event{ };
+        connection_event.events   = EPOLLIN | EPOLLRDHUP;
+        connection_event.data.u64 = id;
+        if ( ::epoll_ctl( epoll_fd_, EPOLL_CTL_ADD, socket_fd, &connection_event ) < 0 )
+        {
+            spdlog::error( "epoll_ctl() failed: {}", std::strerror( errno ) );
+            utils::ignore( ::close( socket_fd ) );
+            return false;
+        }
+
+        connections_.emplace( id, Connection{ .socket_fd = socket_fd, .messages_received = 0U } );
+        spdlog::info( "Connection {} opened", id );
+
+        events.push_back( FdServerEvent{
+            .type          = FdServerEventType::Connected,
+            .connection_id = id,
+            .payload       = { },
+            .fds           = { },
+        } );
+    }
+}
+
+auto FdServer::read_messages( uint64 const connection_id, std::vector< FdServerEvent >& events )
+    -> bool
+{
+    auto& connection = connections_.at( connection_id );
+
+    while ( true )
+    {
+        auto payload_size = size_t{ 0 };
+        auto fds          = std::vector< int32 >{ };
+        switch ( receive_message( connection.socket_fd, receive_buffer_, payload_size, fds ) )
+        {
+            case ReceiveStatus::Received:
+                ++connection.messages_received;
+                events.push_back( FdServerEvent{
+                    .type          = FdServerEventType::Message,
+                    .connection_id = connection_id,
+                    .payload       = std::vector< std::byte >(
+                        receive_buffer_.begin( ),
+                        receive_buffer_.begin( ) + static_cast< std::ptrdiff_t >( payload_size )
+                    ),
+                    .fds = std::move( fds ),
+                } );
+                break;
+            case ReceiveStatus::WouldBlock:
+                return true;
+            case ReceiveStatus::Closed:
+            case ReceiveStatus::Failed:
+                // A connection that sends malformed messages is dropped.
+                return false;
+        }
+    }
+}
+
+auto FdServer::close_connection( uint64 const connection_id ) -> void
+{
+    auto const socket_fd = connections_.at( connection_id ).socket_fd;
+    utils::ignore( ::epoll_ctl( epoll_fd_, EPOLL_CTL_DEL, socket_fd, nullptr ) );
+    utils::ignore( ::close( socket_fd ) );
+    connections_.erase( connection_id );
+}
+
+} // namespace ltb::net
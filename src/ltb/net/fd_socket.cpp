@@ -9,44 +9,17 @@
 // external
 #include <spdlog/spdlog.h>
 
+// standard
+#include <cerrno>
+#include <cstring>
+
 // platform
-#include <fcntl.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 namespace ltb::net
 {
-namespace
-{
-
-struct Data
-{
-    msghdr                                            msg  = { };
-    std::array< iovec, 1 >                            iov  = { };
-    std::array< char, CMSG_SPACE( sizeof( int32 ) ) > cmsg = { };
-
-    char        c           = 'x';
-    sockaddr_un socket_name = { };
-
-    Data( )
-    {
-        iov[ 0 ].iov_base = &c;
-        iov[ 0 ].iov_len  = sizeof( c );
-
-        msg.msg_control    = cmsg.data( );
-        msg.msg_controllen = sizeof( cmsg );
-        msg.msg_name       = nullptr;
-        msg.msg_namelen    = 0;
-        msg.msg_flags      = 0;
-        msg.msg_iov        = iov.data( );
-        msg.msg_iovlen     = iov.size( );
-
-        socket_name.sun_family = AF_UNIX;
-    }
-};
-
-} // namespace
 
 FdSocket::~FdSocket( )
 {
@@ -58,7 +31,10 @@ FdSocket::~FdSocket( )
 
 auto FdSocket::initialize( ) -> bool
 {
-    if ( unix_socket_fd_ = ::socket( PF_UNIX, SOCK_DGRAM, 0 ); unix_socket_fd_ < 0 )
+    // Sequenced packets keep message boundaries like datagrams, but are connection
+    // oriented so the server can tell producers apart and notice when they hang up.
+    if ( unix_socket_fd_ = ::socket( PF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0 );
+         unix_socket_fd_ < 0 )
     {
         spdlog::error( "socket() failed: {}", std::strerror( errno ) );
         return false;
@@ -68,26 +44,21 @@ auto FdSocket::initialize( ) -> bool
 
 auto FdSocket::connect_and_send( std::string_view const socket_path, int32 const fd ) -> bool
 {
-    if ( socket_path.length( ) > ( sizeof( sockaddr_un::sun_path ) - 1 ) )
-    {
-        spdlog::error( "socket path too long" );
-        return false;
-    }
-    if ( fd >= static_cast< int32 >( std::numeric_limits< uint8 >::max( ) ) )
+    return connect( socket_path ) && send( fd );
+}
+
+auto FdSocket::connect( std::string_view const socket_path ) -> bool
+{
+    auto socket_name = sockaddr_un{ };
+    if ( !initialize_socket_name( socket_path, socket_name ) )
     {
-        spdlog::error( "fd too large" );
         return false;
     }
 
-    auto data = Data{ };
-    utils::ignore(
-        std::strncpy( data.socket_name.sun_path, socket_path.data( ), socket_path.length( ) )
-    );
-
     if ( ::connect(
              unix_socket_fd_,
-             reinterpret_cast< sockaddr* >( &data.socket_name ),
-             sizeof( data.socket_name )
+             reinterpret_cast< sockaddr* >( &socket_name ),
+             sizeof( socket_name )
          )
          < 0 )
     {
@@ -96,79 +67,63 @@ auto FdSocket::connect_and_send( std::string_view const socket_path, int32 const
     }
     spdlog::debug( "connect()" );
 
-    auto* const cmptr = CMSG_FIRSTHDR( &data.msg );
-    if ( nullptr == cmptr )
-    {
-        spdlog::error( "CMSG_FIRSTHDR() failed" );
-        return false;
-    }
-    cmptr->cmsg_len         = CMSG_LEN( sizeof( fd ) );
-    cmptr->cmsg_level       = SOL_SOCKET;
-    cmptr->cmsg_type        = SCM_RIGHTS;
-    *( CMSG_DATA( cmptr ) ) = static_cast< uint8 >( fd );
-
-    if ( ::sendmsg( unix_socket_fd_, &data.msg, 0 ) < 0 )
-    {
-        spdlog::error( "sendmsg() failed: {}", std::strerror( errno ) );
-        return false;
-    }
-    spdlog::debug( "sendmsg()" );
-
     return true;
 }
 
-auto FdSocket::bind_and_receive( std::string_view const socket_path, int32& fd_out ) -> bool
+auto FdSocket::send( int32 const fd ) -> bool
 {
-    if ( socket_path.length( ) > ( sizeof( sockaddr_un::sun_path ) - 1 ) )
-    {
-        spdlog::error( "socket path too long" );
-        return false;
-    }
+    return send( { }, std::span{ &fd, 1U } );
+}
 
-    auto data = Data{ };
-    utils::ignore(
-        std::strncpy( data.socket_name.sun_path, socket_path.data( ), socket_path.length( ) )
-    );
+auto FdSocket::send(
+    std::span< std::byte const > const payload,
+    std::span< int32 const > const     fds
+) -> bool
+{
+    return send_message( unix_socket_fd_, payload, fds );
+}
 
-    spdlog::debug( "Binding to socket: {}", data.socket_name.sun_path );
-    if ( ::bind(
-             unix_socket_fd_,
-             reinterpret_cast< sockaddr* >( &data.socket_name ),
-             sizeof( data.socket_name )
-         )
-         < 0 )
+auto FdSocket::receive( int32& fd_out ) -> bool
+{
+    auto fds = std::vector< int32 >{ };
+    if ( !receive( { }, fds ) )
     {
-        spdlog::error( "bind() failed: {}", std::strerror( errno ) );
         return false;
     }
 
-    if ( auto const bytes_received = ::recvmsg( unix_socket_fd_, &data.msg, 0 );
-         bytes_received < 0 )
+    if ( 1U != fds.size( ) )
     {
-        spdlog::error( "recvmsg() failed: {}", std::strerror( errno ) );
+        spdlog::error( "Expected 1 file descriptor, received {}", fds.size( ) );
+        close_all( fds );
         return false;
     }
-    spdlog::debug( "recvmsg()" );
+    fd_out = fds.front( );
 
-    auto const* const cmptr = CMSG_FIRSTHDR( &data.msg );
+    return true;
+}
 
-    if ( ( nullptr == cmptr ) || ( CMSG_LEN( sizeof( int32 ) ) != cmptr->cmsg_len ) )
+auto FdSocket::receive( std::span< std::byte > const payload, std::vector< int32 >& fds_out )
+    -> bool
+{
+    auto payload_size = size_t{ 0 };
+    switch ( receive_message( unix_socket_fd_, payload, payload_size, fds_out ) )
     {
-        spdlog::error( "Invalid control message" );
-        return false;
+        case ReceiveStatus::Received:
+            break;
+        case ReceiveStatus::Closed:
+            spdlog::error( "Connection closed" );
+            return false;
+        case ReceiveStatus::WouldBlock:
+        case ReceiveStatus::Failed:
+            return false;
     }
 
-    if ( SOL_SOCKET != cmptr->cmsg_level )
-    {
-        spdlog::error( "control level != SOL_SOCKET" );
-        return false;
-    }
-    if ( SCM_RIGHTS != cmptr->cmsg_type )
+    if ( payload_size != payload.size( ) )
     {
-        spdlog::error( "control type != SCM_RIGHTS" );
+        spdlog::error( "Received {} payload bytes, expected {}", payload_size, payload.size( ) );
+        close_all( fds_out );
         return false;
     }
-    fd_out = static_cast< int32 >( *( CMSG_DATA( cmptr ) ) );
 
     return true;
 }
@@ -0,0 +1,160 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/net/frame_delta.hpp"
+
+// project
+#include "ltb/utils/ignore.hpp"
+
+// external
+#include <spdlog/spdlog.h>
+
+// standard
+#include <cstring>
+#include <limits>
+
+namespace ltb::net
+{
+namespace
+{
+
+// Shorter runs of unchanged words cost more to skip than to send.
+auto constexpr min_skipped_words = size_t{ 4 };
+
+struct RunHeader
+{
+    uint32 skipped_words = 0U;
+    uint32 changed_words = 0U;
+};
+
+auto load_word( std::span< std::byte const > const bytes, size_t const word ) -> uint64
+{
+    auto value = uint64{ 0 };
+    utils::ignore(
+        std::memcpy( &value, bytes.data( ) + ( word * frame_delta_word_size ), sizeof( value ) )
+    );
+    return value;
+}
+
+auto is_valid_frame_size( size_t const frame_size ) -> bool
+{
+    if ( ( 0U != ( frame_size % frame_delta_word_size ) )
+         || ( ( frame_size / frame_delta_word_size ) > std::numeric_limits< uint32 >::max( ) ) )
+    {
+        spdlog::error( "Unsupported frame size for deltas: {}", frame_size );
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+auto encode_frame_delta(
+    std::span< std::byte const > const frame,
+    std::span< std::byte > const       previous_frame,
+    std::vector< std::byte >&          encoded
+) -> bool
+{
+    if ( ( frame.size( ) != previous_frame.size( ) ) || !is_valid_frame_size( frame.size( ) ) )
+    {
+        return false;
+    }
+
+    auto const word_count = frame.size( ) / frame_delta_word_size;
+    auto const previous   = std::span< std::byte const >{ previous_frame };
+    auto const is_same    = [ & ]( size_t const word )
+    { return load_word( frame, word ) == load_word( previous, word ); };
+
+    encoded.clear( );
+
+    auto word = size_t{ 0 };
+    while ( word < word_count )
+    {
+        auto const skip_start = word;
+        while ( ( word < word_count ) && is_same( word ) )
+        {
+            ++word;
+        }
+
+        // Changed words run on until enough unchanged words follow them to be worth a skip.
+        auto const change_start = word;
+        while ( word < word_count )
+        {
+            auto same_count = size_t{ 0 };
+            while ( ( ( word + same_count ) < word_count ) && ( same_count < min_skipped_words )
+                    && is_same( word + same_count ) )
+            {
+                ++same_count;
+            }
+
+            if ( ( min_skipped_words == same_count ) || ( ( word + same_count ) == word_count ) )
+            {
+                break;
+            }
+            word += same_count + 1U;
+        }
+
+        auto const header = RunHeader{
+            .skipped_words = static_cast< uint32 >( change_start - skip_start ),
+            .changed_words = static_cast< uint32 >( word - change_start ),
+        };
+        auto const changes = frame.subspan(
+            change_start * frame_delta_word_size,
+            header.changed_words * frame_delta_word_size
+        );
+        auto const header_bytes = std::as_bytes( std::span{ &header, 1U } );
+        encoded.insert( encoded.end( ), header_bytes.begin( ), header_bytes.end( ) );
+        encoded.insert( encoded.end( ), changes.begin( ), changes.end( ) );
+
+        utils::ignore( std::memcpy(
+            previous_frame.data( ) + ( change_start * frame_delta_word_size ),
+            changes.data( ),
+            changes.size( )
+        ) );
+    }
+    return true;
+}
+
+auto decode_frame_delta( std::span< std::byte const > encoded, std::span< std::byte > const frame )
+    -> bool
+{
+    if ( !is_valid_frame_size( frame.size( ) ) )
+    {
+        return false;
+    }
+
+    auto const word_count = frame.size( ) / frame_delta_word_size;
+
+    auto word = size_t{ 0 };
+    while ( !encoded.empty( ) )
+    {
+        auto header = RunHeader{ };
+        if ( encoded.size( ) < sizeof( header ) )
+        {
+            spdlog::error( "Truncated frame delta" );
+            return false;
+        }
+        utils::ignore( std::memcpy( &header, encoded.data( ), sizeof( header ) ) );
+        encoded = encoded.subspan( sizeof( header ) );
+
+        auto const change_bytes = size_t{ header.changed_words } * frame_delta_word_size;
+        word += header.skipped_words;
+        if ( ( ( word + header.changed_words ) > word_count )
+             || ( encoded.size( ) < change_bytes ) )
+        {
+            spdlog::error( "Frame delta doesn't fit the frame" );
+            return false;
+        }
+
+        utils::ignore( std::memcpy(
+            frame.data( ) + ( word * frame_delta_word_size ),
+            encoded.data( ),
+            change_bytes
+        ) );
+        encoded = encoded.subspan( change_bytes );
+        word += header.changed_words;
+    }
+    return true;
+}
+
+} // namespace ltb::net
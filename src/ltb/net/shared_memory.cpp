@@ -0,0 +1,141 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/net/shared_memory.hpp"
+
+// project
+#include "ltb/utils/ignore.hpp"
+
+// external
+#include <spdlog/spdlog.h>
+
+// standard
+#include <cstring>
+#include <string>
+
+// platform
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ltb::net
+{
+
+SharedMemory::~SharedMemory( )
+{
+    reset( );
+}
+
+auto SharedMemory::create( std::string_view const name, size_t const size ) -> bool
+{
+    reset( );
+
+    if ( fd_ = ::memfd_create( std::string( name ).c_str( ), MFD_CLOEXEC ); fd_ < 0 )
+    {
+        spdlog::error( "memfd_create() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    if ( ::ftruncate( fd_, static_cast< off_t >( size ) ) < 0 )
+    {
+        spdlog::error( "ftruncate() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    return map( fd_ );
+}
+
+auto SharedMemory::map( int32 const fd ) -> bool
+{
+    if ( fd != fd_ )
+    {
+        reset( );
+        fd_ = fd;
+    }
+
+    struct stat stats = { };
+    if ( ::fstat( fd_, &stats ) < 0 )
+    {
+        spdlog::error( "fstat() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+    size_ = static_cast< size_t >( stats.st_size );
+
+    if ( data_ = ::mmap( nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0 );
+         MAP_FAILED == data_ )
+    {
+        data_ = nullptr;
+        spdlog::error( "mmap() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+    spdlog::debug( "mmap() {} bytes", size_ );
+
+    return true;
+}
+
+auto SharedMemory::create_hugepage_backed( std::string_view const name, size_t const size )
+    -> bool
+{
+    auto constexpr huge_page_size = size_t{ 2U * 1024U * 1024U };
+    auto const page_count         = ( size + huge_page_size - 1U ) / huge_page_size;
+    auto const rounded_size       = page_count * huge_page_size;
+
+    reset( );
+
+    // Hugetlb pages have to be reserved up front, which most systems don't do by default.
+    if ( fd_ = ::memfd_create( std::string( name ).c_str( ), MFD_CLOEXEC | MFD_HUGETLB ); fd_ >= 0 )
+    {
+        if ( ( ::ftruncate( fd_, static_cast< off_t >( rounded_size ) ) == 0 ) && map( fd_ ) )
+        {
+            spdlog::debug( "Shared memory backed by huge pages" );
+            return true;
+        }
+        spdlog::debug( "Huge pages unavailable, falling back to regular pages" );
+    }
+
+    if ( !create( name, rounded_size ) )
+    {
+        return false;
+    }
+
+    if ( ::madvise( data_, size_, MADV_HUGEPAGE ) < 0 )
+    {
+        spdlog::debug( "madvise( MADV_HUGEPAGE ) failed: {}", std::strerror( errno ) );
+    }
+
+    return true;
+}
+
+auto SharedMemory::reset( ) -> void
+{
+    if ( nullptr != data_ )
+    {
+        utils::ignore( ::munmap( data_, size_ ) );
+        data_ = nullptr;
+        spdlog::debug( "munmap()" );
+    }
+    size_ = 0U;
+
+    if ( -1 != fd_ )
+    {
+        utils::ignore( ::close( fd_ ) );
+        fd_ = -1;
+    }
+}
+
+auto SharedMemory::fd( ) const -> int32
+{
+    return fd_;
+}
+
+auto SharedMemory::data( ) const -> void*
+{
+    return data_;
+}
+
+auto SharedMemory::size( ) const -> size_t
+{
+    return size_;
+}
+
+} // namespace ltb::net
@@ -0,0 +1,293 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/net/tcp_stream.hpp"
+
+// project
+#include "ltb/utils/ignore.hpp"
+
+// external
+#include <spdlog/spdlog.h>
+
+// standard
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+// platform
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ltb::net
+{
+namespace
+{
+
+// Room for a few compressed 1080p frames, so sends rarely wait on the receiver.
+auto constexpr socket_buffer_size = int32{ 16 * 1024 * 1024 };
+
+auto initialize_address( std::string_view const address, uint16 const port, sockaddr_in& name )
+    -> bool
+{
+    name            = sockaddr_in{ };
+    name.sin_family = AF_INET;
+    name.sin_port   = ::htons( port );
+
+    // inet_pton needs a null-terminated string.
+    if ( 1 != ::inet_pton( AF_INET, std::string( address ).c_str( ), &name.sin_addr ) )
+    {
+        spdlog::error( "Invalid IPv4 address: {}", address );
+        return false;
+    }
+    return true;
+}
+
+// Linux reports a connection's pending network errors from accept4, as well as connections
+// aborted before they were accepted. Those only lose that connection, so accepting goes on.
+auto is_transient_accept_error( int32 const error ) -> bool
+{
+    switch ( error )
+    {
+        case EINTR:
+        case ECONNABORTED:
+        case EPROTO:
+        case ENETDOWN:
+        case ENOPROTOOPT:
+        case EHOSTDOWN:
+        case ENONET:
+        case EHOSTUNREACH:
+        case EOPNOTSUPP:
+        case ENETUNREACH:
+            return true;
+        default:
+            return false;
+    }
+}
+
+auto close_socket( int32& socket_fd ) -> void
+{
+    if ( -1 != socket_fd )
+    {
+        utils::ignore( ::close( socket_fd ) );
+        socket_fd = -1;
+    }
+}
+
+} // namespace
+
+TcpStream::~TcpStream( )
+{
+    reset( );
+}
+
+auto TcpStream::connect( std::string_view const address, uint16 const port ) -> bool
+{
+    auto name = sockaddr_in{ };
+    if ( !initialize_address( address, port, name ) )
+    {
+        return false;
+    }
+
+    auto socket_fd = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if ( socket_fd < 0 )
+    {
+        spdlog::error( "socket() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    if ( ::connect( socket_fd, reinterpret_cast< sockaddr* >( &name ), sizeof( name ) ) < 0 )
+    {
+        spdlog::error( "connect() failed: {}", std::strerror( errno ) );
+        close_socket( socket_fd );
+        return false;
+    }
+    spdlog::debug( "connect()" );
+
+    socket_fd_ = socket_fd;
+    configure( );
+    return true;
+}
+
+auto TcpStream::send( std::span< std::byte const > payload ) -> bool
+{
+    while ( !payload.empty( ) )
+    {
+        // MSG_NOSIGNAL reports a closed connection as an error instead of raising SIGPIPE.
+        auto const sent = ::send( socket_fd_, payload.data( ), payload.size( ), MSG_NOSIGNAL );
+        if ( sent < 0 )
+        {
+            if ( EINTR == errno )
+            {
+                continue;
+            }
+            spdlog::error( "send() failed: {}", std::strerror( errno ) );
+            return false;
+        }
+        payload = payload.subspan( static_cast< size_t >( sent ) );
+    }
+    return true;
+}
+
+auto TcpStream::receive( std::span< std::byte > payload, bool& closed ) -> bool
+{
+    auto const payload_size = payload.size( );
+    closed                  = false;
+
+    while ( !payload.empty( ) )
+    {
+        auto const received = ::recv( socket_fd_, payload.data( ), payload.size( ), 0 );
+        if ( received < 0 )
+        {
+            if ( EINTR == errno )
+            {
+                continue;
+            }
+            spdlog::error( "recv() failed: {}", std::strerror( errno ) );
+            return false;
+        }
+
+        if ( 0 == received )
+        {
+            // Hanging up between messages is how the other side says it's done.
+            closed = ( payload.size( ) == payload_size );
+            if ( !closed )
+            {
+                spdlog::error( "Connection closed in the middle of a message" );
+            }
+            return false;
+        }
+        payload = payload.subspan( static_cast< size_t >( received ) );
+    }
+    return true;
+}
+
+auto TcpStream::shutdown( ) -> void
+{
+    if ( auto const socket_fd = socket_fd_.load( ); -1 != socket_fd )
+    {
+        utils::ignore( ::shutdown( socket_fd, SHUT_RDWR ) );
+    }
+}
+
+auto TcpStream::reset( ) -> void
+{
+    auto socket_fd = socket_fd_.exchange( -1 );
+    close_socket( socket_fd );
+}
+
+auto TcpStream::is_connected( ) const -> bool
+{
+    return -1 != socket_fd_;
+}
+
+auto TcpStream::configure( ) -> void
+{
+    // Frames are sent as a header followed by a large body, which shouldn't be
+    // held back waiting for more data. Failures only cost throughput.
+    auto const no_delay = int32{ 1 };
+    utils::ignore(
+        ::setsockopt( socket_fd_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof( no_delay ) )
+    );
+    utils::ignore( ::setsockopt(
+        socket_fd_,
+        SOL_SOCKET,
+        SO_SNDBUF,
+        &socket_buffer_size,
+        sizeof( socket_buffer_size )
+    ) );
+    utils::ignore( ::setsockopt(
+        socket_fd_,
+        SOL_SOCKET,
+        SO_RCVBUF,
+        &socket_buffer_size,
+        sizeof( socket_buffer_size )
+    ) );
+}
+
+TcpListener::~TcpListener( )
+{
+    close_socket( socket_fd_ );
+}
+
+auto TcpListener::listen( std::string_view const address, uint16 const port ) -> bool
+{
+    auto name = sockaddr_in{ };
+    if ( !initialize_address( address, port, name ) )
+    {
+        return false;
+    }
+
+    if ( socket_fd_ = ::socket( AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0 ); socket_fd_ < 0 )
+    {
+        spdlog::error( "socket() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    // A restarted consumer can listen again right away.
+    auto const reuse_address = int32{ 1 };
+    utils::ignore( ::setsockopt(
+        socket_fd_,
+        SOL_SOCKET,
+        SO_REUSEADDR,
+        &reuse_address,
+        sizeof( reuse_address )
+    ) );
+
+    if ( ::bind( socket_fd_, reinterpret_cast< sockaddr* >( &name ), sizeof( name ) ) < 0 )
+    {
+        spdlog::error( "bind() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+    spdlog::debug( "bind()" );
+
+    auto constexpr backlog = 1;
+    if ( ::listen( socket_fd_, backlog ) < 0 )
+    {
+        spdlog::error( "listen() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+    spdlog::debug( "listen()" );
+
+    return true;
+}
+
+auto TcpListener::accept( TcpStream& stream ) -> bool
+{
+    auto socket_fd = ::accept4( socket_fd_, nullptr, nullptr, SOCK_CLOEXEC );
+    while ( ( socket_fd < 0 ) && is_transient_accept_error( errno ) )
+    {
+        if ( EINTR != errno )
+        {
+            spdlog::warn( "accept4() failed, still accepting: {}", std::strerror( errno ) );
+        }
+        socket_fd = ::accept4( socket_fd_, nullptr, nullptr, SOCK_CLOEXEC );
+    }
+
+    if ( socket_fd < 0 )
+    {
+        // Shutting down the listener is the expected way to stop accepting.
+        if ( EINVAL != errno )
+        {
+            spdlog::error( "accept4() failed: {}", std::strerror( errno ) );
+        }
+        return false;
+    }
+    spdlog::debug( "accept4()" );
+
+    stream.socket_fd_ = socket_fd;
+    stream.configure( );
+    return true;
+}
+
+auto TcpListener::shutdown( ) -> void
+{
+    if ( -1 != socket_fd_ )
+    {
+        utils::ignore( ::shutdown( socket_fd_, SHUT_RDWR ) );
+    }
+}
+
+} // namespace ltb::net
@@ -7,6 +7,7 @@
 #include <spdlog/spdlog.h>
 
 // standard
+#include <algorithm>
 #include <charconv>
 #include <cstring>
 
@@ -18,19 +19,56 @@ auto get_physical_device_index_from_args(
     uint32&                         physical_device_index
 ) -> bool
 {
-    if ( args.size( ) > 1U )
+    return get_number_from_args( args, 1U, physical_device_index );
+}
+
+template < typename T >
+auto get_number_from_args( std::span< char const* > const& args, size_t const index, T& value )
+    -> bool
+{
+    if ( args.size( ) > index )
     {
-        auto const* const start = args[ 1 ];
-        auto const* const end   = args[ 1 ] + std::strlen( args[ 1 ] );
+        auto const* const start = args[ index ];
+        auto const* const end   = args[ index ] + std::strlen( args[ index ] );
 
-        if ( auto const result = std::from_chars( start, end, physical_device_index );
-             std::errc( ) != result.ec )
+        if ( auto const result = std::from_chars( start, end, value ); std::errc( ) != result.ec )
         {
-            spdlog::error( "Invalid argument: {}", args[ 1 ] );
+            spdlog::error( "Invalid argument: {}", args[ index ] );
             return false;
         }
     }
     return true;
 }
 
+auto take_flag_from_args( std::vector< char const* >& args, std::string_view const flag ) -> bool
+{
+    return std::erase_if( args, [ flag ]( char const* arg ) { return flag == arg; } ) > 0U;
+}
+
+auto take_option_from_args(
+    std::vector< char const* >&        args,
+    std::string_view const             option,
+    std::optional< std::string_view >& value
+) -> bool
+{
+    auto const found = std::ranges::find( args, option );
+    if ( args.end( ) == found )
+    {
+        return true;
+    }
+
+    if ( args.end( ) == std::next( found ) )
+    {
+        spdlog::error( "Missing value for {}", option );
+        return false;
+    }
+    value = *std::next( found );
+    args.erase( found, std::next( found, 2 ) );
+    return true;
+}
+
+template auto get_number_from_args( std::span< char const* > const&, size_t, int32& ) -> bool;
+template auto get_number_from_args( std::span< char const* > const&, size_t, uint32& ) -> bool;
+template auto get_number_from_args( std::span< char const* > const&, size_t, float32& ) -> bool;
+
 } // namespace ltb::utils
@@ -0,0 +1,339 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/allocator.hpp"
+
+// project
+#include "ltb/vlk/check.hpp"
+
+// standard
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+auto constexpr host_access_flags = VkMemoryPropertyFlags{
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+};
+
+// The properties a usage needs, and the ones it prefers when a type has them.
+auto get_memory_flags( MemoryUsage const usage )
+    -> std::pair< VkMemoryPropertyFlags, VkMemoryPropertyFlags >
+{
+    switch ( usage )
+    {
+        case MemoryUsage::HostUpload:
+            return { host_access_flags, 0U };
+        case MemoryUsage::HostReadback:
+            return { host_access_flags, VK_MEMORY_PROPERTY_HOST_CACHED_BIT };
+        case MemoryUsage::Transient:
+            return {
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT,
+            };
+        case MemoryUsage::DeviceLocal:
+        case MemoryUsage::Exportable:
+            break;
+    }
+    return { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0U };
+}
+
+auto is_host_visible( AllocatorData const& allocator, uint32 const memory_type_index ) -> bool
+{
+    auto const flags = allocator.memory_properties.memoryTypes[ memory_type_index ].propertyFlags;
+    return 0U != ( flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
+}
+
+// Allocates memory that isn't shared with anything else, mapped if it's host-visible.
+auto allocate_memory(
+    VkDeviceMemory&      memory,
+    void*&               mapped,
+    AllocatorData const& allocator,
+    VkDevice const&      device,
+    VkDeviceSize const   size,
+    uint32 const         memory_type_index
+) -> bool
+{
+    auto const alloc_info = VkMemoryAllocateInfo{
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext           = nullptr,
+        .allocationSize  = size,
+        .memoryTypeIndex = memory_type_index,
+    };
+    CHECK_VK( ::vkAllocateMemory( device, &alloc_info, nullptr, &memory ) );
+    spdlog::debug( "vkAllocateMemory() w/ {} bytes", size );
+
+    mapped = nullptr;
+    if ( is_host_visible( allocator, memory_type_index ) )
+    {
+        auto constexpr offset = VkDeviceSize{ 0U };
+        CHECK_VK( ::vkMapMemory( device, memory, offset, VK_WHOLE_SIZE, 0U, &mapped ) );
+    }
+    return true;
+}
+
+auto add_free_range( MemoryBlock& block, VkDeviceSize const offset, VkDeviceSize const size )
+    -> void
+{
+    if ( 0U != size )
+    {
+        block.free_ranges.emplace( offset, size );
+        block.free_by_size.emplace( size, offset );
+    }
+}
+
+auto remove_free_range( MemoryBlock& block, VkDeviceSize const offset, VkDeviceSize const size )
+    -> void
+{
+    block.free_ranges.erase( offset );
+
+    auto [ first, last ] = block.free_by_size.equal_range( size );
+    auto const range     = std::find_if(
+        first,
+        last,
+        [ offset ]( auto const& entry ) { return offset == entry.second; }
+    );
+    block.free_by_size.erase( range );
+}
+
+// Takes the smallest free range that still fits once its start is aligned. Whatever's
+// left on either side of the allocation stays free.
+auto take_free_range(
+    MemoryBlock&                block,
+    VkMemoryRequirements const& requirements,
+    VkDeviceSize&               offset
+) -> bool
+{
+    auto const alignment = std::max( requirements.alignment, VkDeviceSize{ 1U } );
+
+    for ( auto range = block.free_by_size.lower_bound( requirements.size );
+          block.free_by_size.end( ) != range;
+          ++range )
+    {
+        auto const [ range_size, range_offset ] = *range;
+
+        auto const aligned_offset = ( ( range_offset + alignment - 1U ) / alignment ) * alignment;
+        auto const padding        = aligned_offset - range_offset;
+        if ( ( padding + requirements.size ) > range_size )
+        {
+            continue;
+        }
+
+        remove_free_range( block, range_offset, range_size );
+        add_free_range( block, range_offset, padding );
+        add_free_range(
+            block,
+            aligned_offset + requirements.size,
+            range_size - padding - requirements.size
+        );
+        offset = aligned_offset;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+auto initialize( AllocatorData& allocator, VkPhysicalDevice const& physical_device ) -> bool
+{
+    allocator.physical_device = physical_device;
+    ::vkGetPhysicalDeviceMemoryProperties( physical_device, &allocator.memory_properties );
+    spdlog::debug(
+        "Allocator initialized with {} memory types",
+        allocator.memory_properties.memoryTypeCount
+    );
+    return true;
+}
+
+auto find_memory_type_index(
+    AllocatorData const& allocator,
+    uint32 const         memory_type_bits,
+    MemoryUsage const    usage
+) -> std::optional< uint32 >
+{
+    auto const [ required_flags, optional_flags ] = get_memory_flags( usage );
+    auto const& memory_properties                  = allocator.memory_properties;
+
+    for ( auto const flags : { required_flags | optional_flags, required_flags } )
+    {
+        for ( auto i = 0U; i < memory_properties.memoryTypeCount; ++i )
+        {
+            auto const type_is_suitable = ( 0U != ( memory_type_bits & ( 1U << i ) ) );
+            auto const props_exist
+                = ( memory_properties.memoryTypes[ i ].propertyFlags & flags ) == flags;
+
+            if ( type_is_suitable && props_exist )
+            {
+                return i;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+auto allocate(
+    MemoryAllocation&           allocation,
+    AllocatorData&              allocator,
+    VkDevice const&             device,
+    VkMemoryRequirements const& requirements,
+    MemoryUsage const           usage,
+    bool const                  linear
+) -> bool
+{
+    if ( MemoryUsage::Exportable == usage )
+    {
+        spdlog::error( "Exportable memory can't be sub-allocated" );
+        return false;
+    }
+
+    auto const memory_type_index
+        = find_memory_type_index( allocator, requirements.memoryTypeBits, usage );
+    if ( !memory_type_index )
+    {
+        spdlog::error( "No suitable memory type found" );
+        return false;
+    }
+
+    allocation = MemoryAllocation{
+        .memory            = nullptr,
+        .offset            = 0U,
+        .size              = requirements.size,
+        .memory_type_index = memory_type_index.value( ),
+        .mapped            = nullptr,
+        .block_id          = std::nullopt,
+    };
+
+    if ( requirements.size > memory_block_size )
+    {
+        return allocate_memory(
+            allocation.memory,
+            allocation.mapped,
+            allocator,
+            device,
+            requirements.size,
+            allocation.memory_type_index
+        );
+    }
+
+    auto block = allocator.blocks.end( );
+    for ( auto iter = allocator.blocks.begin( ); allocator.blocks.end( ) != iter; ++iter )
+    {
+        auto& candidate = iter->second;
+        if ( ( allocation.memory_type_index == candidate.memory_type_index )
+             && ( linear == candidate.linear )
+             && take_free_range( candidate, requirements, allocation.offset ) )
+        {
+            block = iter;
+            break;
+        }
+    }
+
+    // A new block only reaches the driver when every block of the type is full.
+    if ( allocator.blocks.end( ) == block )
+    {
+        auto new_block = MemoryBlock{
+            .memory            = nullptr,
+            .memory_type_index = allocation.memory_type_index,
+            .linear            = linear,
+            .mapped            = nullptr,
+            .allocation_count  = 0U,
+            .free_ranges       = { },
+            .free_by_size      = { },
+        };
+        CHECK_TRUE( allocate_memory(
+            new_block.memory,
+            new_block.mapped,
+            allocator,
+            device,
+            memory_block_size,
+            new_block.memory_type_index
+        ) );
+        add_free_range( new_block, 0U, memory_block_size );
+
+        block = allocator.blocks.emplace( allocator.next_block_id++, std::move( new_block ) ).first;
+        CHECK_TRUE( take_free_range( block->second, requirements, allocation.offset ) );
+    }
+
+    auto& [ block_id, memory_block ] = *block;
+    ++memory_block.allocation_count;
+
+    allocation.memory   = memory_block.memory;
+    allocation.block_id = block_id;
+    if ( nullptr != memory_block.mapped )
+    {
+        allocation.mapped = static_cast< std::byte* >( memory_block.mapped ) + allocation.offset;
+    }
+
+    return true;
+}
+
+auto deallocate( MemoryAllocation& allocation, AllocatorData& allocator, VkDevice const& device )
+    -> void
+{
+    if ( nullptr == allocation.memory )
+    {
+        return;
+    }
+
+    if ( !allocation.block_id )
+    {
+        // Freeing the memory also unmaps it.
+        ::vkFreeMemory( device, allocation.memory, nullptr );
+        spdlog::debug( "vkFreeMemory()" );
+        allocation = MemoryAllocation{ };
+        return;
+    }
+
+    auto& block  = allocator.blocks.at( allocation.block_id.value( ) );
+    auto  offset = allocation.offset;
+    auto  size   = allocation.size;
+
+    // Neighbouring free ranges are merged, so freed space can hold larger allocations.
+    if ( auto const next = block.free_ranges.find( offset + size );
+         block.free_ranges.end( ) != next )
+    {
+        auto const next_size = next->second;
+        remove_free_range( block, offset + size, next_size );
+        size += next_size;
+    }
+    if ( auto const next = block.free_ranges.lower_bound( offset );
+         block.free_ranges.begin( ) != next )
+    {
+        auto const [ previous_offset, previous_size ] = *std::prev( next );
+        if ( ( previous_offset + previous_size ) == offset )
+        {
+            remove_free_range( block, previous_offset, previous_size );
+            offset = previous_offset;
+            size  += previous_size;
+        }
+    }
+    add_free_range( block, offset, size );
+    --block.allocation_count;
+
+    allocation = MemoryAllocation{ };
+}
+
+auto destroy( AllocatorData& allocator, VkDevice const& device ) -> void
+{
+    for ( auto& [ block_id, block ] : allocator.blocks )
+    {
+        if ( 0U != block.allocation_count )
+        {
+            spdlog::warn(
+                "Memory block {} freed with {} allocations",
+                block_id,
+                block.allocation_count
+            );
+        }
+        ::vkFreeMemory( device, block.memory, nullptr );
+        spdlog::debug( "vkFreeMemory()" );
+    }
+    allocator.blocks.clear( );
+}
+
+} // namespace ltb::vlk
@@ -0,0 +1,92 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/damage.hpp"
+
+// standard
+#include <algorithm>
+
+namespace ltb::vlk
+{
+
+auto is_empty( VkRect2D const& rect ) -> bool
+{
+    return ( 0U == rect.extent.width ) || ( 0U == rect.extent.height );
+}
+
+auto unite( VkRect2D const& lhs, VkRect2D const& rhs ) -> VkRect2D
+{
+    if ( is_empty( lhs ) )
+    {
+        return rhs;
+    }
+    if ( is_empty( rhs ) )
+    {
+        return lhs;
+    }
+
+    // Computed in 64 bits so rects near the edges of the int32 range can't overflow.
+    auto const min_x = std::min( lhs.offset.x, rhs.offset.x );
+    auto const min_y = std::min( lhs.offset.y, rhs.offset.y );
+    auto const max_x = std::max(
+        int64{ lhs.offset.x } + lhs.extent.width,
+        int64{ rhs.offset.x } + rhs.extent.width
+    );
+    auto const max_y = std::max(
+        int64{ lhs.offset.y } + lhs.extent.height,
+        int64{ rhs.offset.y } + rhs.extent.height
+    );
+    return VkRect2D{
+        .offset = VkOffset2D{ .x = min_x, .y = min_y },
+        .extent = VkExtent2D{
+            .width  = static_cast< uint32 >( max_x - min_x ),
+            .height = static_cast< uint32 >( max_y - min_y ),
+        },
+    };
+}
+
+auto clip( VkRect2D const& rect, VkExtent2D const& extent ) -> VkRect2D
+{
+    auto const min_x = std::clamp( int64{ rect.offset.x }, int64{ 0 }, int64{ extent.width } );
+    auto const min_y = std::clamp( int64{ rect.offset.y }, int64{ 0 }, int64{ extent.height } );
+    auto const max_x = std::clamp(
+        int64{ rect.offset.x } + rect.extent.width,
+        min_x,
+        int64{ extent.width }
+    );
+    auto const max_y = std::clamp(
+        int64{ rect.offset.y } + rect.extent.height,
+        min_y,
+        int64{ extent.height }
+    );
+    return VkRect2D{
+        .offset = VkOffset2D{
+            .x = static_cast< int32 >( min_x ),
+            .y = static_cast< int32 >( min_y ),
+        },
+        .extent = VkExtent2D{
+            .width  = static_cast< uint32 >( max_x - min_x ),
+            .height = static_cast< uint32 >( max_y - min_y ),
+        },
+    };
+}
+
+auto to_rect( DamageRect const& damage ) -> VkRect2D
+{
+    return VkRect2D{
+        .offset = VkOffset2D{ .x = damage.x, .y = damage.y },
+        .extent = VkExtent2D{ .width = damage.width, .height = damage.height },
+    };
+}
+
+auto to_damage( VkRect2D const& rect ) -> DamageRect
+{
+    return DamageRect{
+        .x      = rect.offset.x,
+        .y      = rect.offset.y,
+        .width  = rect.extent.width,
+        .height = rect.extent.height,
+    };
+}
+
+} // namespace ltb::vlk
@@ -0,0 +1,751 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/host_ring.hpp"
+
+// project
+#include "ltb/utils/ignore.hpp"
+#include "ltb/vlk/check.hpp"
+
+// standard
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <string_view>
+
+// platform
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+auto constexpr stats_report_interval = std::chrono::seconds( 5 );
+
+// The ring only carries formats with one 32-bit texel per pixel.
+auto get_bytes_per_texel( VkFormat const color_format ) -> std::optional< uint32 >
+{
+    switch ( color_format )
+    {
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return 4U;
+        default:
+            return std::nullopt;
+    }
+}
+
+auto initialize_transfer(
+    HostTransfer&            transfer,
+    AllocatorData&           allocator,
+    VkDevice const&          device,
+    VkCommandPool const&     command_pool,
+    VkDeviceSize const       size,
+    VkBufferUsageFlags const usage,
+    MemoryUsage const        memory_usage
+) -> bool
+{
+    auto const buffer_create_info = VkBufferCreateInfo{
+        .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext                 = nullptr,
+        .flags                 = 0U,
+        .size                  = size,
+        .usage                 = usage,
+        .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0U,
+        .pQueueFamilyIndices   = nullptr,
+    };
+    CHECK_VK( ::vkCreateBuffer( device, &buffer_create_info, nullptr, &transfer.buffer ) );
+    spdlog::debug( "vkCreateBuffer()" );
+
+    auto memory_requirements = VkMemoryRequirements{ };
+    ::vkGetBufferMemoryRequirements( device, transfer.buffer, &memory_requirements );
+
+    // The allocator keeps host-visible memory mapped for as long as it exists.
+    auto constexpr linear = true;
+    CHECK_TRUE( allocate(
+        transfer.allocation,
+        allocator,
+        device,
+        memory_requirements,
+        memory_usage,
+        linear
+    ) );
+    transfer.allocator = &allocator;
+
+    CHECK_VK( ::vkBindBufferMemory(
+        device,
+        transfer.buffer,
+        transfer.allocation.memory,
+        transfer.allocation.offset
+    ) );
+
+    auto const cmd_buf_alloc_info = VkCommandBufferAllocateInfo{
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext              = nullptr,
+        .commandPool        = command_pool,
+        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1U,
+    };
+    CHECK_VK( ::vkAllocateCommandBuffers( device, &cmd_buf_alloc_info, &transfer.command_buffer ) );
+    spdlog::debug( "vkAllocateCommandBuffers()" );
+
+    // Signaled so the first copy doesn't wait on anything.
+    auto const fence_create_info = VkFenceCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+    };
+    CHECK_VK( ::vkCreateFence( device, &fence_create_info, nullptr, &transfer.fence ) );
+    spdlog::debug( "vkCreateFence()" );
+
+    return true;
+}
+
+auto destroy_transfer(
+    HostTransfer&        transfer,
+    VkDevice const&      device,
+    VkCommandPool const& command_pool
+) -> void
+{
+    if ( nullptr != transfer.fence )
+    {
+        ::vkDestroyFence( device, transfer.fence, nullptr );
+        spdlog::debug( "vkDestroyFence()" );
+    }
+
+    if ( nullptr != transfer.command_buffer )
+    {
+        ::vkFreeCommandBuffers( device, command_pool, 1U, &transfer.command_buffer );
+        spdlog::debug( "vkFreeCommandBuffers()" );
+    }
+
+    if ( nullptr != transfer.buffer )
+    {
+        ::vkDestroyBuffer( device, transfer.buffer, nullptr );
+        spdlog::debug( "vkDestroyBuffer()" );
+    }
+
+    if ( nullptr != transfer.allocator )
+    {
+        deallocate( transfer.allocation, *transfer.allocator, device );
+    }
+
+    transfer = HostTransfer{ };
+}
+
+auto get_copy_region( VkExtent2D const image_size ) -> VkBufferImageCopy
+{
+    // Zero row length and image height mean the pixels are tightly packed.
+    return VkBufferImageCopy{
+        .bufferOffset      = 0U,
+        .bufferRowLength   = 0U,
+        .bufferImageHeight = 0U,
+        .imageSubresource  = VkImageSubresourceLayers{
+             .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+             .mipLevel       = 0U,
+             .baseArrayLayer = 0U,
+             .layerCount     = 1U,
+        },
+        .imageOffset = VkOffset3D{ .x = 0, .y = 0, .z = 0 },
+        .imageExtent = VkExtent3D{ image_size.width, image_size.height, 1U },
+    };
+}
+
+auto get_image_barrier(
+    VkImage const       image,
+    VkAccessFlags const src_access_mask,
+    VkAccessFlags const dst_access_mask,
+    VkImageLayout const old_layout,
+    VkImageLayout const new_layout
+) -> VkImageMemoryBarrier
+{
+    return VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = src_access_mask,
+        .dstAccessMask = dst_access_mask,
+        .oldLayout = old_layout,
+        .newLayout = new_layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = VkImageSubresourceRange{
+               .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+               .baseMipLevel   = 0U,
+               .levelCount     = 1U,
+               .baseArrayLayer = 0U,
+               .layerCount     = 1U,
+        },
+    };
+}
+
+// The copy never changes, so it's recorded once and resubmitted for every frame.
+auto record_readback(
+    HostTransfer&                            readback,
+    ImageData< ExternalMemory::None > const& image
+) -> bool
+{
+    auto const begin_info = VkCommandBufferBeginInfo{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext            = nullptr,
+        .flags            = 0U,
+        .pInheritanceInfo = nullptr,
+    };
+    CHECK_VK( ::vkBeginCommandBuffer( readback.command_buffer, &begin_info ) );
+
+    // The render pass leaves the image in the shader read layout.
+    auto const to_transfer_barrier = get_image_barrier(
+        image.color_image,
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    );
+    ::vkCmdPipelineBarrier(
+        readback.command_buffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0U,
+        0U,
+        nullptr,
+        0U,
+        nullptr,
+        1U,
+        &to_transfer_barrier
+    );
+
+    auto const region = get_copy_region( image.image_size );
+    ::vkCmdCopyImageToBuffer(
+        readback.command_buffer,
+        image.color_image,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        readback.buffer,
+        1U,
+        &region
+    );
+
+    // Make the copy visible to the host once the fence is signaled.
+    auto const to_host_barrier = VkBufferMemoryBarrier{
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext               = nullptr,
+        .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask       = VK_ACCESS_HOST_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer              = readback.buffer,
+        .offset              = 0U,
+        .size                = VK_WHOLE_SIZE,
+    };
+    ::vkCmdPipelineBarrier(
+        readback.command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0U,
+        0U,
+        nullptr,
+        1U,
+        &to_host_barrier,
+        0U,
+        nullptr
+    );
+
+    CHECK_VK( ::vkEndCommandBuffer( readback.command_buffer ) );
+    return true;
+}
+
+// The upload never changes, so it's recorded once and resubmitted for every frame.
+auto record_upload( HostTransfer& upload, ImageData< ExternalMemory::None > const& image )
+    -> bool
+{
+    auto const begin_info = VkCommandBufferBeginInfo{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext            = nullptr,
+        .flags            = 0U,
+        .pInheritanceInfo = nullptr,
+    };
+    CHECK_VK( ::vkBeginCommandBuffer( upload.command_buffer, &begin_info ) );
+
+    // The whole image is overwritten, so its previous contents are discarded. Waiting on
+    // the fragment stage keeps earlier submits from sampling the image mid-copy.
+    auto const to_transfer_barrier = get_image_barrier(
+        image.color_image,
+        VK_ACCESS_NONE,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    );
+    ::vkCmdPipelineBarrier(
+        upload.command_buffer,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0U,
+        0U,
+        nullptr,
+        0U,
+        nullptr,
+        1U,
+        &to_transfer_barrier
+    );
+
+    auto const region = get_copy_region( image.image_size );
+    ::vkCmdCopyBufferToImage(
+        upload.command_buffer,
+        upload.buffer,
+        image.color_image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1U,
+        &region
+    );
+
+    auto const to_shader_barrier = get_image_barrier(
+        image.color_image,
+        VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    );
+    ::vkCmdPipelineBarrier(
+        upload.command_buffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0U,
+        0U,
+        nullptr,
+        0U,
+        nullptr,
+        1U,
+        &to_shader_barrier
+    );
+
+    CHECK_VK( ::vkEndCommandBuffer( upload.command_buffer ) );
+    return true;
+}
+
+auto submit_transfer( HostTransfer const& transfer, VkDevice const& device, VkQueue const& queue )
+    -> bool
+{
+    CHECK_VK( ::vkResetFences( device, 1U, &transfer.fence ) );
+
+    auto const submit_info = VkSubmitInfo{
+        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                = nullptr,
+        .waitSemaphoreCount   = 0U,
+        .pWaitSemaphores      = nullptr,
+        .pWaitDstStageMask    = nullptr,
+        .commandBufferCount   = 1U,
+        .pCommandBuffers      = &transfer.command_buffer,
+        .signalSemaphoreCount = 0U,
+        .pSignalSemaphores    = nullptr,
+    };
+    CHECK_VK( ::vkQueueSubmit( queue, 1U, &submit_info, transfer.fence ) );
+    return true;
+}
+
+auto get_slot_pixels( net::SharedMemory const& memory, uint64 const slot_size, uint32 const slot )
+    -> std::byte*
+{
+    return static_cast< std::byte* >( memory.data( ) ) + host_ring_pixels_offset
+         + ( slot_size * slot );
+}
+
+// Copies between host buffers and accumulates the time it took.
+auto copy_pixels(
+    HostCopyStats&         stats,
+    void* const            destination,
+    void const* const      source,
+    uint64 const           size,
+    std::string_view const direction
+) -> void
+{
+    auto const start_time = std::chrono::steady_clock::now( );
+    utils::ignore( std::memcpy( destination, source, size ) );
+    auto const end_time = std::chrono::steady_clock::now( );
+
+    stats.copy_time += end_time - start_time;
+    stats.byte_count += size;
+    ++stats.frame_count;
+
+    if ( ( end_time - stats.report_time ) < stats_report_interval )
+    {
+        return;
+    }
+
+    using FloatSeconds = std::chrono::duration< float64 >;
+    auto constexpr bytes_per_mib = 1024.0 * 1024.0;
+
+    auto const elapsed   = end_time - stats.report_time;
+    auto const mib       = static_cast< float64 >( stats.byte_count ) / bytes_per_mib;
+    auto const copy_s    = std::chrono::duration_cast< FloatSeconds >( stats.copy_time ).count( );
+    auto const elapsed_s = std::chrono::duration_cast< FloatSeconds >( elapsed ).count( );
+    spdlog::info(
+        "Host ring {}: {} frames, {:.1f} MiB/s copied at {:.1f} MiB/s ({:.1f}% of the time)",
+        direction,
+        stats.frame_count,
+        mib / elapsed_s,
+        ( copy_s > 0.0 ) ? ( mib / copy_s ) : 0.0,
+        100.0 * copy_s / elapsed_s
+    );
+
+    stats = HostCopyStats{ .report_time = end_time };
+}
+
+} // namespace
+
+auto initialize(
+    HostRingData< ExternalMemory::Export >& ring,
+    AllocatorData&                          allocator,
+    VkDevice const&                         device,
+    VkCommandPool const&                    command_pool,
+    VkExtent3D const                        image_extents,
+    VkFormat const                          color_format,
+    uint32 const                            slot_count
+) -> bool
+{
+    if ( ( 0U == slot_count ) || ( slot_count > max_shared_ring_slots ) )
+    {
+        spdlog::error( "Invalid ring slot count: {}", slot_count );
+        return false;
+    }
+
+    auto const bytes_per_texel = get_bytes_per_texel( color_format );
+    if ( !bytes_per_texel )
+    {
+        spdlog::error( "Unsupported host ring format {}", static_cast< int32 >( color_format ) );
+        return false;
+    }
+
+    ring.generation = static_cast< uint64 >(
+        std::chrono::steady_clock::now( ).time_since_epoch( ).count( )
+    );
+    ring.row_pitch = uint64{ image_extents.width } * bytes_per_texel.value( );
+    ring.slot_size = ring.row_pitch * image_extents.height;
+
+    // Every frame crosses this memory twice, so it's backed by huge pages where possible.
+    CHECK_TRUE( ring.memory.create_hugepage_backed(
+        "ltb_host_ring",
+        host_ring_pixels_offset + ( ring.slot_size * slot_count )
+    ) );
+    ring.control             = new ( ring.memory.data( ) ) HostRingControl{ };
+    ring.control->slot_count = slot_count;
+
+    ring.images.resize( slot_count );
+    ring.readbacks.resize( slot_count );
+    ring.pending_records.assign( slot_count, std::nullopt );
+
+    auto constexpr unused_image_fd = -1;
+    for ( auto slot = 0U; slot < slot_count; ++slot )
+    {
+        CHECK_TRUE( initialize(
+            ring.images[ slot ],
+            allocator,
+            device,
+            image_extents,
+            color_format,
+            unused_image_fd
+        ) );
+        // Cached memory makes the host's reads of the readback much faster.
+        CHECK_TRUE( initialize_transfer(
+            ring.readbacks[ slot ],
+            allocator,
+            device,
+            command_pool,
+            ring.slot_size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            MemoryUsage::HostReadback
+        ) );
+        CHECK_TRUE( record_readback( ring.readbacks[ slot ], ring.images[ slot ] ) );
+    }
+    ring.stats.report_time = std::chrono::steady_clock::now( );
+    spdlog::debug( "Host ring initialized with {} slots", slot_count );
+
+    return true;
+}
+
+auto initialize(
+    HostRingData< ExternalMemory::Import >& ring,
+    AllocatorData&                          allocator,
+    VkDevice const&                         device,
+    VkCommandPool const&                    command_pool,
+    HostRingMessage const&                  message,
+    int32 const                             memory_fd
+) -> bool
+{
+    if ( !ring.memory.map( memory_fd ) )
+    {
+        return false;
+    }
+
+    if ( ( host_ring_message_magic != message.magic )
+         || ( host_ring_message_version != message.version ) )
+    {
+        spdlog::error(
+            "Unsupported host ring message: magic {:#x}, version {}",
+            message.magic,
+            message.version
+        );
+        return false;
+    }
+
+    // The sizes are checked for overflow before the ring is sized from them.
+    auto constexpr max_size    = std::numeric_limits< uint64 >::max( ) - host_ring_pixels_offset;
+    auto const color_format    = static_cast< VkFormat >( message.format );
+    auto const bytes_per_texel = get_bytes_per_texel( color_format );
+    if ( ( !bytes_per_texel ) || ( 0U == message.slot_count )
+         || ( message.slot_count > max_shared_ring_slots ) || ( 0U == message.width )
+         || ( 0U == message.height )
+         || ( message.row_pitch != ( uint64{ message.width } * bytes_per_texel.value( ) ) )
+         || ( message.row_pitch > ( max_size / message.height ) )
+         || ( message.slot_size != ( message.row_pitch * message.height ) )
+         || ( message.slot_size > ( max_size / message.slot_count ) ) )
+    {
+        spdlog::error( "Invalid host ring message" );
+        return false;
+    }
+
+    auto properties = VkPhysicalDeviceProperties{ };
+    ::vkGetPhysicalDeviceProperties( allocator.physical_device, &properties );
+    if ( ( message.width > properties.limits.maxImageDimension2D )
+         || ( message.height > properties.limits.maxImageDimension2D ) )
+    {
+        spdlog::error(
+            "Host ring image {}x{} is larger than the device limit of {}",
+            message.width,
+            message.height,
+            properties.limits.maxImageDimension2D
+        );
+        return false;
+    }
+
+    auto const required_size = host_ring_pixels_offset + ( message.slot_size * message.slot_count );
+    if ( ( ring.memory.size( ) < required_size )
+         || ( message.slot_count
+              != static_cast< HostRingControl* >( ring.memory.data( ) )->slot_count ) )
+    {
+        spdlog::error( "Host ring shared memory doesn't match the message" );
+        return false;
+    }
+    ring.control    = static_cast< HostRingControl* >( ring.memory.data( ) );
+    ring.slot_size  = message.slot_size;
+    ring.generation = message.generation;
+
+    auto constexpr unused_image_fd = -1;
+    CHECK_TRUE( initialize(
+        ring.image,
+        allocator,
+        device,
+        VkExtent3D{ message.width, message.height, 1U },
+        color_format,
+        unused_image_fd
+    ) );
+    // The host only writes to the staging buffer, so write-combined memory is fine.
+    CHECK_TRUE( initialize_transfer(
+        ring.upload,
+        allocator,
+        device,
+        command_pool,
+        ring.slot_size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        MemoryUsage::HostUpload
+    ) );
+    CHECK_TRUE( record_upload( ring.upload, ring.image ) );
+
+    ring.stats.report_time = std::chrono::steady_clock::now( );
+    spdlog::debug( "Host ring imported with {} slots", message.slot_count );
+
+    return true;
+}
+
+auto get_message(
+    HostRingMessage&                              message,
+    int32&                                        memory_fd,
+    HostRingData< ExternalMemory::Export > const& ring
+) -> bool
+{
+    auto const& image = ring.images.front( );
+
+    message            = HostRingMessage{ };
+    message.slot_count = ring.control->slot_count;
+    message.format     = static_cast< uint32 >( image.color_format );
+    message.width      = image.image_size.width;
+    message.height     = image.image_size.height;
+    message.row_pitch  = ring.row_pitch;
+    message.slot_size  = ring.slot_size;
+    message.generation = ring.generation;
+
+    // The shared memory fd is still owned by the ring, so the caller gets a duplicate.
+    if ( memory_fd = ::fcntl( ring.memory.fd( ), F_DUPFD_CLOEXEC, 0 ); memory_fd < 0 )
+    {
+        spdlog::error( "fcntl() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+    return true;
+}
+
+auto acquire_render_slot(
+    HostRingData< ExternalMemory::Export >& ring,
+    uint32&                                 slot,
+    uint64&                                 frame_id
+) -> bool
+{
+    auto const slot_count = uint64{ ring.control->slot_count };
+
+    // The slot was last used by frame_id - slot_count, which has to be published first.
+    if ( ( ring.next_frame_id - ring.next_published ) >= slot_count )
+    {
+        return false;
+    }
+
+    frame_id = ring.next_frame_id;
+    slot     = static_cast< uint32 >( frame_id % slot_count );
+    ++ring.next_frame_id;
+    return true;
+}
+
+auto submit_readback(
+    HostRingData< ExternalMemory::Export >& ring,
+    VkDevice const&                         device,
+    VkQueue const&                          queue,
+    FrameRecord const&                      record
+) -> bool
+{
+    // Queue order runs the copy after the frame's render.
+    CHECK_TRUE( submit_transfer( ring.readbacks[ record.slot ], device, queue ) );
+    ring.pending_records[ record.slot ] = record;
+    return true;
+}
+
+auto publish_frames( HostRingData< ExternalMemory::Export >& ring, VkDevice const& device )
+    -> bool
+{
+    auto const slot_count = uint64{ ring.control->slot_count };
+
+    while ( ring.next_published < ring.next_frame_id )
+    {
+        auto const frame_id = ring.next_published;
+        auto const slot     = static_cast< uint32 >( frame_id % slot_count );
+        auto const& readback = ring.readbacks[ slot ];
+
+        if ( VK_SUCCESS != ::vkGetFenceStatus( device, readback.fence ) )
+        {
+            break;
+        }
+
+        // The consumer may still be copying the frame that last used the slot.
+        auto const released_frame_count
+            = ring.control->released_frame_count.load( std::memory_order_acquire );
+        if ( ( released_frame_count + slot_count ) <= frame_id )
+        {
+            break;
+        }
+
+        auto const& record = ring.pending_records[ slot ];
+        if ( !record )
+        {
+            spdlog::error( "Frame {} was never read back", frame_id );
+            return false;
+        }
+
+        copy_pixels(
+            ring.stats,
+            get_slot_pixels( ring.memory, ring.slot_size, slot ),
+            readback.allocation.mapped,
+            ring.slot_size,
+            "readback"
+        );
+
+        if ( !net::try_push( ring.control->frames, record.value( ) ) )
+        {
+            // Nothing is lost, the frame is copied again on the next call.
+            break;
+        }
+        ring.pending_records[ slot ] = std::nullopt;
+        ++ring.next_published;
+    }
+    return true;
+}
+
+auto latch_ready_frame(
+    HostRingData< ExternalMemory::Import >& ring,
+    VkDevice const&                         device,
+    VkQueue const&                          queue
+) -> bool
+{
+    auto record = FrameRecord{ };
+
+    // The staging buffer can't be overwritten while the last upload is still reading it.
+    if ( ( VK_SUCCESS == ::vkGetFenceStatus( device, ring.upload.fence ) )
+         && net::try_pop( ring.control->frames, record ) )
+    {
+        if ( record.slot >= ring.control->slot_count )
+        {
+            spdlog::error( "Invalid host ring slot {}", record.slot );
+            return false;
+        }
+
+        copy_pixels(
+            ring.stats,
+            ring.upload.allocation.mapped,
+            get_slot_pixels( ring.memory, ring.slot_size, record.slot ),
+            ring.slot_size,
+            "upload"
+        );
+        ring.control->released_frame_count.store( record.frame_id + 1U, std::memory_order_release );
+
+        CHECK_TRUE( submit_transfer( ring.upload, device, queue ) );
+        ring.latched_frame_id = record.frame_id;
+        ring.latched_record   = record;
+    }
+
+    return ring.latched_frame_id.has_value( );
+}
+
+template < ExternalMemory mem_type >
+auto destroy(
+    HostRingData< mem_type >& ring,
+    VkDevice const&           device,
+    VkCommandPool const&      command_pool
+) -> void
+{
+    if constexpr ( ExternalMemory::Export == mem_type )
+    {
+        for ( auto& readback : ring.readbacks )
+        {
+            destroy_transfer( readback, device, command_pool );
+        }
+        ring.readbacks.clear( );
+
+        for ( auto& image : ring.images )
+        {
+            destroy( image, device );
+        }
+        ring.images.clear( );
+        ring.pending_records.clear( );
+    }
+    else
+    {
+        destroy_transfer( ring.upload, device, command_pool );
+        destroy( ring.image, device );
+    }
+
+    ring.control = nullptr;
+    ring.memory.reset( );
+}
+
+template auto destroy(
+    HostRingData< ExternalMemory::Export >&,
+    VkDevice const&,
+    VkCommandPool const&
+) -> void;
+template auto destroy(
+    HostRingData< ExternalMemory::Import >&,
+    VkDevice const&,
+    VkCommandPool const&
+) -> void;
+
+} // namespace ltb::vlk
@@ -7,68 +7,155 @@
 #include "ltb/vlk/check.hpp"
 
 // standard
+#include <algorithm>
 #include <optional>
 
 // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VK_KHR_external_memory.html
+// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VK_EXT_image_drm_format_modifier.html
 
 namespace ltb::vlk
 {
 namespace
 {
 
-auto constexpr external_memory_handle_type = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+auto constexpr color_image_usage = VkImageUsageFlags{
+    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+};
 
-auto get_memory_type_index(
-    VkPhysicalDevice const&     physical_device,
-    VkMemoryRequirements const& memory_requirements
-)
+// Images that stay in this process can also be copied to and from host memory.
+auto constexpr local_color_image_usage = VkImageUsageFlags{
+    color_image_usage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+};
+
+auto constexpr memory_plane_aspects = std::array{
+    VK_IMAGE_ASPECT_MEMORY_PLANE_0_BIT_EXT,
+    VK_IMAGE_ASPECT_MEMORY_PLANE_1_BIT_EXT,
+    VK_IMAGE_ASPECT_MEMORY_PLANE_2_BIT_EXT,
+    VK_IMAGE_ASPECT_MEMORY_PLANE_3_BIT_EXT,
+};
+static_assert( max_memory_planes == memory_plane_aspects.size( ) );
+
+auto external_memory_handle_type( ExternalHandle const handle_type )
+    -> VkExternalMemoryHandleTypeFlagBits
+{
+    if ( ExternalHandle::DmaBuf == handle_type )
+    {
+        return VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT;
+    }
+    return VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+}
+
+// Finds the modifiers of a format that can be rendered to, sampled, and exported as a dma-buf.
+auto get_exportable_drm_format_modifiers(
+    VkPhysicalDevice const&                          physical_device,
+    VkFormat const                                   color_format,
+    std::vector< VkDrmFormatModifierPropertiesEXT >& modifiers
+) -> void
 {
-    auto memory_props = VkPhysicalDeviceMemoryProperties{ };
-    ::vkGetPhysicalDeviceMemoryProperties( physical_device, &memory_props );
-    auto const mem_prop_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    auto modifier_list = VkDrmFormatModifierPropertiesListEXT{
+        .sType                        = VK_STRUCTURE_TYPE_DRM_FORMAT_MODIFIER_PROPERTIES_LIST_EXT,
+        .pNext                        = nullptr,
+        .drmFormatModifierCount       = 0U,
+        .pDrmFormatModifierProperties = nullptr,
+    };
+    auto format_properties = VkFormatProperties2{
+        .sType            = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2,
+        .pNext            = &modifier_list,
+        .formatProperties = { },
+    };
+    ::vkGetPhysicalDeviceFormatProperties2( physical_device, color_format, &format_properties );
+
+    auto all_modifiers = std::vector< VkDrmFormatModifierPropertiesEXT >(
+        modifier_list.drmFormatModifierCount
+    );
+    modifier_list.pDrmFormatModifierProperties = all_modifiers.data( );
+    ::vkGetPhysicalDeviceFormatProperties2( physical_device, color_format, &format_properties );
+
+    auto constexpr required_features = VkFormatFeatureFlags{
+        VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+    };
 
-    auto memory_type_index = std::optional< uint32 >{ };
-    for ( auto i = 0u; i < memory_props.memoryTypeCount; ++i )
+    modifiers.clear( );
+    for ( auto const& modifier : all_modifiers )
     {
-        auto const type_is_suitable = ( 0 != ( memory_requirements.memoryTypeBits & ( 1u << i ) ) );
-        auto const props_exist
-            = ( memory_props.memoryTypes[ i ].propertyFlags & mem_prop_flags ) == mem_prop_flags;
+        if ( ( modifier.drmFormatModifierPlaneCount > max_memory_planes )
+             || ( ( modifier.drmFormatModifierTilingFeatures & required_features )
+                  != required_features ) )
+        {
+            continue;
+        }
+
+        auto const modifier_info = VkPhysicalDeviceImageDrmFormatModifierInfoEXT{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_DRM_FORMAT_MODIFIER_INFO_EXT,
+            .pNext = nullptr,
+            .drmFormatModifier     = modifier.drmFormatModifier,
+            .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0U,
+            .pQueueFamilyIndices   = nullptr,
+        };
+        auto const external_info = VkPhysicalDeviceExternalImageFormatInfo{
+            .sType      = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+            .pNext      = &modifier_info,
+            .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+        };
+        auto const image_format_info = VkPhysicalDeviceImageFormatInfo2{
+            .sType  = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+            .pNext  = &external_info,
+            .format = color_format,
+            .type   = VK_IMAGE_TYPE_2D,
+            .tiling = VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT,
+            .usage  = color_image_usage,
+            .flags  = 0U,
+        };
+        auto external_properties = VkExternalImageFormatProperties{
+            .sType                    = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+            .pNext                    = nullptr,
+            .externalMemoryProperties = { },
+        };
+        auto image_format_properties = VkImageFormatProperties2{
+            .sType                 = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+            .pNext                 = &external_properties,
+            .imageFormatProperties = { },
+        };
 
-        if ( ( !memory_type_index ) && type_is_suitable && props_exist )
+        auto const exportable
+            = ( VK_SUCCESS
+                == ::vkGetPhysicalDeviceImageFormatProperties2(
+                    physical_device,
+                    &image_format_info,
+                    &image_format_properties
+                ) )
+           && ( 0U
+                != ( external_properties.externalMemoryProperties.externalMemoryFeatures
+                     & VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT ) );
+
+        if ( exportable )
         {
-            memory_type_index = uint32{ i };
+            modifiers.push_back( modifier );
         }
     }
-
-    return memory_type_index;
 }
 
-} // namespace
-
+// Creates the image, with `tiling_info` chained after the external memory info.
 template < ExternalMemory mem_type >
-auto initialize(
-    ImageData< mem_type >&  image,
-    VkPhysicalDevice const& physical_device,
-    VkDevice const&         device,
-    VkExtent3D const        image_extents,
-    VkFormat const          color_format,
-    int32 const             import_image_fd
+auto create_image(
+    ImageData< mem_type >& image,
+    VkDevice const&        device,
+    void const*            tiling_info
 ) -> bool
 {
-    image.image_size = VkExtent2D{ image_extents.width, image_extents.height };
-
     auto color_image_create_info = VkImageCreateInfo{
         .sType                 = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .pNext                 = nullptr,
         .flags                 = 0,
         .imageType             = VK_IMAGE_TYPE_2D,
-        .format                = color_format,
-        .extent                = image_extents,
+        .format                = image.color_format,
+        .extent                = VkExtent3D{ image.image_size.width, image.image_size.height, 1U },
         .mipLevels             = 1U,
         .arrayLayers           = 1U,
         .samples               = VK_SAMPLE_COUNT_1_BIT,
-        .tiling                = VK_IMAGE_TILING_OPTIMAL,
-        .usage                 = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .tiling                = image.image_tiling,
+        .usage                 = color_image_usage,
         .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
         .queueFamilyIndexCount = 0U,
         .pQueueFamilyIndices   = nullptr,
@@ -77,6 +164,7 @@ auto initialize(
 
     if constexpr ( mem_type == ExternalMemory::None )
     {
+        color_image_create_info.usage = local_color_image_usage;
         CHECK_VK( ::vkCreateImage( device, &color_image_create_info, nullptr, &image.color_image )
         );
         spdlog::debug( "vkCreateImage()" );
@@ -85,8 +173,8 @@ auto initialize(
     {
         auto const external_color_image_info = VkExternalMemoryImageCreateInfo{
             .sType       = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
-            .pNext       = nullptr,
-            .handleTypes = external_memory_handle_type,
+            .pNext       = tiling_info,
+            .handleTypes = external_memory_handle_type( image.external_handle ),
         };
         color_image_create_info.pNext = &external_color_image_info;
 
@@ -97,75 +185,70 @@ auto initialize(
 
     ::vkGetImageMemoryRequirements( device, image.color_image, &image.memory_requirements );
 
-    if ( auto const memory_type_index
-         = get_memory_type_index( physical_device, image.memory_requirements ) )
-    {
-        image.memory_type_index = memory_type_index.value( );
-    }
-    else
+    return true;
+}
+
+// Reads back the modifier the driver picked out of the list the image was created with.
+template < ExternalMemory mem_type >
+auto get_drm_format_modifier( ImageData< mem_type >& image, VkDevice const& device ) -> bool
+{
+    auto* const vkGetImageDrmFormatModifierPropertiesEXT
+        = reinterpret_cast< PFN_vkGetImageDrmFormatModifierPropertiesEXT >(
+            ::vkGetDeviceProcAddr( device, "vkGetImageDrmFormatModifierPropertiesEXT" )
+        );
+    if ( nullptr == vkGetImageDrmFormatModifierPropertiesEXT )
     {
-        spdlog::error( "No suitable memory type found" );
+        spdlog::error( "vkGetDeviceProcAddr() failed" );
         return false;
     }
 
-    auto color_image_alloc_info = VkMemoryAllocateInfo{
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext           = nullptr,
-        .allocationSize  = image.memory_requirements.size,
-        .memoryTypeIndex = image.memory_type_index,
+    auto modifier_properties = VkImageDrmFormatModifierPropertiesEXT{
+        .sType             = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_PROPERTIES_EXT,
+        .pNext             = nullptr,
+        .drmFormatModifier = 0U,
     };
+    CHECK_VK(
+        vkGetImageDrmFormatModifierPropertiesEXT( device, image.color_image, &modifier_properties )
+    );
+    image.drm_format_modifier = modifier_properties.drmFormatModifier;
 
-    if constexpr ( mem_type == ExternalMemory::Export )
-    {
-        auto const export_image_memory_info = VkExportMemoryAllocateInfo{
-            .sType       = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
-            .pNext       = nullptr,
-            .handleTypes = external_memory_handle_type,
-        };
-        color_image_alloc_info.pNext = &export_image_memory_info;
+    return true;
+}
 
-        CHECK_VK( ::vkAllocateMemory(
-            device,
-            &color_image_alloc_info,
-            nullptr,
-            &image.color_image_memory
-        ) );
-        spdlog::debug( "vkAllocateMemory() w/ export" );
-    }
-    else if constexpr ( mem_type == ExternalMemory::Import )
+// Reads back where each memory plane of the picked modifier lives in the allocation.
+template < ExternalMemory mem_type >
+auto get_plane_layouts(
+    ImageData< mem_type >& image,
+    VkDevice const&        device,
+    uint32 const           plane_count
+) -> void
+{
+    image.plane_layouts.resize( plane_count );
+    for ( auto plane = 0U; plane < plane_count; ++plane )
     {
-        if ( import_image_fd < 0 )
-        {
-            spdlog::error( "Invalid file descriptor" );
-            return false;
-        }
-        auto const export_image_memory_info = VkImportMemoryFdInfoKHR{
-            .sType      = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
-            .pNext      = nullptr,
-            .handleType = external_memory_handle_type,
-            .fd         = import_image_fd,
+        auto const subresource = VkImageSubresource{
+            .aspectMask = memory_plane_aspects[ plane ],
+            .mipLevel   = 0U,
+            .arrayLayer = 0U,
         };
-        color_image_alloc_info.pNext = &export_image_memory_info;
-        CHECK_VK( ::vkAllocateMemory(
-            device,
-            &color_image_alloc_info,
-            nullptr,
-            &image.color_image_memory
-        ) );
-        spdlog::debug( "vkAllocateMemory() w/ import" );
-    }
-    else
-    {
-        CHECK_VK( ::vkAllocateMemory(
+        ::vkGetImageSubresourceLayout(
             device,
-            &color_image_alloc_info,
-            nullptr,
-            &image.color_image_memory
-        ) );
-        spdlog::debug( "vkAllocateMemory()" );
+            image.color_image,
+            &subresource,
+            &image.plane_layouts[ plane ]
+        );
     }
+}
 
-    CHECK_VK( ::vkBindImageMemory( device, image.color_image, image.color_image_memory, 0U ) );
+template < ExternalMemory mem_type >
+auto bind_and_create_image_view( ImageData< mem_type >& image, VkDevice const& device ) -> bool
+{
+    CHECK_VK( ::vkBindImageMemory(
+        device,
+        image.color_image,
+        image.color_image_memory,
+        image.memory_offset
+    ) );
 
     auto const color_image_view_create_info = VkImageViewCreateInfo{
         .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
@@ -173,7 +256,7 @@ auto initialize(
         .flags            = 0U,
         .image            = image.color_image,
         .viewType         = VK_IMAGE_VIEW_TYPE_2D,
-        .format           = color_format,
+        .format           = image.color_format,
         .components       = VkComponentMapping{ },
         .subresourceRange = VkImageSubresourceRange{
             .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -194,9 +277,427 @@ auto initialize(
     return true;
 }
 
+// Creates a new image, without any memory bound to it yet.
+template < ExternalMemory mem_type >
+auto create_new_image(
+    ImageData< mem_type >& image,
+    AllocatorData const&   allocator,
+    VkDevice const&        device,
+    VkExtent3D const       image_extents,
+    VkFormat const         color_format,
+    ExternalHandle const   handle_type
+) -> bool
+{
+    image.image_size      = VkExtent2D{ image_extents.width, image_extents.height };
+    image.color_format    = color_format;
+    image.image_tiling    = VK_IMAGE_TILING_OPTIMAL;
+    image.external_handle = handle_type;
+    image.memory_offset   = 0U;
+
+    auto const uses_dma_buf
+        = ( mem_type != ExternalMemory::None ) && ( ExternalHandle::DmaBuf == handle_type );
+
+    if ( uses_dma_buf )
+    {
+        if constexpr ( mem_type != ExternalMemory::Export )
+        {
+            spdlog::error( "Dma-buf images can only be imported from a description" );
+            return false;
+        }
+
+        // The driver picks one of the modifiers every importer is expected to understand.
+        auto modifiers = std::vector< VkDrmFormatModifierPropertiesEXT >{ };
+        get_exportable_drm_format_modifiers( allocator.physical_device, color_format, modifiers );
+        if ( modifiers.empty( ) )
+        {
+            spdlog::error(
+                "No exportable DRM format modifiers for format {}",
+                static_cast< int32 >( color_format )
+            );
+            return false;
+        }
+
+        auto modifier_values = std::vector< uint64 >{ };
+        for ( auto const& modifier : modifiers )
+        {
+            modifier_values.push_back( modifier.drmFormatModifier );
+        }
+        auto const modifier_list_info = VkImageDrmFormatModifierListCreateInfoEXT{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_LIST_CREATE_INFO_EXT,
+            .pNext = nullptr,
+            .drmFormatModifierCount = static_cast< uint32 >( modifier_values.size( ) ),
+            .pDrmFormatModifiers    = modifier_values.data( ),
+        };
+
+        image.image_tiling = VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT;
+        CHECK_TRUE( create_image( image, device, &modifier_list_info ) );
+
+        CHECK_TRUE( get_drm_format_modifier( image, device ) );
+
+        auto const picked_modifier = std::ranges::find_if(
+            modifiers,
+            [ &image ]( VkDrmFormatModifierPropertiesEXT const& modifier )
+            { return modifier.drmFormatModifier == image.drm_format_modifier; }
+        );
+        if ( modifiers.end( ) == picked_modifier )
+        {
+            spdlog::error( "The driver picked an unlisted DRM format modifier" );
+            return false;
+        }
+        get_plane_layouts( image, device, picked_modifier->drmFormatModifierPlaneCount );
+    }
+    else
+    {
+        CHECK_TRUE( create_image( image, device, nullptr ) );
+    }
+
+    return true;
+}
+
+// Sub-allocates memory for a new local image, or allocates exported and imported
+// memory on its own, then binds it.
+template < ExternalMemory mem_type >
+auto allocate_image_memory(
+    ImageData< mem_type >& image,
+    AllocatorData&         allocator,
+    VkDevice const&        device,
+    int32 const            import_image_fd
+) -> bool
+{
+    if constexpr ( mem_type == ExternalMemory::None )
+    {
+        CHECK_TRUE( allocate(
+            image.allocation,
+            allocator,
+            device,
+            image.memory_requirements,
+            MemoryUsage::DeviceLocal,
+            VK_IMAGE_TILING_LINEAR == image.image_tiling
+        ) );
+        image.allocator          = &allocator;
+        image.color_image_memory = image.allocation.memory;
+        image.memory_offset      = image.allocation.offset;
+        image.memory_type_index  = image.allocation.memory_type_index;
+        image.owns_memory        = false;
+    }
+    else
+    {
+        auto const handle_type  = image.external_handle;
+        auto const uses_dma_buf = ( ExternalHandle::DmaBuf == handle_type );
+
+        if ( auto const memory_type_index = find_memory_type_index(
+                 allocator,
+                 image.memory_requirements.memoryTypeBits,
+                 MemoryUsage::Exportable
+             ) )
+        {
+            image.memory_type_index = memory_type_index.value( );
+        }
+        else
+        {
+            spdlog::error( "No suitable memory type found" );
+            return false;
+        }
+
+        // Drivers commonly require images with explicit modifiers to own their allocation.
+        auto const dedicated_alloc_info = VkMemoryDedicatedAllocateInfo{
+            .sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+            .pNext  = nullptr,
+            .image  = image.color_image,
+            .buffer = nullptr,
+        };
+
+        auto color_image_alloc_info = VkMemoryAllocateInfo{
+            .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .pNext           = nullptr,
+            .allocationSize  = image.memory_requirements.size,
+            .memoryTypeIndex = image.memory_type_index,
+        };
+
+        if constexpr ( mem_type == ExternalMemory::Export )
+        {
+            auto const export_image_memory_info = VkExportMemoryAllocateInfo{
+                .sType       = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+                .pNext       = uses_dma_buf ? &dedicated_alloc_info : nullptr,
+                .handleTypes = external_memory_handle_type( handle_type ),
+            };
+            color_image_alloc_info.pNext = &export_image_memory_info;
+
+            CHECK_VK( ::vkAllocateMemory(
+                device,
+                &color_image_alloc_info,
+                nullptr,
+                &image.color_image_memory
+            ) );
+            spdlog::debug( "vkAllocateMemory() w/ export" );
+        }
+        else
+        {
+            if ( import_image_fd < 0 )
+            {
+                spdlog::error( "Invalid file descriptor" );
+                return false;
+            }
+            auto const import_image_memory_info = VkImportMemoryFdInfoKHR{
+                .sType      = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
+                .pNext      = nullptr,
+                .handleType = external_memory_handle_type( handle_type ),
+                .fd         = import_image_fd,
+            };
+            color_image_alloc_info.pNext = &import_image_memory_info;
+            CHECK_VK( ::vkAllocateMemory(
+                device,
+                &color_image_alloc_info,
+                nullptr,
+                &image.color_image_memory
+            ) );
+            spdlog::debug( "vkAllocateMemory() w/ import" );
+        }
+    }
+
+    CHECK_TRUE( bind_and_create_image_view( image, device ) );
+
+    return true;
+}
+
+template < ExternalMemory mem_type >
+auto initialize_image(
+    ImageData< mem_type >& image,
+    AllocatorData&         allocator,
+    VkDevice const&        device,
+    VkExtent3D const       image_extents,
+    VkFormat const         color_format,
+    ExternalHandle const   handle_type,
+    int32 const            import_image_fd
+) -> bool
+{
+    CHECK_TRUE(
+        create_new_image( image, allocator, device, image_extents, color_format, handle_type )
+    );
+    CHECK_TRUE( allocate_image_memory( image, allocator, device, import_image_fd ) );
+
+    return true;
+}
+
+// Recreates an exported image from its description, without any memory bound to it yet.
+auto create_described_image(
+    ImageData< ExternalMemory::Import >& image,
+    VkDevice const&                      device,
+    ExternalImageDescription const&      description
+) -> bool
+{
+    if ( description.handle_type > static_cast< uint32 >( ExternalHandle::DmaBuf ) )
+    {
+        spdlog::error( "Unknown external handle type: {}", description.handle_type );
+        return false;
+    }
+
+    image.image_size      = VkExtent2D{ description.width, description.height };
+    image.color_format    = static_cast< VkFormat >( description.format );
+    image.image_tiling    = static_cast< VkImageTiling >( description.tiling );
+    image.external_handle = static_cast< ExternalHandle >( description.handle_type );
+    image.memory_offset   = description.offset;
+
+    if ( ExternalHandle::DmaBuf == image.external_handle )
+    {
+        if ( ( VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT != image.image_tiling )
+             || ( 0U == description.plane_count )
+             || ( description.plane_count > max_memory_planes ) )
+        {
+            spdlog::error( "Invalid dma-buf image description" );
+            return false;
+        }
+
+        // The exporter's layout is used as-is, so the memory is never copied or re-tiled.
+        image.drm_format_modifier = description.drm_format_modifier;
+        image.plane_layouts.resize( description.plane_count );
+        for ( auto plane = 0U; plane < description.plane_count; ++plane )
+        {
+            image.plane_layouts[ plane ] = VkSubresourceLayout{
+                .offset     = description.planes[ plane ].offset,
+                .size       = 0U,
+                .rowPitch   = description.planes[ plane ].row_pitch,
+                .arrayPitch = 0U,
+                .depthPitch = 0U,
+            };
+        }
+        auto const explicit_modifier_info = VkImageDrmFormatModifierExplicitCreateInfoEXT{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_EXPLICIT_CREATE_INFO_EXT,
+            .pNext = nullptr,
+            .drmFormatModifier           = image.drm_format_modifier,
+            .drmFormatModifierPlaneCount = description.plane_count,
+            .pPlaneLayouts               = image.plane_layouts.data( ),
+        };
+        CHECK_TRUE( create_image( image, device, &explicit_modifier_info ) );
+    }
+    else
+    {
+        CHECK_TRUE( create_image( image, device, nullptr ) );
+    }
+
+    // The exported allocation is imported as-is, so this image has to fit inside it. The
+    // offset comes from another process, so it's checked without adding to it.
+    if ( ( description.offset > description.allocation_size )
+         || ( image.memory_requirements.size
+              > ( description.allocation_size - description.offset ) ) )
+    {
+        spdlog::error(
+            "Image needs {} bytes at offset {} but the allocation is {} bytes",
+            image.memory_requirements.size,
+            description.offset,
+            description.allocation_size
+        );
+        return false;
+    }
+
+    // The image is bound at the offset it was exported at, so it has to be aligned for it.
+    if ( 0U != ( description.offset % image.memory_requirements.alignment ) )
+    {
+        spdlog::error(
+            "Image offset {} isn't aligned to {} bytes",
+            description.offset,
+            image.memory_requirements.alignment
+        );
+        return false;
+    }
+
+    return true;
+}
+
+// Opaque fds must be imported as the exporter's memory type. Dma-bufs may come from
+// another driver, so the driver reports which of its own memory types can hold them.
+auto get_importable_memory_type_bits(
+    uint32&                         memory_type_bits,
+    VkDevice const&                 device,
+    ExternalImageDescription const& description,
+    int32 const                     import_memory_fd
+) -> bool
+{
+    memory_type_bits = description.memory_type_bits;
+    if ( static_cast< uint32 >( ExternalHandle::DmaBuf ) != description.handle_type )
+    {
+        return true;
+    }
+
+    auto* const vkGetMemoryFdPropertiesKHR = reinterpret_cast< PFN_vkGetMemoryFdPropertiesKHR >(
+        ::vkGetDeviceProcAddr( device, "vkGetMemoryFdPropertiesKHR" )
+    );
+    if ( nullptr == vkGetMemoryFdPropertiesKHR )
+    {
+        spdlog::error( "vkGetDeviceProcAddr() failed" );
+        return false;
+    }
+
+    auto fd_properties = VkMemoryFdPropertiesKHR{
+        .sType          = VK_STRUCTURE_TYPE_MEMORY_FD_PROPERTIES_KHR,
+        .pNext          = nullptr,
+        .memoryTypeBits = 0U,
+    };
+    CHECK_VK( vkGetMemoryFdPropertiesKHR(
+        device,
+        VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+        import_memory_fd,
+        &fd_properties
+    ) );
+    memory_type_bits = fd_properties.memoryTypeBits;
+    return true;
+}
+
+auto requires_dedicated_allocation( VkImage const& image, VkDevice const& device ) -> bool
+{
+    auto dedicated_requirements = VkMemoryDedicatedRequirements{
+        .sType                       = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS,
+        .pNext                       = nullptr,
+        .prefersDedicatedAllocation  = VK_FALSE,
+        .requiresDedicatedAllocation = VK_FALSE,
+    };
+    auto const requirements_info = VkImageMemoryRequirementsInfo2{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2,
+        .pNext = nullptr,
+        .image = image,
+    };
+    auto requirements = VkMemoryRequirements2{
+        .sType              = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2,
+        .pNext              = &dedicated_requirements,
+        .memoryRequirements = { },
+    };
+    ::vkGetImageMemoryRequirements2( device, &requirements_info, &requirements );
+    return VK_TRUE == dedicated_requirements.requiresDedicatedAllocation;
+}
+
+// Binds every image into the pool's memory, each at the offset it was assigned.
+template < ExternalMemory mem_type >
+auto bind_pooled_images(
+    ImagePoolData< mem_type > const&      pool,
+    std::vector< ImageData< mem_type > >& images,
+    VkDevice const&                       device
+) -> bool
+{
+    for ( auto& image : images )
+    {
+        image.color_image_memory = pool.memory;
+        image.memory_type_index  = pool.memory_type_index;
+        image.owns_memory        = false;
+        CHECK_TRUE( bind_and_create_image_view( image, device ) );
+    }
+    return true;
+}
+
+auto get_memory_fd(
+    int32&                file_descriptor,
+    VkInstance const&     instance,
+    VkDevice const&       device,
+    VkDeviceMemory const& memory,
+    ExternalHandle const  handle_type
+) -> bool
+{
+    auto* const vkGetMemoryFdKHR = reinterpret_cast< PFN_vkGetMemoryFdKHR >(
+        ::vkGetInstanceProcAddr( instance, "vkGetMemoryFdKHR" )
+    );
+    if ( nullptr == vkGetMemoryFdKHR )
+    {
+        spdlog::error( "vkGetInstanceProcAddr() failed" );
+        return false;
+    }
+
+    auto const memory_info = VkMemoryGetFdInfoKHR{
+        .sType      = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+        .pNext      = nullptr,
+        .memory     = memory,
+        .handleType = external_memory_handle_type( handle_type ),
+    };
+    CHECK_VK( vkGetMemoryFdKHR( device, &memory_info, &file_descriptor ) );
+    spdlog::debug( "vkGetMemoryFdKHR()" );
+
+    return true;
+}
+
+} // namespace
+
+template < ExternalMemory mem_type >
+auto initialize(
+    ImageData< mem_type >& image,
+    AllocatorData&         allocator,
+    VkDevice const&        device,
+    VkExtent3D const       image_extents,
+    VkFormat const         color_format,
+    int32 const            import_image_fd
+) -> bool
+{
+    return initialize_image(
+        image,
+        allocator,
+        device,
+        image_extents,
+        color_format,
+        ExternalHandle::OpaqueFd,
+        import_image_fd
+    );
+}
+
 template auto initialize(
     ImageData< ExternalMemory::None >&,
-    VkPhysicalDevice const&,
+    AllocatorData&,
     VkDevice const&,
     VkExtent3D,
     VkFormat,
@@ -204,7 +705,7 @@ template auto initialize(
 ) -> bool;
 template auto initialize(
     ImageData< ExternalMemory::Export >&,
-    VkPhysicalDevice const&,
+    AllocatorData&,
     VkDevice const&,
     VkExtent3D,
     VkFormat,
@@ -212,41 +713,357 @@ template auto initialize(
 ) -> bool;
 template auto initialize(
     ImageData< ExternalMemory::Import >&,
-    VkPhysicalDevice const&,
+    AllocatorData&,
     VkDevice const&,
     VkExtent3D,
     VkFormat,
     int32
 ) -> bool;
 
-auto get_file_descriptor(
-    int32&                file_descriptor,
-    VkInstance const&     instance,
-    VkDevice const&       device,
-    VkDeviceMemory const& image_memory
+auto initialize(
+    ImageData< ExternalMemory::Export >& image,
+    AllocatorData&                       allocator,
+    VkDevice const&                      device,
+    VkExtent3D const                     image_extents,
+    VkFormat const                       color_format,
+    ExternalHandle const                 handle_type
 ) -> bool
 {
-    auto* const vkGetMemoryFdKHR = reinterpret_cast< PFN_vkGetMemoryFdKHR >(
-        ::vkGetInstanceProcAddr( instance, "vkGetMemoryFdKHR" )
+    auto constexpr unused_image_fd = -1;
+    return initialize_image(
+        image,
+        allocator,
+        device,
+        image_extents,
+        color_format,
+        handle_type,
+        unused_image_fd
     );
-    if ( nullptr == vkGetMemoryFdKHR )
+}
+
+auto initialize(
+    ImageData< ExternalMemory::Import >& image,
+    AllocatorData&                       allocator,
+    VkDevice const&                      device,
+    ExternalImageDescription const&      description,
+    int32 const                          import_image_fd
+) -> bool
+{
+    if ( import_image_fd < 0 )
     {
-        spdlog::error( "vkGetInstanceProcAddr() failed" );
+        spdlog::error( "Invalid file descriptor" );
         return false;
     }
 
-    auto const memory_info = VkMemoryGetFdInfoKHR{
-        .sType      = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+    CHECK_TRUE( create_described_image( image, device, description ) );
+
+    auto importable_type_bits = uint32{ 0 };
+    CHECK_TRUE( get_importable_memory_type_bits(
+        importable_type_bits,
+        device,
+        description,
+        import_image_fd
+    ) );
+
+    if ( auto const memory_type_index = find_memory_type_index(
+             allocator,
+             image.memory_requirements.memoryTypeBits & importable_type_bits,
+             MemoryUsage::Exportable
+         ) )
+    {
+        image.memory_type_index = memory_type_index.value( );
+    }
+    else
+    {
+        spdlog::error( "No memory type matches the exported allocation" );
+        return false;
+    }
+
+    auto const uses_dma_buf         = ( ExternalHandle::DmaBuf == image.external_handle );
+    auto const dedicated_alloc_info = VkMemoryDedicatedAllocateInfo{
+        .sType  = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+        .pNext  = nullptr,
+        .image  = image.color_image,
+        .buffer = nullptr,
+    };
+    auto const import_image_memory_info = VkImportMemoryFdInfoKHR{
+        .sType      = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
+        .pNext      = uses_dma_buf ? &dedicated_alloc_info : nullptr,
+        .handleType = external_memory_handle_type( image.external_handle ),
+        .fd         = import_image_fd,
+    };
+    // Opaque fds must also match the exporter's allocation size exactly.
+    auto const allocation_size
+        = uses_dma_buf ? image.memory_requirements.size : description.allocation_size;
+    auto const color_image_alloc_info = VkMemoryAllocateInfo{
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext           = &import_image_memory_info,
+        .allocationSize  = allocation_size,
+        .memoryTypeIndex = image.memory_type_index,
+    };
+    CHECK_VK( ::vkAllocateMemory(
+        device,
+        &color_image_alloc_info,
+        nullptr,
+        &image.color_image_memory
+    ) );
+    spdlog::debug( "vkAllocateMemory() w/ import" );
+
+    CHECK_TRUE( bind_and_create_image_view( image, device ) );
+
+    return true;
+}
+
+auto initialize(
+    ImagePoolData< ExternalMemory::Export >&            pool,
+    std::vector< ImageData< ExternalMemory::Export > >& images,
+    AllocatorData&                                      allocator,
+    VkDevice const&                                     device,
+    VkExtent3D const                                    image_extents,
+    VkFormat const                                      color_format,
+    ExternalHandle const                                handle_type,
+    uint32 const                                        image_count
+) -> bool
+{
+    images.resize( image_count );
+    for ( auto& image : images )
+    {
+        CHECK_TRUE( create_new_image(
+            image,
+            allocator,
+            device,
+            image_extents,
+            color_format,
+            handle_type
+        ) );
+    }
+
+    auto const needs_own_memory = std::ranges::any_of(
+        images,
+        [ &device ]( ImageData< ExternalMemory::Export > const& image )
+        { return requires_dedicated_allocation( image.color_image, device ); }
+    );
+    if ( needs_own_memory )
+    {
+        spdlog::info( "The driver requires dedicated image allocations, images aren't pooled" );
+        for ( auto& image : images )
+        {
+            auto constexpr unused_image_fd = -1;
+            CHECK_TRUE( allocate_image_memory( image, allocator, device, unused_image_fd ) );
+        }
+        return true;
+    }
+
+    // Each image starts at the first offset past the previous one that meets its alignment.
+    auto pool_requirements = VkMemoryRequirements{
+        .size           = 0U,
+        .alignment      = 1U,
+        .memoryTypeBits = ~0U,
+    };
+    for ( auto& image : images )
+    {
+        auto const& requirements = image.memory_requirements;
+        auto const  alignment    = std::max( requirements.alignment, VkDeviceSize{ 1U } );
+        auto const  padded_size  = pool_requirements.size + alignment - 1U;
+
+        image.memory_offset               = ( padded_size / alignment ) * alignment;
+        pool_requirements.size            = image.memory_offset + requirements.size;
+        pool_requirements.alignment       = std::max( pool_requirements.alignment, alignment );
+        pool_requirements.memoryTypeBits &= requirements.memoryTypeBits;
+    }
+
+    if ( auto const memory_type_index = find_memory_type_index(
+             allocator,
+             pool_requirements.memoryTypeBits,
+             MemoryUsage::Exportable
+         ) )
+    {
+        pool.memory_type_index = memory_type_index.value( );
+    }
+    else
+    {
+        spdlog::error( "No memory type suits every pooled image" );
+        return false;
+    }
+    pool.allocation_size = pool_requirements.size;
+    pool.external_handle = handle_type;
+
+    auto const export_memory_info = VkExportMemoryAllocateInfo{
+        .sType       = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+        .pNext       = nullptr,
+        .handleTypes = external_memory_handle_type( handle_type ),
+    };
+    auto const pool_alloc_info = VkMemoryAllocateInfo{
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext           = &export_memory_info,
+        .allocationSize  = pool.allocation_size,
+        .memoryTypeIndex = pool.memory_type_index,
+    };
+    CHECK_VK( ::vkAllocateMemory( device, &pool_alloc_info, nullptr, &pool.memory ) );
+    spdlog::debug( "vkAllocateMemory() w/ export, {} pooled images", images.size( ) );
+
+    CHECK_TRUE( bind_pooled_images( pool, images, device ) );
+
+    return true;
+}
+
+auto initialize(
+    ImagePoolData< ExternalMemory::Import >&            pool,
+    std::vector< ImageData< ExternalMemory::Import > >& images,
+    AllocatorData&                                      allocator,
+    VkDevice const&                                     device,
+    std::span< ExternalImageDescription const >         descriptions,
+    int32 const                                         import_memory_fd
+) -> bool
+{
+    if ( import_memory_fd < 0 )
+    {
+        spdlog::error( "Invalid file descriptor" );
+        return false;
+    }
+
+    if ( descriptions.empty( ) )
+    {
+        spdlog::error( "Image pools need at least one image" );
+        return false;
+    }
+
+    // Every image describes the same allocation.
+    auto const& first_description = descriptions.front( );
+    auto const  describes_pool    = std::ranges::all_of(
+        descriptions,
+        [ &first_description ]( ExternalImageDescription const& description )
+        {
+            return ( description.allocation_size == first_description.allocation_size )
+                && ( description.memory_type_bits == first_description.memory_type_bits )
+                && ( description.handle_type == first_description.handle_type );
+        }
+    );
+    if ( !describes_pool )
+    {
+        spdlog::error( "Pooled images describe different allocations" );
+        return false;
+    }
+
+    images.resize( descriptions.size( ) );
+    auto memory_type_bits = uint32{ 0 };
+    CHECK_TRUE( get_importable_memory_type_bits(
+        memory_type_bits,
+        device,
+        first_description,
+        import_memory_fd
+    ) );
+
+    for ( auto index = 0U; index < descriptions.size( ); ++index )
+    {
+        CHECK_TRUE( create_described_image( images[ index ], device, descriptions[ index ] ) );
+        memory_type_bits &= images[ index ].memory_requirements.memoryTypeBits;
+    }
+
+    if ( auto const memory_type_index
+         = find_memory_type_index( allocator, memory_type_bits, MemoryUsage::Exportable ) )
+    {
+        pool.memory_type_index = memory_type_index.value( );
+    }
+    else
+    {
+        spdlog::error( "No memory type matches the exported pool" );
+        return false;
+    }
+    pool.allocation_size = first_description.allocation_size;
+    pool.external_handle = images.front( ).external_handle;
+
+    // The whole pool is imported, at exactly the exporter's size.
+    auto const import_memory_info = VkImportMemoryFdInfoKHR{
+        .sType      = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
         .pNext      = nullptr,
-        .memory     = image_memory,
-        .handleType = external_memory_handle_type,
+        .handleType = external_memory_handle_type( pool.external_handle ),
+        .fd         = import_memory_fd,
     };
-    CHECK_VK( vkGetMemoryFdKHR( device, &memory_info, &file_descriptor ) );
-    spdlog::debug( "vkGetMemoryFdKHR()" );
+    auto const pool_alloc_info = VkMemoryAllocateInfo{
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext           = &import_memory_info,
+        .allocationSize  = pool.allocation_size,
+        .memoryTypeIndex = pool.memory_type_index,
+    };
+    CHECK_VK( ::vkAllocateMemory( device, &pool_alloc_info, nullptr, &pool.memory ) );
+    spdlog::debug( "vkAllocateMemory() w/ import, {} pooled images", images.size( ) );
+
+    CHECK_TRUE( bind_pooled_images( pool, images, device ) );
 
     return true;
 }
 
+auto describe(
+    ExternalImageDescription&                  description,
+    ImageData< ExternalMemory::Export > const& image,
+    uint32 const                               slot,
+    uint64 const                               generation
+) -> void
+{
+    // Opaque fds have to be imported as the same memory type they were allocated with.
+    description = ExternalImageDescription{
+        .width               = image.image_size.width,
+        .height              = image.image_size.height,
+        .format              = static_cast< uint32 >( image.color_format ),
+        .tiling              = static_cast< uint32 >( image.image_tiling ),
+        .allocation_size     = image.memory_requirements.size,
+        .offset              = image.memory_offset,
+        .memory_type_bits    = 1U << image.memory_type_index,
+        .slot                = slot,
+        .generation          = generation,
+        .handle_type         = static_cast< uint32 >( image.external_handle ),
+        .plane_count         = static_cast< uint32 >( image.plane_layouts.size( ) ),
+        .drm_format_modifier = image.drm_format_modifier,
+        .planes              = { },
+    };
+    for ( auto plane = 0U; plane < description.plane_count; ++plane )
+    {
+        description.planes[ plane ] = ExternalPlaneLayout{
+            .offset    = image.plane_layouts[ plane ].offset,
+            .row_pitch = image.plane_layouts[ plane ].rowPitch,
+        };
+    }
+}
+
+auto describe(
+    ExternalImageDescription&                      description,
+    ImagePoolData< ExternalMemory::Export > const& pool,
+    ImageData< ExternalMemory::Export > const&     image,
+    uint32 const                                   slot,
+    uint64 const                                   generation
+) -> void
+{
+    describe( description, image, slot, generation );
+    description.allocation_size = pool.allocation_size;
+}
+
+auto get_file_descriptor(
+    int32&                                     file_descriptor,
+    VkInstance const&                          instance,
+    VkDevice const&                            device,
+    ImageData< ExternalMemory::Export > const& image
+) -> bool
+{
+    return get_memory_fd(
+        file_descriptor,
+        instance,
+        device,
+        image.color_image_memory,
+        image.external_handle
+    );
+}
+
+auto get_file_descriptor(
+    int32&                                         file_descriptor,
+    VkInstance const&                              instance,
+    VkDevice const&                                device,
+    ImagePoolData< ExternalMemory::Export > const& pool
+) -> bool
+{
+    return get_memory_fd( file_descriptor, instance, device, pool.memory, pool.external_handle );
+}
+
 template < ExternalMemory mem_type >
 auto destroy( ImageData< mem_type >& image, VkDevice const& device ) -> void
 {
@@ -256,7 +1073,7 @@ auto destroy( ImageData< mem_type >& image, VkDevice const& device ) -> void
         spdlog::debug( "vkDestroyImageView()" );
     }
 
-    if ( nullptr != image.color_image_memory )
+    if ( ( nullptr != image.color_image_memory ) && image.owns_memory )
     {
         ::vkFreeMemory( device, image.color_image_memory, nullptr );
         spdlog::debug( "vkFreeMemory()" );
@@ -267,10 +1084,31 @@ auto destroy( ImageData< mem_type >& image, VkDevice const& device ) -> void
         ::vkDestroyImage( device, image.color_image, nullptr );
         spdlog::debug( "vkDestroyImage()" );
     }
+
+    // Sub-allocated ranges are only handed back once nothing is bound to them.
+    if ( nullptr != image.allocator )
+    {
+        deallocate( image.allocation, *image.allocator, device );
+        image.allocator = nullptr;
+    }
 }
 
 template auto destroy( ImageData< ExternalMemory::None >&, VkDevice const& device ) -> void;
 template auto destroy( ImageData< ExternalMemory::Export >&, VkDevice const& device ) -> void;
 template auto destroy( ImageData< ExternalMemory::Import >&, VkDevice const& device ) -> void;
 
+template < ExternalMemory mem_type >
+auto destroy( ImagePoolData< mem_type >& pool, VkDevice const& device ) -> void
+{
+    if ( nullptr != pool.memory )
+    {
+        ::vkFreeMemory( device, pool.memory, nullptr );
+        spdlog::debug( "vkFreeMemory()" );
+        pool.memory = nullptr;
+    }
+}
+
+template auto destroy( ImagePoolData< ExternalMemory::Export >&, VkDevice const& device ) -> void;
+template auto destroy( ImagePoolData< ExternalMemory::Import >&, VkDevice const& device ) -> void;
+
 } // namespace ltb::vlk
@@ -0,0 +1,153 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/import_cache.hpp"
+
+// standard
+#include <algorithm>
+
+namespace ltb::vlk
+{
+
+auto acquire(
+    ImportCacheData&                                    cache,
+    uint32 const                                        producer_id,
+    uint64 const                                        generation,
+    uint32 const                                        slot_count,
+    std::vector< ImageData< ExternalMemory::Import > >& images
+) -> bool
+{
+    // A generation's images are inserted and destroyed together, so checking every slot
+    // only guards against a producer announcing more slots than it did before.
+    for ( auto slot = 0U; slot < slot_count; ++slot )
+    {
+        if ( !cache.images.contains( ImportKey{ producer_id, slot, generation } ) )
+        {
+            return false;
+        }
+    }
+
+    images.clear( );
+    for ( auto slot = 0U; slot < slot_count; ++slot )
+    {
+        auto& cached = cache.images.at( ImportKey{ producer_id, slot, generation } );
+        ++cached.user_count;
+        cached.evicted = false;
+        images.push_back( cached.image );
+    }
+    spdlog::debug( "Reusing {} cached images of producer {}", slot_count, producer_id );
+    return true;
+}
+
+auto insert(
+    ImportCacheData&                                    cache,
+    uint32 const                                        producer_id,
+    uint64 const                                        generation,
+    std::vector< ImageData< ExternalMemory::Import > >& images,
+    ImagePoolData< ExternalMemory::Import >&            pool
+) -> void
+{
+    for ( auto& [ key, cached ] : cache.images )
+    {
+        if ( ( producer_id == key.producer_id ) && ( generation != key.generation ) )
+        {
+            cached.evicted = true;
+        }
+    }
+
+    for ( auto slot = 0U; slot < images.size( ); ++slot )
+    {
+        cache.images[ ImportKey{ producer_id, slot, generation } ] = CachedImport{
+            .image      = images[ slot ],
+            .user_count = 1U,
+            .evicted    = false,
+        };
+    }
+
+    if ( nullptr != pool.memory )
+    {
+        cache.pools[ { producer_id, generation } ] = pool;
+        pool                                       = { };
+    }
+}
+
+auto release(
+    ImportCacheData& cache,
+    uint32 const     producer_id,
+    uint64 const     generation,
+    uint32 const     slot_count
+) -> void
+{
+    for ( auto slot = 0U; slot < slot_count; ++slot )
+    {
+        if ( auto const iter = cache.images.find( ImportKey{ producer_id, slot, generation } );
+             ( cache.images.end( ) != iter ) && ( iter->second.user_count > 0U ) )
+        {
+            // A layer that left the ring may never come back, so unused images don't linger.
+            if ( 0U == --iter->second.user_count )
+            {
+                iter->second.evicted = true;
+            }
+        }
+    }
+}
+
+auto destroy_evicted( ImportCacheData& cache, VkDevice const& device ) -> void
+{
+    for ( auto iter = cache.images.begin( ); cache.images.end( ) != iter; )
+    {
+        // Every image nobody uses is freed, whether it was evicted for a newer generation
+        // or its last ring was released.
+        if ( 0U == iter->second.user_count )
+        {
+            destroy( iter->second.image, device );
+            iter = cache.images.erase( iter );
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    // A pool is freed once every image bound into it is gone.
+    for ( auto iter = cache.pools.begin( ); cache.pools.end( ) != iter; )
+    {
+        auto const [ producer_id, generation ] = iter->first;
+
+        auto const has_images = std::ranges::any_of(
+            cache.images,
+            [ producer_id, generation ]( auto const& entry )
+            {
+                return ( producer_id == entry.first.producer_id )
+                    && ( generation == entry.first.generation );
+            }
+        );
+        if ( has_images )
+        {
+            ++iter;
+        }
+        else
+        {
+            destroy( iter->second, device );
+            iter = cache.pools.erase( iter );
+        }
+    }
+}
+
+auto destroy( ImportCacheData& cache, VkDevice const& device ) -> void
+{
+    // Pooled images share their pool's memory, so they go first.
+    for ( auto& [ key, cached ] : cache.images )
+    {
+        destroy( cached.image, device );
+    }
+    cache.images.clear( );
+
+    for ( auto& [ key, pool ] : cache.pools )
+    {
+        destroy( pool, device );
+    }
+    cache.pools.clear( );
+}
+
+} // namespace ltb::vlk
@@ -21,14 +21,19 @@ auto initialize_render_pass(
     VkDevice const& device
 )
 {
-    auto final_layout = VkImageLayout{ };
+    // Swapchain images keep their contents between frames, so renders can
+    // redraw only what changed. Headless images are always drawn in full.
+    auto initial_layout = VkImageLayout{ };
+    auto final_layout   = VkImageLayout{ };
     if constexpr ( app_type == AppType::Windowed )
     {
-        final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        initial_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        final_layout   = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     }
     else
     {
-        final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        initial_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        final_layout   = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     }
 
     auto const attachments = std::vector{
@@ -40,7 +45,7 @@ auto initialize_render_pass(
             .storeOp        = VK_ATTACHMENT_STORE_OP_STORE,
             .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
             .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+            .initialLayout  = initial_layout,
             .finalLayout    = final_layout,
         },
     };
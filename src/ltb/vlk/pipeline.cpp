@@ -4,106 +4,368 @@
 #include "ltb/vlk/pipeline.hpp"
 
 // project
-#include "ltb/ltb_config.hpp"
-#include "ltb/utils/read_file.hpp"
 #include "ltb/vlk/check.hpp"
+#include "ltb/vlk/spirv.hpp"
+
+// standard
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <thread>
 
 namespace ltb::vlk
 {
+namespace
+{
+
+using ShaderStages = std::array< VkPipelineShaderStageCreateInfo, 2 >;
+
+// The values of the composite fragment shader's specialization constants.
+struct CompositeConstants
+{
+    uint32 blend = 0U; // constant_id = 0
+    uint32 color = 0U; // constant_id = 1
+};
+
+auto constexpr composite_constant_entries = std::array{
+    VkSpecializationMapEntry{
+        .constantID = 0U,
+        .offset     = offsetof( CompositeConstants, blend ),
+        .size       = sizeof( uint32 ),
+    },
+    VkSpecializationMapEntry{
+        .constantID = 1U,
+        .offset     = offsetof( CompositeConstants, color ),
+        .size       = sizeof( uint32 ),
+    },
+};
+
+// Everything a pipeline's create infos point into. The create infos point into the build
+// itself, so it's never moved or copied once it's prepared.
+struct PipelineBuild
+{
+    VkShaderModule vert_shader_module = { };
+    VkShaderModule frag_shader_module = { };
+
+    VkPipelineVertexInputStateCreateInfo   vertex_input_info = { };
+    VkPipelineInputAssemblyStateCreateInfo input_assembly    = { };
+    VkPipelineViewportStateCreateInfo      viewport_state    = { };
+    VkPipelineRasterizationStateCreateInfo rasterizer        = { };
+    VkPipelineMultisampleStateCreateInfo   multisampling     = { };
+    std::array< VkDynamicState, 2 >        dynamic_states    = { };
+    VkPipelineDynamicStateCreateInfo       dynamic_state     = { };
+
+    // One of each per variant.
+    std::vector< CompositeConstants >                  constants            = { };
+    std::vector< VkSpecializationInfo >                specialization_infos = { };
+    std::vector< ShaderStages >                        shader_stages        = { };
+    std::vector< VkPipelineColorBlendAttachmentState > blend_attachments    = { };
+    std::vector< VkPipelineColorBlendStateCreateInfo > color_blendings      = { };
+    std::vector< VkGraphicsPipelineCreateInfo >        create_infos         = { };
+};
+
+auto get_variant( uint32 const variant_index ) -> CompositeVariant
+{
+    return CompositeVariant{
+        .blend = static_cast< CompositeBlend >( variant_index / composite_color_count ),
+        .color = static_cast< CompositeColor >( variant_index % composite_color_count ),
+    };
+}
+
+// Blended layers scale the layers drawn before them by what their alpha leaves. Straight
+// colors are scaled by their own alpha as well, premultiplied colors already are.
+auto get_color_blend_attachment( CompositeBlend const blend ) -> VkPipelineColorBlendAttachmentState
+{
+    auto const blends_layers = ( CompositeBlend::Opaque != blend );
+    auto const src_factor    = ( CompositeBlend::Straight == blend ) ? VK_BLEND_FACTOR_SRC_ALPHA
+                                                                      : VK_BLEND_FACTOR_ONE;
+    auto const dst_factor
+        = blends_layers ? VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA : VK_BLEND_FACTOR_ZERO;
+
+    return VkPipelineColorBlendAttachmentState{
+        .blendEnable         = blends_layers ? VK_TRUE : VK_FALSE,
+        .srcColorBlendFactor = src_factor,
+        .dstColorBlendFactor = dst_factor,
+        .colorBlendOp        = VK_BLEND_OP_ADD,
+        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = dst_factor,
+        .alphaBlendOp        = VK_BLEND_OP_ADD,
+        .colorWriteMask      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
+                        | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+}
+
+// Creates the buffer a triangle's uniforms are copied to, with one aligned range per
+// frame in flight, and points each frame's descriptor set at its range.
+auto initialize_uniform_buffer(
+    PipelineData< Pipeline::Triangle >& pipeline,
+    AllocatorData&                      allocator,
+    VkDevice const&                     device
+) -> bool
+{
+    auto properties = VkPhysicalDeviceProperties{ };
+    ::vkGetPhysicalDeviceProperties( allocator.physical_device, &properties );
+
+    auto const alignment
+        = std::max( properties.limits.minUniformBufferOffsetAlignment, VkDeviceSize{ 1U } );
+    pipeline.uniform_stride
+        = ( ( sizeof( TriangleUniforms ) + alignment - 1U ) / alignment ) * alignment;
+
+    auto const buffer_create_info = VkBufferCreateInfo{
+        .sType                 = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext                 = nullptr,
+        .flags                 = 0U,
+        .size                  = pipeline.uniform_stride * pipeline.max_frames_in_flight,
+        .usage                 = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        .sharingMode           = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0U,
+        .pQueueFamilyIndices   = nullptr,
+    };
+    CHECK_VK( ::vkCreateBuffer( device, &buffer_create_info, nullptr, &pipeline.uniform_buffer ) );
+    spdlog::debug( "vkCreateBuffer()" );
+
+    auto memory_requirements = VkMemoryRequirements{ };
+    ::vkGetBufferMemoryRequirements( device, pipeline.uniform_buffer, &memory_requirements );
+
+    auto constexpr linear = true;
+    CHECK_TRUE( allocate(
+        pipeline.uniform_allocation,
+        allocator,
+        device,
+        memory_requirements,
+        MemoryUsage::HostUpload,
+        linear
+    ) );
+    pipeline.allocator = &allocator;
+
+    CHECK_VK( ::vkBindBufferMemory(
+        device,
+        pipeline.uniform_buffer,
+        pipeline.uniform_allocation.memory,
+        pipeline.uniform_allocation.offset
+    ) );
+
+    auto buffer_infos = std::vector< VkDescriptorBufferInfo >{ };
+    auto writes       = std::vector< VkWriteDescriptorSet >{ };
+    buffer_infos.reserve( pipeline.max_frames_in_flight );
+
+    for ( auto frame_index = 0U; frame_index < pipeline.max_frames_in_flight; ++frame_index )
+    {
+        buffer_infos.push_back( VkDescriptorBufferInfo{
+            .buffer = pipeline.uniform_buffer,
+            .offset = frame_index * pipeline.uniform_stride,
+            .range  = sizeof( TriangleUniforms ),
+        } );
+        writes.push_back( VkWriteDescriptorSet{
+            .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext            = nullptr,
+            .dstSet           = pipeline.descriptor_sets[ frame_index ],
+            .dstBinding       = 0U,
+            .dstArrayElement  = 0U,
+            .descriptorCount  = 1U,
+            .descriptorType   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .pImageInfo       = nullptr,
+            .pBufferInfo      = &buffer_infos.back( ),
+            .pTexelBufferView = nullptr,
+        } );
+    }
+
+    auto constexpr copy_count = 0U;
+    auto constexpr copies     = nullptr;
+    ::vkUpdateDescriptorSets(
+        device,
+        static_cast< uint32 >( writes.size( ) ),
+        writes.data( ),
+        copy_count,
+        copies
+    );
+
+    // Frames rendered before their first update still draw the default uniforms.
+    for ( auto frame_index = 0U; frame_index < pipeline.max_frames_in_flight; ++frame_index )
+    {
+        update_uniforms( pipeline, frame_index );
+    }
+
+    return true;
+}
+
+// Pipelines compile independently, so they're split into one batch per core. The
+// calling thread compiles the first batch, and every thread shares the pipeline
+// cache, which the driver synchronizes internally.
+auto create_pipelines(
+    std::vector< VkPipeline >&                         pipelines,
+    VkDevice const&                                    device,
+    VkPipelineCache const&                             pipeline_cache,
+    std::vector< VkGraphicsPipelineCreateInfo > const& create_infos
+) -> bool
+{
+    auto const pipeline_count = static_cast< uint32 >( create_infos.size( ) );
+    auto const thread_count
+        = std::clamp( std::thread::hardware_concurrency( ), 1U, std::max( pipeline_count, 1U ) );
+
+    pipelines.assign( pipeline_count, nullptr );
+    auto results = std::vector< VkResult >( thread_count, VK_SUCCESS );
+
+    auto const create_batch = [ & ]( uint32 const batch_index )
+    {
+        auto const first = ( pipeline_count * batch_index ) / thread_count;
+        auto const last  = ( pipeline_count * ( batch_index + 1U ) ) / thread_count;
 
+        results[ batch_index ] = ::vkCreateGraphicsPipelines(
+            device,
+            pipeline_cache,
+            last - first,
+            create_infos.data( ) + first,
+            nullptr,
+            pipelines.data( ) + first
+        );
+    };
+
+    {
+        auto workers = std::vector< std::jthread >{ };
+        workers.reserve( thread_count - 1U );
+        for ( auto batch_index = 1U; batch_index < thread_count; ++batch_index )
+        {
+            workers.emplace_back( create_batch, batch_index );
+        }
+        create_batch( 0U );
+    }
+
+    // Failed batches leave their pipelines null, so only the ones that compiled are destroyed.
+    if ( auto const failed = std::ranges::find_if(
+             results,
+             []( auto const result ) { return VK_SUCCESS != result; }
+         );
+         results.end( ) != failed )
+    {
+        spdlog::error( "vkCreateGraphicsPipelines() failed: {}", std::to_string( *failed ) );
+        for ( auto* const created_pipeline : pipelines )
+        {
+            if ( nullptr != created_pipeline )
+            {
+                ::vkDestroyPipeline( device, created_pipeline, nullptr );
+            }
+        }
+        pipelines.clear( );
+        return false;
+    }
+    spdlog::debug( "vkCreateGraphicsPipelines() x{} on {} threads", pipeline_count, thread_count );
+
+    return true;
+}
+
+// Creates everything a pipeline uses except the compiled pipelines themselves, and fills
+// the build with the create infos that compile them.
 template < Pipeline pipeline_type >
-auto initialize(
+auto prepare(
     PipelineData< pipeline_type >& pipeline,
+    PipelineBuild&                 build,
+    AllocatorData&                 allocator,
     VkDevice const&                device,
     VkRenderPass const&            render_pass,
     uint32 const                   max_frames_in_flight
 ) -> bool
 {
-    auto descriptor_set_layouts = std::vector< VkDescriptorSetLayout >{ };
-    auto push_constant_ranges   = std::vector< VkPushConstantRange >{ };
+    auto descriptor_type      = VkDescriptorType{ };
+    auto descriptor_stages    = VkShaderStageFlags{ };
+    auto descriptor_set_count = max_frames_in_flight;
+    auto push_constant_ranges = std::vector< VkPushConstantRange >{ };
 
     if constexpr ( pipeline_type == Pipeline::Triangle )
     {
+        // Each frame in flight reads its uniforms from its own range of one buffer.
+        descriptor_type   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptor_stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    else
+    {
+        // Each layer is drawn with its own set so any number of
+        // layers up to the max can be drawn in one render pass.
+        descriptor_type      = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptor_stages    = VK_SHADER_STAGE_FRAGMENT_BIT;
+        descriptor_set_count = max_frames_in_flight * max_composite_layers;
+
+        // The layer's placement is used to position the quad and its opacity to blend it.
         push_constant_ranges = {
             {
-                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 .offset     = 0,
-                .size       = sizeof( pipeline.model_uniforms ),
-            },
-            {
-                .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-                .offset     = sizeof( pipeline.model_uniforms ),
-                .size       = sizeof( pipeline.display_uniforms ),
+                .size       = sizeof( LayerUniforms ),
             },
         };
     }
-    else
-    {
-        auto const descriptor_pool_sizes = std::array{
-            VkDescriptorPoolSize{
-                .type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount = max_frames_in_flight,
-            },
-        };
-        auto const descriptor_pool_create_info = VkDescriptorPoolCreateInfo{
-            .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-            .pNext         = nullptr,
-            .flags         = 0U,
-            .maxSets       = max_frames_in_flight,
-            .poolSizeCount = static_cast< uint32 >( descriptor_pool_sizes.size( ) ),
-            .pPoolSizes    = descriptor_pool_sizes.data( ),
-        };
-        CHECK_VK( ::vkCreateDescriptorPool(
-            device,
-            &descriptor_pool_create_info,
-            nullptr,
-            &pipeline.descriptor_pool
-        ) );
-        spdlog::debug( "vkCreateDescriptorPool()" );
-
-        auto const descriptor_set_layout_bindings = std::array{
-            VkDescriptorSetLayoutBinding{
-                .binding            = 0U,
-                .descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .descriptorCount    = 1U,
-                .stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT,
-                .pImmutableSamplers = nullptr,
-            },
-        };
-        auto const descriptor_set_layout_info = VkDescriptorSetLayoutCreateInfo{
-            .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .pNext        = nullptr,
-            .flags        = 0U,
-            .bindingCount = static_cast< uint32 >( descriptor_set_layout_bindings.size( ) ),
-            .pBindings    = descriptor_set_layout_bindings.data( ),
-        };
-        CHECK_VK( ::vkCreateDescriptorSetLayout(
-            device,
-            &descriptor_set_layout_info,
-            nullptr,
-            &pipeline.descriptor_set_layout
-        ) );
-
-        auto const layouts = std::vector<
-            VkDescriptorSetLayout >( max_frames_in_flight, pipeline.descriptor_set_layout );
-        auto const descriptor_set_allocate_info = VkDescriptorSetAllocateInfo{
-            .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-            .pNext              = nullptr,
-            .descriptorPool     = pipeline.descriptor_pool,
-            .descriptorSetCount = max_frames_in_flight,
-            .pSetLayouts        = layouts.data( ),
-        };
 
-        pipeline.descriptor_sets.resize( max_frames_in_flight );
-        CHECK_VK( ::vkAllocateDescriptorSets(
-            device,
-            &descriptor_set_allocate_info,
-            pipeline.descriptor_sets.data( )
-        ) );
+    auto const descriptor_pool_sizes = std::array{
+        VkDescriptorPoolSize{
+            .type            = descriptor_type,
+            .descriptorCount = descriptor_set_count,
+        },
+    };
+    auto const descriptor_pool_create_info = VkDescriptorPoolCreateInfo{
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext         = nullptr,
+        .flags         = 0U,
+        .maxSets       = descriptor_set_count,
+        .poolSizeCount = static_cast< uint32 >( descriptor_pool_sizes.size( ) ),
+        .pPoolSizes    = descriptor_pool_sizes.data( ),
+    };
+    CHECK_VK( ::vkCreateDescriptorPool(
+        device,
+        &descriptor_pool_create_info,
+        nullptr,
+        &pipeline.descriptor_pool
+    ) );
+    spdlog::debug( "vkCreateDescriptorPool()" );
+
+    auto const descriptor_set_layout_bindings = std::array{
+        VkDescriptorSetLayoutBinding{
+            .binding            = 0U,
+            .descriptorType     = descriptor_type,
+            .descriptorCount    = 1U,
+            .stageFlags         = descriptor_stages,
+            .pImmutableSamplers = nullptr,
+        },
+    };
+    auto const descriptor_set_layout_info = VkDescriptorSetLayoutCreateInfo{
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext        = nullptr,
+        .flags        = 0U,
+        .bindingCount = static_cast< uint32 >( descriptor_set_layout_bindings.size( ) ),
+        .pBindings    = descriptor_set_layout_bindings.data( ),
+    };
+    CHECK_VK( ::vkCreateDescriptorSetLayout(
+        device,
+        &descriptor_set_layout_info,
+        nullptr,
+        &pipeline.descriptor_set_layout
+    ) );
+
+    auto const layouts = std::vector<
+        VkDescriptorSetLayout >( descriptor_set_count, pipeline.descriptor_set_layout );
+    auto const descriptor_set_allocate_info = VkDescriptorSetAllocateInfo{
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext              = nullptr,
+        .descriptorPool     = pipeline.descriptor_pool,
+        .descriptorSetCount = descriptor_set_count,
+        .pSetLayouts        = layouts.data( ),
+    };
 
-        descriptor_set_layouts = { pipeline.descriptor_set_layout };
+    pipeline.descriptor_sets.resize( descriptor_set_count );
+    CHECK_VK( ::vkAllocateDescriptorSets(
+        device,
+        &descriptor_set_allocate_info,
+        pipeline.descriptor_sets.data( )
+    ) );
+    pipeline.max_frames_in_flight = max_frames_in_flight;
+
+    if constexpr ( pipeline_type == Pipeline::Triangle )
+    {
+        CHECK_TRUE( initialize_uniform_buffer( pipeline, allocator, device ) );
     }
 
+    auto const descriptor_set_layouts = std::array{ pipeline.descriptor_set_layout };
+
     auto const pipeline_layout_info = VkPipelineLayoutCreateInfo{
         .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext                  = nullptr,
@@ -121,83 +383,60 @@ auto initialize(
     ) );
     spdlog::debug( "vkCreatePipelineLayout()" );
 
-    auto vert_shader_path = config::spirv_shader_dir_path( );
-    auto frag_shader_path = config::spirv_shader_dir_path( );
+    auto vert_shader_name = std::string_view{ };
+    auto frag_shader_name = std::string_view{ };
     auto topology         = VkPrimitiveTopology{ };
 
     if constexpr ( pipeline_type == Pipeline::Triangle )
     {
-        vert_shader_path = vert_shader_path / "triangle.vert.spv";
-        frag_shader_path = frag_shader_path / "triangle.frag.spv";
+        vert_shader_name = "triangle.vert";
+        frag_shader_name = "triangle.frag";
         topology         = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     }
     else
     {
-        vert_shader_path = vert_shader_path / "composite.vert.spv";
-        frag_shader_path = frag_shader_path / "composite.frag.spv";
+        vert_shader_name = "composite.vert";
+        frag_shader_name = "composite.frag";
         topology         = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
     }
 
-    auto vert_shader_code = std::vector< uint32_t >{ };
-    auto frag_shader_code = std::vector< uint32_t >{ };
-    if ( ( !utils::get_binary_file_contents( vert_shader_path, vert_shader_code ) )
-         || ( !utils::get_binary_file_contents( frag_shader_path, frag_shader_code ) ) )
-    {
-        return false;
-    }
+    // The code is only copied when shaders are overridden from disk.
+    auto vert_shader_code = std::span< uint32 const >{ };
+    auto frag_shader_code = std::span< uint32 const >{ };
+    auto vert_override    = std::vector< uint32 >{ };
+    auto frag_override    = std::vector< uint32 >{ };
+    CHECK_TRUE( get_spirv( vert_shader_code, vert_override, vert_shader_name ) );
+    CHECK_TRUE( get_spirv( frag_shader_code, frag_override, frag_shader_name ) );
 
     auto const vert_shader_module_create_info = VkShaderModuleCreateInfo{
         .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .pNext    = nullptr,
         .flags    = 0U,
-        .codeSize = vert_shader_code.size( ) * sizeof( uint32_t ),
+        .codeSize = vert_shader_code.size_bytes( ),
         .pCode    = vert_shader_code.data( ),
     };
-    auto* vert_shader_module = VkShaderModule{ };
     CHECK_VK( ::vkCreateShaderModule(
         device,
         &vert_shader_module_create_info,
         nullptr,
-        &vert_shader_module
+        &build.vert_shader_module
     ) );
 
     auto const frag_shader_module_create_info = VkShaderModuleCreateInfo{
         .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
         .pNext    = nullptr,
         .flags    = 0U,
-        .codeSize = frag_shader_code.size( ) * sizeof( uint32_t ),
+        .codeSize = frag_shader_code.size_bytes( ),
         .pCode    = frag_shader_code.data( ),
     };
-    auto* frag_shader_module = VkShaderModule{ };
     CHECK_VK( ::vkCreateShaderModule(
         device,
         &frag_shader_module_create_info,
         nullptr,
-        &frag_shader_module
+        &build.frag_shader_module
     ) );
 
-    auto const shader_stages = std::vector{
-        VkPipelineShaderStageCreateInfo{
-            .sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .pNext               = nullptr,
-            .flags               = 0U,
-            .stage               = VK_SHADER_STAGE_VERTEX_BIT,
-            .module              = vert_shader_module,
-            .pName               = "main",
-            .pSpecializationInfo = nullptr,
-        },
-        VkPipelineShaderStageCreateInfo{
-            .sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .pNext               = nullptr,
-            .flags               = 0U,
-            .stage               = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module              = frag_shader_module,
-            .pName               = "main",
-            .pSpecializationInfo = nullptr,
-        },
-    };
-
-    auto const vertex_input_info = VkPipelineVertexInputStateCreateInfo{
+    build.vertex_input_info = VkPipelineVertexInputStateCreateInfo{
         .sType                         = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
         .pNext                         = nullptr,
         .flags                         = 0U,
@@ -207,7 +446,7 @@ auto initialize(
         .pVertexAttributeDescriptions    = nullptr,
     };
 
-    auto const input_assembly = VkPipelineInputAssemblyStateCreateInfo{
+    build.input_assembly = VkPipelineInputAssemblyStateCreateInfo{
         .sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
         .pNext                  = nullptr,
         .flags                  = 0U,
@@ -215,7 +454,7 @@ auto initialize(
         .primitiveRestartEnable = VK_FALSE,
     };
 
-    auto const viewport_state = VkPipelineViewportStateCreateInfo{
+    build.viewport_state = VkPipelineViewportStateCreateInfo{
         .sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .pNext         = nullptr,
         .flags         = 0U,
@@ -225,7 +464,7 @@ auto initialize(
         .pScissors     = nullptr,
     };
 
-    auto const rasterizer = VkPipelineRasterizationStateCreateInfo{
+    build.rasterizer = VkPipelineRasterizationStateCreateInfo{
         .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
         .pNext                   = nullptr,
         .flags                   = 0U,
@@ -241,7 +480,7 @@ auto initialize(
         .lineWidth               = 1.0F,
     };
 
-    auto const multisampling = VkPipelineMultisampleStateCreateInfo{
+    build.multisampling = VkPipelineMultisampleStateCreateInfo{
         .sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
         .pNext                 = nullptr,
         .flags                 = 0,
@@ -253,96 +492,309 @@ auto initialize(
         .alphaToOneEnable      = VK_FALSE,
     };
 
-    auto const color_blend_attachment = VkPipelineColorBlendAttachmentState{
-        .blendEnable         = VK_FALSE,
-        .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstColorBlendFactor = VK_BLEND_FACTOR_ZERO,
-        .colorBlendOp        = VK_BLEND_OP_ADD,
-        .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-        .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-        .alphaBlendOp        = VK_BLEND_OP_ADD,
-        .colorWriteMask      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
-                        | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-    };
-
-    auto const color_blending = VkPipelineColorBlendStateCreateInfo{
-        .sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .pNext           = nullptr,
-        .flags           = 0U,
-        .logicOpEnable   = VK_FALSE,
-        .logicOp         = VK_LOGIC_OP_COPY,
-        .attachmentCount = 1U,
-        .pAttachments    = &color_blend_attachment,
-        .blendConstants  = { 0.0F, 0.0F, 0.0F, 0.0F },
-    };
-
-    auto const dynamic_states = std::array{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    auto const dynamic_state  = VkPipelineDynamicStateCreateInfo{
+    build.dynamic_states = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    build.dynamic_state  = VkPipelineDynamicStateCreateInfo{
          .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
          .pNext             = nullptr,
          .flags             = 0,
-         .dynamicStateCount = static_cast< uint32 >( dynamic_states.size( ) ),
-         .pDynamicStates    = dynamic_states.data( ),
+         .dynamicStateCount = static_cast< uint32 >( build.dynamic_states.size( ) ),
+         .pDynamicStates    = build.dynamic_states.data( ),
     };
 
-    auto const pipeline_create_info = VkGraphicsPipelineCreateInfo{
-        .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .pNext               = nullptr,
-        .flags               = 0,
-        .stageCount          = static_cast< uint32 >( shader_stages.size( ) ),
-        .pStages             = shader_stages.data( ),
-        .pVertexInputState   = &vertex_input_info,
-        .pInputAssemblyState = &input_assembly,
-        .pTessellationState  = nullptr,
-        .pViewportState      = &viewport_state,
-        .pRasterizationState = &rasterizer,
-        .pMultisampleState   = &multisampling,
-        .pDepthStencilState  = nullptr,
-        .pColorBlendState    = &color_blending,
-        .pDynamicState       = &dynamic_state,
-        .layout              = pipeline.pipeline_layout,
-        .renderPass          = render_pass,
-        .subpass             = 0U,
-        .basePipelineHandle  = nullptr,
-        .basePipelineIndex   = -1,
-    };
-    CHECK_VK( ::vkCreateGraphicsPipelines(
-        device,
-        nullptr,
-        1,
-        &pipeline_create_info,
-        nullptr,
-        &pipeline.pipeline
-    ) );
-    spdlog::debug( "vkCreateGraphicsPipelines()" );
+    // Triangles need a single pipeline. Composited layers get one per variant, all
+    // built from the same shader modules and compiled in parallel.
+    auto variant_count = 1U;
+    if constexpr ( pipeline_type == Pipeline::Composite )
+    {
+        variant_count = composite_variant_count;
+    }
+
+    // Every create info points into these, so they're sized up front and never resized.
+    build.constants.resize( variant_count );
+    build.specialization_infos.resize( variant_count );
+    build.shader_stages.resize( variant_count );
+    build.blend_attachments.resize( variant_count );
+    build.color_blendings.resize( variant_count );
+    build.create_infos.resize( variant_count );
+
+    for ( auto variant_index = 0U; variant_index < variant_count; ++variant_index )
+    {
+        // Triangles are drawn as they are, like opaque layers.
+        auto const variant = ( pipeline_type == Pipeline::Composite )
+                               ? get_variant( variant_index )
+                               : CompositeVariant{ .blend = CompositeBlend::Opaque };
+
+        build.constants[ variant_index ] = CompositeConstants{
+            .blend = static_cast< uint32 >( variant.blend ),
+            .color = static_cast< uint32 >( variant.color ),
+        };
+        build.specialization_infos[ variant_index ] = VkSpecializationInfo{
+            .mapEntryCount = static_cast< uint32 >( composite_constant_entries.size( ) ),
+            .pMapEntries   = composite_constant_entries.data( ),
+            .dataSize      = sizeof( CompositeConstants ),
+            .pData         = &build.constants[ variant_index ],
+        };
+
+        auto const* specialization_info = ( pipeline_type == Pipeline::Composite )
+                                            ? &build.specialization_infos[ variant_index ]
+                                            : nullptr;
+
+        build.shader_stages[ variant_index ] = ShaderStages{
+            VkPipelineShaderStageCreateInfo{
+                .sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext               = nullptr,
+                .flags               = 0U,
+                .stage               = VK_SHADER_STAGE_VERTEX_BIT,
+                .module              = build.vert_shader_module,
+                .pName               = "main",
+                .pSpecializationInfo = nullptr,
+            },
+            VkPipelineShaderStageCreateInfo{
+                .sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext               = nullptr,
+                .flags               = 0U,
+                .stage               = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .module              = build.frag_shader_module,
+                .pName               = "main",
+                .pSpecializationInfo = specialization_info,
+            },
+        };
+
+        build.blend_attachments[ variant_index ] = get_color_blend_attachment( variant.blend );
+
+        build.color_blendings[ variant_index ] = VkPipelineColorBlendStateCreateInfo{
+            .sType           = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .pNext           = nullptr,
+            .flags           = 0U,
+            .logicOpEnable   = VK_FALSE,
+            .logicOp         = VK_LOGIC_OP_COPY,
+            .attachmentCount = 1U,
+            .pAttachments    = &build.blend_attachments[ variant_index ],
+            .blendConstants  = { 0.0F, 0.0F, 0.0F, 0.0F },
+        };
 
-    ::vkDestroyShaderModule( device, frag_shader_module, nullptr );
-    ::vkDestroyShaderModule( device, vert_shader_module, nullptr );
+        auto const& stages = build.shader_stages[ variant_index ];
+
+        build.create_infos[ variant_index ] = VkGraphicsPipelineCreateInfo{
+            .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+            .pNext               = nullptr,
+            .flags               = 0,
+            .stageCount          = static_cast< uint32 >( stages.size( ) ),
+            .pStages             = stages.data( ),
+            .pVertexInputState   = &build.vertex_input_info,
+            .pInputAssemblyState = &build.input_assembly,
+            .pTessellationState  = nullptr,
+            .pViewportState      = &build.viewport_state,
+            .pRasterizationState = &build.rasterizer,
+            .pMultisampleState   = &build.multisampling,
+            .pDepthStencilState  = nullptr,
+            .pColorBlendState    = &build.color_blendings[ variant_index ],
+            .pDynamicState       = &build.dynamic_state,
+            .layout              = pipeline.pipeline_layout,
+            .renderPass          = render_pass,
+            .subpass             = 0U,
+            .basePipelineHandle  = nullptr,
+            .basePipelineIndex   = -1,
+        };
+    }
 
     return true;
 }
 
+auto destroy_shader_modules( PipelineBuild& build, VkDevice const& device ) -> void
+{
+    // Every variant shares the same modules, which are only needed until they're compiled.
+    if ( nullptr != build.frag_shader_module )
+    {
+        ::vkDestroyShaderModule( device, build.frag_shader_module, nullptr );
+        build.frag_shader_module = nullptr;
+    }
+    if ( nullptr != build.vert_shader_module )
+    {
+        ::vkDestroyShaderModule( device, build.vert_shader_module, nullptr );
+        build.vert_shader_module = nullptr;
+    }
+}
+
+template < Pipeline pipeline_type >
+auto set_pipelines(
+    PipelineData< pipeline_type >&      pipeline,
+    std::span< VkPipeline const > const pipelines
+) -> void
+{
+    if constexpr ( pipeline_type == Pipeline::Triangle )
+    {
+        pipeline.pipeline = pipelines.front( );
+    }
+    else
+    {
+        std::ranges::copy( pipelines, pipeline.pipelines.begin( ) );
+    }
+}
+
+} // namespace
+
+template < Pipeline pipeline_type >
+auto initialize(
+    PipelineData< pipeline_type >& pipeline,
+    AllocatorData&                 allocator,
+    VkDevice const&                device,
+    VkPipelineCache const&         pipeline_cache,
+    VkRenderPass const&            render_pass,
+    uint32 const                   max_frames_in_flight
+) -> bool
+{
+    auto       build    = PipelineBuild{ };
+    auto const prepared
+        = prepare( pipeline, build, allocator, device, render_pass, max_frames_in_flight );
+
+    auto       pipelines = std::vector< VkPipeline >{ };
+    auto const created
+        = prepared && create_pipelines( pipelines, device, pipeline_cache, build.create_infos );
+    destroy_shader_modules( build, device );
+    CHECK_TRUE( created );
+
+    set_pipelines( pipeline, pipelines );
+    return true;
+}
+
 template auto initialize(
     PipelineData< Pipeline::Triangle >&,
+    AllocatorData&,
     VkDevice const&,
+    VkPipelineCache const&,
     VkRenderPass const&,
     uint32 const
 ) -> bool;
 
 template auto initialize(
     PipelineData< Pipeline::Composite >&,
+    AllocatorData&,
     VkDevice const&,
+    VkPipelineCache const&,
     VkRenderPass const&,
     uint32 const
 ) -> bool;
 
+auto initialize(
+    PipelineData< Pipeline::Triangle >&  triangle_pipeline,
+    PipelineData< Pipeline::Composite >& composite_pipeline,
+    AllocatorData&                       allocator,
+    VkDevice const&                      device,
+    VkPipelineCache const&               pipeline_cache,
+    VkRenderPass const&                  triangle_render_pass,
+    uint32 const                         triangle_frames_in_flight,
+    VkRenderPass const&                  composite_render_pass,
+    uint32 const                         composite_frames_in_flight
+) -> bool
+{
+    auto triangle_build  = PipelineBuild{ };
+    auto composite_build = PipelineBuild{ };
+
+    auto prepared = prepare(
+        triangle_pipeline,
+        triangle_build,
+        allocator,
+        device,
+        triangle_render_pass,
+        triangle_frames_in_flight
+    );
+    if ( prepared )
+    {
+        prepared = prepare(
+            composite_pipeline,
+            composite_build,
+            allocator,
+            device,
+            composite_render_pass,
+            composite_frames_in_flight
+        );
+    }
+
+    // Both pipelines' create infos go in one batch, so they're spread over every core together.
+    auto create_infos = triangle_build.create_infos;
+    create_infos.insert(
+        create_infos.end( ),
+        composite_build.create_infos.begin( ),
+        composite_build.create_infos.end( )
+    );
+
+    auto       pipelines = std::vector< VkPipeline >{ };
+    auto const created
+        = prepared && create_pipelines( pipelines, device, pipeline_cache, create_infos );
+    destroy_shader_modules( triangle_build, device );
+    destroy_shader_modules( composite_build, device );
+    CHECK_TRUE( created );
+
+    auto const triangle_count = triangle_build.create_infos.size( );
+    set_pipelines( triangle_pipeline, std::span{ pipelines }.first( triangle_count ) );
+    set_pipelines( composite_pipeline, std::span{ pipelines }.subspan( triangle_count ) );
+    return true;
+}
+
+auto get_descriptor_set(
+    PipelineData< Pipeline::Triangle > const& pipeline,
+    uint32 const                              frame_index
+) -> VkDescriptorSet const&
+{
+    return pipeline.descriptor_sets[ frame_index ];
+}
+
+auto update_uniforms(
+    PipelineData< Pipeline::Triangle > const& pipeline,
+    uint32 const                              frame_index
+) -> void
+{
+    auto const uniforms = TriangleUniforms{
+        .model   = pipeline.model_uniforms,
+        .display = pipeline.display_uniforms,
+    };
+
+    // The memory is coherent, so the copy is visible to the next submit without a flush.
+    auto* const frame_uniforms = static_cast< std::byte* >( pipeline.uniform_allocation.mapped )
+                               + ( frame_index * pipeline.uniform_stride );
+    std::memcpy( frame_uniforms, &uniforms, sizeof( uniforms ) );
+}
+
+auto get_descriptor_set(
+    PipelineData< Pipeline::Composite > const& pipeline,
+    uint32 const                               frame_index,
+    uint32 const                               layer_index
+) -> VkDescriptorSet const&
+{
+    auto const set_index = ( layer_index * pipeline.max_frames_in_flight ) + frame_index;
+    return pipeline.descriptor_sets[ set_index ];
+}
+
+auto get_pipeline(
+    PipelineData< Pipeline::Composite > const& pipeline,
+    CompositeVariant const                     variant
+) -> VkPipeline const&
+{
+    return pipeline.pipelines[ get_variant_index( variant ) ];
+}
+
 template < Pipeline pipeline_type >
 auto destroy( PipelineData< pipeline_type >& pipeline, VkDevice const& device ) -> void
 {
-    if ( nullptr != pipeline.pipeline )
+    if constexpr ( Pipeline::Triangle == pipeline_type )
     {
-        ::vkDestroyPipeline( device, pipeline.pipeline, nullptr );
-        spdlog::debug( "vkDestroyPipeline()" );
+        if ( nullptr != pipeline.pipeline )
+        {
+            ::vkDestroyPipeline( device, pipeline.pipeline, nullptr );
+            spdlog::debug( "vkDestroyPipeline()" );
+        }
+    }
+    else
+    {
+        for ( auto* const variant_pipeline : pipeline.pipelines )
+        {
+            if ( nullptr != variant_pipeline )
+            {
+                ::vkDestroyPipeline( device, variant_pipeline, nullptr );
+                spdlog::debug( "vkDestroyPipeline()" );
+            }
+        }
     }
 
     if ( nullptr != pipeline.pipeline_layout )
@@ -351,18 +803,29 @@ auto destroy( PipelineData< pipeline_type >& pipeline, VkDevice const& device )
         spdlog::debug( "vkDestroyPipelineLayout()" );
     }
 
-    if constexpr ( Pipeline::Composite == pipeline_type )
+    if ( nullptr != pipeline.descriptor_set_layout )
+    {
+        ::vkDestroyDescriptorSetLayout( device, pipeline.descriptor_set_layout, nullptr );
+        spdlog::debug( "vkDestroyDescriptorSetLayout()" );
+    }
+
+    if ( nullptr != pipeline.descriptor_pool )
+    {
+        ::vkDestroyDescriptorPool( device, pipeline.descriptor_pool, nullptr );
+        spdlog::debug( "vkDestroyDescriptorPool()" );
+    }
+
+    if constexpr ( Pipeline::Triangle == pipeline_type )
     {
-        if ( nullptr != pipeline.descriptor_set_layout )
+        if ( nullptr != pipeline.uniform_buffer )
         {
-            ::vkDestroyDescriptorSetLayout( device, pipeline.descriptor_set_layout, nullptr );
-            spdlog::debug( "vkDestroyDescriptorSetLayout()" );
+            ::vkDestroyBuffer( device, pipeline.uniform_buffer, nullptr );
+            spdlog::debug( "vkDestroyBuffer()" );
         }
 
-        if ( nullptr != pipeline.descriptor_pool )
+        if ( nullptr != pipeline.allocator )
         {
-            ::vkDestroyDescriptorPool( device, pipeline.descriptor_pool, nullptr );
-            spdlog::debug( "vkDestroyDescriptorPool()" );
+            deallocate( pipeline.uniform_allocation, *pipeline.allocator, device );
         }
     }
 }
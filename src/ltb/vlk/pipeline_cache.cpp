@@ -0,0 +1,212 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/pipeline_cache.hpp"
+
+// project
+#include "ltb/ltb_config.hpp"
+#include "ltb/utils/ignore.hpp"
+#include "ltb/vlk/check.hpp"
+
+// standard
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+// platform
+#include <unistd.h>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+auto get_file_header(
+    VkPhysicalDevice const& physical_device,
+    DeviceId const&         device_id,
+    uint64 const            data_size
+) -> PipelineCacheFileHeader
+{
+    auto properties = VkPhysicalDeviceProperties{ };
+    ::vkGetPhysicalDeviceProperties( physical_device, &properties );
+
+    auto header = PipelineCacheFileHeader{
+        .magic               = pipeline_cache_file_magic,
+        .version             = pipeline_cache_file_version,
+        .vendor_id           = properties.vendorID,
+        .device_id           = properties.deviceID,
+        .driver_version      = properties.driverVersion,
+        .reserved            = 0U,
+        .data_size           = data_size,
+        .pipeline_cache_uuid = { },
+        .driver_uuid         = device_id.driver_uuid,
+    };
+    std::ranges::copy( properties.pipelineCacheUUID, header.pipeline_cache_uuid.begin( ) );
+    return header;
+}
+
+// Reads the driver's cache data if the file was saved by this device and driver.
+auto read_cache_data(
+    std::vector< std::byte >&      data,
+    PipelineCacheFileHeader const& expected_header,
+    std::filesystem::path const&   cache_path
+) -> void
+{
+    data.clear( );
+
+    auto file = std::ifstream( cache_path, std::ios::binary );
+    if ( !file.is_open( ) )
+    {
+        spdlog::info( "No pipeline cache at '{}'", cache_path.string( ) );
+        return;
+    }
+
+    auto header = PipelineCacheFileHeader{ };
+    file.read( reinterpret_cast< char* >( &header ), sizeof( header ) );
+
+    // A size that doesn't match is never trusted, so a corrupt file can't cause a huge read.
+    auto       error     = std::error_code{ };
+    auto const file_size = std::filesystem::file_size( cache_path, error );
+
+    auto const matches = file.good( ) && !error
+                      && ( ( sizeof( header ) + header.data_size ) == file_size )
+                      && ( expected_header.magic == header.magic )
+                      && ( expected_header.version == header.version )
+                      && ( expected_header.vendor_id == header.vendor_id )
+                      && ( expected_header.device_id == header.device_id )
+                      && ( expected_header.driver_version == header.driver_version )
+                      && ( expected_header.pipeline_cache_uuid == header.pipeline_cache_uuid )
+                      && ( expected_header.driver_uuid == header.driver_uuid );
+    if ( !matches )
+    {
+        spdlog::warn( "Ignoring pipeline cache from another device, driver, or build" );
+        return;
+    }
+
+    data.resize( header.data_size );
+    file.read(
+        reinterpret_cast< char* >( data.data( ) ),
+        static_cast< std::streamsize >( data.size( ) )
+    );
+    if ( !file.good( ) )
+    {
+        spdlog::warn( "Ignoring truncated pipeline cache" );
+        data.clear( );
+    }
+}
+
+} // namespace
+
+auto get_pipeline_cache_path( VkPhysicalDevice const& physical_device ) -> std::filesystem::path
+{
+    auto properties = VkPhysicalDeviceProperties{ };
+    ::vkGetPhysicalDeviceProperties( physical_device, &properties );
+
+    auto cache_dir_path = config::generated_dir_path( ) / "pipeline_cache";
+    if ( auto const* const dir_path = std::getenv( pipeline_cache_dir_variable );
+         nullptr != dir_path )
+    {
+        cache_dir_path = dir_path;
+    }
+
+    // Every device gets its own file, so apps on different devices don't overwrite each other.
+    return cache_dir_path
+         / fmt::format( "{:04x}_{:04x}.bin", properties.vendorID, properties.deviceID );
+}
+
+auto initialize_pipeline_cache(
+    VkPipelineCache&             pipeline_cache,
+    VkPhysicalDevice const&      physical_device,
+    DeviceId const&              device_id,
+    VkDevice const&              device,
+    std::filesystem::path const& cache_path
+) -> bool
+{
+    auto       data            = std::vector< std::byte >{ };
+    auto const expected_header = get_file_header( physical_device, device_id, 0U );
+    read_cache_data( data, expected_header, cache_path );
+
+    auto const cache_create_info = VkPipelineCacheCreateInfo{
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext           = nullptr,
+        .flags           = 0U,
+        .initialDataSize = data.size( ),
+        .pInitialData    = data.data( ),
+    };
+    CHECK_VK( ::vkCreatePipelineCache( device, &cache_create_info, nullptr, &pipeline_cache ) );
+    spdlog::debug( "vkCreatePipelineCache() w/ {} bytes", data.size( ) );
+
+    return true;
+}
+
+auto save_pipeline_cache(
+    VkPipelineCache const&       pipeline_cache,
+    VkPhysicalDevice const&      physical_device,
+    DeviceId const&              device_id,
+    VkDevice const&              device,
+    std::filesystem::path const& cache_path
+) -> bool
+{
+    auto data_size = size_t{ 0 };
+    CHECK_VK( ::vkGetPipelineCacheData( device, pipeline_cache, &data_size, nullptr ) );
+    auto data = std::vector< std::byte >( data_size );
+    CHECK_VK( ::vkGetPipelineCacheData( device, pipeline_cache, &data_size, data.data( ) ) );
+    data.resize( data_size );
+
+    auto error = std::error_code{ };
+    utils::ignore( std::filesystem::create_directories( cache_path.parent_path( ), error ) );
+    if ( error )
+    {
+        spdlog::error(
+            "Failed to create '{}': {}",
+            cache_path.parent_path( ).string( ),
+            error.message( )
+        );
+        return false;
+    }
+
+    // The cache is written next to the file and renamed over it, which is atomic.
+    auto temp_path = cache_path;
+    temp_path += fmt::format( ".{}.tmp", ::getpid( ) );
+    {
+        auto const header = get_file_header( physical_device, device_id, data.size( ) );
+
+        auto file = std::ofstream( temp_path, std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast< char const* >( &header ), sizeof( header ) );
+        file.write(
+            reinterpret_cast< char const* >( data.data( ) ),
+            static_cast< std::streamsize >( data.size( ) )
+        );
+        file.close( );
+        if ( !file.good( ) )
+        {
+            spdlog::error( "Failed to write '{}'", temp_path.string( ) );
+            utils::ignore( std::filesystem::remove( temp_path, error ) );
+            return false;
+        }
+    }
+
+    std::filesystem::rename( temp_path, cache_path, error );
+    if ( error )
+    {
+        spdlog::error( "Failed to replace '{}': {}", cache_path.string( ), error.message( ) );
+        utils::ignore( std::filesystem::remove( temp_path, error ) );
+        return false;
+    }
+    spdlog::debug( "Saved {} bytes of pipeline cache", data.size( ) );
+
+    return true;
+}
+
+auto destroy_pipeline_cache( VkPipelineCache& pipeline_cache, VkDevice const& device ) -> void
+{
+    if ( nullptr != pipeline_cache )
+    {
+        ::vkDestroyPipelineCache( device, pipeline_cache, nullptr );
+        spdlog::debug( "vkDestroyPipelineCache()" );
+        pipeline_cache = nullptr;
+    }
+}
+
+} // namespace ltb::vlk
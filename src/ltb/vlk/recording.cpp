@@ -0,0 +1,102 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/recording.hpp"
+
+// standard
+#include <algorithm>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+auto record_tasks(
+    std::stop_token const& stop_token,
+    RecordingThreadsData&  threads,
+    uint32 const           thread_index
+) -> void
+{
+    auto last_task_id = uint64{ 0 };
+
+    while ( true )
+    {
+        auto lock = std::unique_lock{ threads.mutex };
+        if ( !threads.task_started.wait(
+                 lock,
+                 stop_token,
+                 [ &threads, last_task_id ] { return last_task_id != threads.task_id; }
+             ) )
+        {
+            return;
+        }
+        last_task_id     = threads.task_id;
+        auto const& task = *threads.task;
+        lock.unlock( );
+
+        auto const succeeded = task( thread_index );
+
+        lock.lock( );
+        threads.succeeded = threads.succeeded && succeeded;
+        if ( 0U == --threads.busy_count )
+        {
+            threads.task_finished.notify_one( );
+        }
+    }
+}
+
+} // namespace
+
+auto get_recording_thread_count( ) -> uint32
+{
+    return std::max( std::thread::hardware_concurrency( ), 1U );
+}
+
+auto initialize( RecordingThreadsData& threads, uint32 const thread_count ) -> bool
+{
+    threads.thread_count = std::max( thread_count, 1U );
+
+    for ( auto thread_index = 1U; thread_index < threads.thread_count; ++thread_index )
+    {
+        threads.workers.emplace_back(
+            [ &threads, thread_index ]( std::stop_token const& stop_token )
+            { record_tasks( stop_token, threads, thread_index ); }
+        );
+    }
+    spdlog::debug( "Started {} recording threads", threads.workers.size( ) );
+
+    return true;
+}
+
+auto run( RecordingThreadsData& threads, std::function< bool( uint32 ) > const& task ) -> bool
+{
+    {
+        auto lock          = std::unique_lock{ threads.mutex };
+        threads.task       = &task;
+        threads.busy_count = static_cast< uint32 >( threads.workers.size( ) );
+        threads.succeeded  = true;
+        ++threads.task_id;
+    }
+    threads.task_started.notify_all( );
+
+    auto const succeeded = task( 0U );
+
+    auto lock = std::unique_lock{ threads.mutex };
+    threads.task_finished.wait( lock, [ &threads ] { return 0U == threads.busy_count; } );
+    threads.task = nullptr;
+
+    return succeeded && threads.succeeded;
+}
+
+auto destroy( RecordingThreadsData& threads ) -> void
+{
+    // Stopping a thread also wakes it up.
+    for ( auto& worker : threads.workers )
+    {
+        worker.request_stop( );
+    }
+    threads.workers.clear( );
+    threads.thread_count = 1U;
+}
+
+} // namespace ltb::vlk
@@ -6,15 +6,18 @@
 // project
 #include "ltb/utils/ignore.hpp"
 #include "ltb/vlk/check.hpp"
+#include "ltb/vlk/pipeline_cache.hpp"
 
 // external
 #include <spdlog/spdlog.h>
 
 // standard
 #include <algorithm>
+#include <memory>
 #include <optional>
 #include <ranges>
 #include <set>
+#include <string_view>
 
 // platform
 #include <fcntl.h>
@@ -240,13 +243,55 @@ struct DeviceQueueCreateInfo
     }
 };
 
+struct ExtensionNameEquals
+{
+    std::string_view name;
+
+    auto operator( )( VkExtensionProperties const& properties ) const -> bool
+    {
+        return name == properties.extensionName;
+    }
+};
+
+// Dma-buf sharing is optional since not every driver can export with explicit modifiers.
+auto constexpr dma_buf_extension_names = std::array{
+    VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME,
+    VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME,
+};
+
+auto get_device_id( VkPhysicalDevice const& physical_device ) -> DeviceId
+{
+    auto id_properties = VkPhysicalDeviceIDProperties{
+        .sType           = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+        .pNext           = nullptr,
+        .deviceUUID      = { },
+        .driverUUID      = { },
+        .deviceLUID      = { },
+        .deviceNodeMask  = 0U,
+        .deviceLUIDValid = VK_FALSE,
+    };
+    auto properties = VkPhysicalDeviceProperties2{
+        .sType      = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext      = &id_properties,
+        .properties = { },
+    };
+    ::vkGetPhysicalDeviceProperties2( physical_device, &properties );
+
+    auto device_id = DeviceId{ };
+    std::ranges::copy( id_properties.deviceUUID, device_id.device_uuid.begin( ) );
+    std::ranges::copy( id_properties.driverUUID, device_id.driver_uuid.begin( ) );
+    return device_id;
+}
+
 auto initialize_physical_device(
-    uint32 const        physical_device_index,
-    VkInstance const&   instance,
-    VkPhysicalDevice&   physical_device,
-    uint32&             graphics_queue_family_index_out,
-    VkSurfaceKHR const& optional_surface,
-    uint32*             optional_surface_queue_family_index_out
+    uint32 const                     physical_device_index,
+    std::optional< DeviceId > const& matching_device_id,
+    VkInstance const&                instance,
+    VkPhysicalDevice&                physical_device,
+    DeviceId&                        device_id,
+    uint32&                          graphics_queue_family_index_out,
+    VkSurfaceKHR const&              optional_surface,
+    uint32*                          optional_surface_queue_family_index_out
 )
 {
     auto physical_device_count = uint32{ 0 };
@@ -256,26 +301,41 @@ auto initialize_physical_device(
         ::vkEnumeratePhysicalDevices( instance, &physical_device_count, physical_devices.data( ) )
     );
 
+    // The device matching another process is preferred over the requested index,
+    // since only a matching device can import the other process's memory.
+    auto selected_index = std::optional< uint32 >{ };
     for ( auto i = uint32{ 0 }; i < physical_device_count; ++i )
     {
         auto properties = VkPhysicalDeviceProperties{ };
         ::vkGetPhysicalDeviceProperties( physical_devices[ i ], &properties );
         spdlog::info( "Device[{}]: {}", i, properties.deviceName );
+
+        if ( !selected_index && matching_device_id
+             && ( matching_device_id.value( ) == get_device_id( physical_devices[ i ] ) ) )
+        {
+            selected_index = i;
+        }
+    }
+
+    if ( matching_device_id && !selected_index )
+    {
+        spdlog::warn( "No device matches the other process, memory can't be shared directly" );
     }
 
-    if ( physical_device_index >= physical_device_count )
+    if ( !selected_index && ( physical_device_index >= physical_device_count ) )
     {
         spdlog::error( "Invalid physical device index: {}", physical_device_index );
         return false;
     }
 
-    physical_device = physical_devices[ physical_device_index ];
+    physical_device = physical_devices[ selected_index.value_or( physical_device_index ) ];
+    device_id       = get_device_id( physical_device );
 
     auto physical_device_properties = VkPhysicalDeviceProperties{ };
     ::vkGetPhysicalDeviceProperties( physical_device, &physical_device_properties );
     spdlog::info(
         "Using Device[{}]: {}",
-        physical_device_index,
+        selected_index.value_or( physical_device_index ),
         physical_device_properties.deviceName
     );
 
@@ -353,7 +413,9 @@ auto initialize_device(
     VkQueue&                          graphics_queue,
     VkCommandPool&                    graphics_command_pool,
     std::optional< uint32 > const&    optional_surface_queue_family_index,
-    VkQueue*                          optional_surface_queue
+    VkQueue*                          optional_surface_queue,
+    bool&                             supports_dma_buf,
+    bool&                             supports_calibrated_timestamps
 )
 {
     auto unique_queue_indices = std::set{
@@ -377,6 +439,8 @@ auto initialize_device(
     auto device_extension_names = std::vector{
         VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
         VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+        VK_KHR_EXTERNAL_SEMAPHORE_EXTENSION_NAME,
+        VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME,
     };
     utils::ignore( device_extension_names.insert(
         device_extension_names.end( ),
@@ -384,12 +448,59 @@ auto initialize_device(
         extra_device_extension_names.end( )
     ) );
 
+    auto available_extension_count = uint32{ 0 };
+    CHECK_VK( ::vkEnumerateDeviceExtensionProperties(
+        physical_device,
+        nullptr,
+        &available_extension_count,
+        nullptr
+    ) );
+    auto available_extensions = std::vector< VkExtensionProperties >( available_extension_count );
+    CHECK_VK( ::vkEnumerateDeviceExtensionProperties(
+        physical_device,
+        nullptr,
+        &available_extension_count,
+        available_extensions.data( )
+    ) );
+
+    supports_dma_buf = std::ranges::all_of(
+        dma_buf_extension_names,
+        [ &available_extensions ]( char const* const name )
+        { return std::ranges::any_of( available_extensions, ExtensionNameEquals{ name } ); }
+    );
+    if ( supports_dma_buf )
+    {
+        utils::ignore( device_extension_names.insert(
+            device_extension_names.end( ),
+            dma_buf_extension_names.begin( ),
+            dma_buf_extension_names.end( )
+        ) );
+    }
+    spdlog::info( "Dma-buf sharing {}", supports_dma_buf ? "supported" : "not supported" );
+
+    // Latency tracing compares GPU timestamps with timestamps taken by other processes.
+    supports_calibrated_timestamps = std::ranges::any_of(
+        available_extensions,
+        ExtensionNameEquals{ VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME }
+    );
+    if ( supports_calibrated_timestamps )
+    {
+        device_extension_names.push_back( VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME );
+    }
+
     auto device_features              = VkPhysicalDeviceFeatures{ };
     device_features.samplerAnisotropy = VK_TRUE;
 
+    // Timeline semaphores carry frame progress between processes.
+    auto timeline_semaphore_features = VkPhysicalDeviceTimelineSemaphoreFeatures{
+        .sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES,
+        .pNext             = nullptr,
+        .timelineSemaphore = VK_TRUE,
+    };
+
     auto const device_create_info = VkDeviceCreateInfo{
         .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext                   = nullptr,
+        .pNext                   = &timeline_semaphore_features,
         .flags                   = 0U,
         .queueCreateInfoCount    = static_cast< uint32 >( queue_create_infos.size( ) ),
         .pQueueCreateInfos       = queue_create_infos.data( ),
@@ -449,7 +560,11 @@ struct SurfaceFormatEquals
 } // namespace
 
 template <>
-auto initialize( SetupData< AppType::Headless >& setup, uint32 const physical_device_index ) -> bool
+auto initialize(
+    SetupData< AppType::Headless >&  setup,
+    uint32 const                     physical_device_index,
+    std::optional< DeviceId > const& matching_device_id
+) -> bool
 {
     // Setup non-blocking console input
     if ( auto const fcntl_get_result = ::fcntl( STDIN_FILENO, F_SETFL, O_NONBLOCK );
@@ -481,8 +596,10 @@ auto initialize( SetupData< AppType::Headless >& setup, uint32 const physical_de
     auto const surface_queue_family_index = nullptr;
     CHECK_TRUE( initialize_physical_device(
         physical_device_index,
+        matching_device_id,
         setup.instance,
         setup.physical_device,
+        setup.device_id,
         setup.graphics_queue_family_index,
         surface,
         surface_queue_family_index
@@ -499,7 +616,21 @@ auto initialize( SetupData< AppType::Headless >& setup, uint32 const physical_de
         setup.graphics_queue,
         setup.graphics_command_pool,
         optional_surface_queue_family_index,
-        surface_queue
+        surface_queue,
+        setup.supports_dma_buf,
+        setup.supports_calibrated_timestamps
+    ) );
+
+    setup.allocator = std::make_unique< AllocatorData >( );
+    CHECK_TRUE( initialize( *setup.allocator, setup.physical_device ) );
+
+    setup.pipeline_cache_path = get_pipeline_cache_path( setup.physical_device );
+    CHECK_TRUE( initialize_pipeline_cache(
+        setup.pipeline_cache,
+        setup.physical_device,
+        setup.device_id,
+        setup.device,
+        setup.pipeline_cache_path
     ) );
 
     setup.color_format = VK_FORMAT_B8G8R8A8_SRGB;
@@ -507,7 +638,11 @@ auto initialize( SetupData< AppType::Headless >& setup, uint32 const physical_de
 }
 
 template <>
-auto initialize( SetupData< AppType::Windowed >& setup, uint32 const physical_device_index ) -> bool
+auto initialize(
+    SetupData< AppType::Windowed >&  setup,
+    uint32 const                     physical_device_index,
+    std::optional< DeviceId > const& matching_device_id
+) -> bool
 {
     CHECK_TRUE( initialize_glfw( setup.glfw, setup.window ) );
 
@@ -534,8 +669,10 @@ auto initialize( SetupData< AppType::Windowed >& setup, uint32 const physical_de
     };
     CHECK_TRUE( initialize_physical_device(
         physical_device_index,
+        matching_device_id,
         setup.instance,
         setup.physical_device,
+        setup.device_id,
         setup.graphics_queue_family_index,
         setup.surface,
         &setup.surface_queue_family_index
@@ -549,7 +686,21 @@ auto initialize( SetupData< AppType::Windowed >& setup, uint32 const physical_de
         setup.graphics_queue,
         setup.graphics_command_pool,
         setup.surface_queue_family_index,
-        &setup.surface_queue
+        &setup.surface_queue,
+        setup.supports_dma_buf,
+        setup.supports_calibrated_timestamps
+    ) );
+
+    setup.allocator = std::make_unique< AllocatorData >( );
+    CHECK_TRUE( initialize( *setup.allocator, setup.physical_device ) );
+
+    setup.pipeline_cache_path = get_pipeline_cache_path( setup.physical_device );
+    CHECK_TRUE( initialize_pipeline_cache(
+        setup.pipeline_cache,
+        setup.physical_device,
+        setup.device_id,
+        setup.device,
+        setup.pipeline_cache_path
     ) );
 
     auto physical_device_formats_count = uint32{ 0 };
@@ -583,6 +734,25 @@ auto initialize( SetupData< AppType::Windowed >& setup, uint32 const physical_de
 template < AppType app_type >
 auto destroy( SetupData< app_type >& setup ) -> void
 {
+    // A cache that can't be saved only costs the next run its compile time.
+    if ( nullptr != setup.pipeline_cache )
+    {
+        utils::ignore( save_pipeline_cache(
+            setup.pipeline_cache,
+            setup.physical_device,
+            setup.device_id,
+            setup.device,
+            setup.pipeline_cache_path
+        ) );
+        destroy_pipeline_cache( setup.pipeline_cache, setup.device );
+    }
+
+    if ( setup.allocator )
+    {
+        destroy( *setup.allocator, setup.device );
+        setup.allocator.reset( );
+    }
+
     if ( nullptr != setup.graphics_command_pool )
     {
         ::vkDestroyCommandPool( setup.device, setup.graphics_command_pool, nullptr );
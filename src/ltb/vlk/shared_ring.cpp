@@ -0,0 +1,735 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/shared_ring.hpp"
+
+// project
+#include "ltb/utils/ignore.hpp"
+#include "ltb/vlk/check.hpp"
+
+// standard
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <new>
+
+// platform
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+auto validate( SharedRingMessage const& message, std::span< int32 const > const file_descriptors )
+    -> bool
+{
+    if ( ( shared_ring_message_magic != message.magic )
+         || ( shared_ring_message_version != message.version ) )
+    {
+        spdlog::error(
+            "Unsupported shared ring message: magic {:#x}, version {}",
+            message.magic,
+            message.version
+        );
+        return false;
+    }
+
+    if ( ( 0U == message.slot_count ) || ( message.slot_count > max_shared_ring_slots ) )
+    {
+        spdlog::error( "Invalid ring slot count: {}", message.slot_count );
+        return false;
+    }
+
+    auto const image_fd_count    = ( 0U != message.pooled ) ? 1U : message.slot_count;
+    auto const expected_fd_count = shared_ring_message_image_fd_offset + image_fd_count;
+    if ( ( expected_fd_count != message.fd_count )
+         || ( message.fd_count != file_descriptors.size( ) ) )
+    {
+        spdlog::error(
+            "Expected {} file descriptors, received {}",
+            expected_fd_count,
+            file_descriptors.size( )
+        );
+        return false;
+    }
+
+    for ( auto slot = 0U; slot < message.slot_count; ++slot )
+    {
+        auto const& description = message.images[ slot ];
+        if ( ( slot != description.slot ) || ( message.generation != description.generation ) )
+        {
+            spdlog::error( "Image description {} doesn't belong to this ring", slot );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Closes the file descriptors that weren't handed over to Vulkan yet.
+auto close_from( std::span< int32 const > const file_descriptors, size_t const first ) -> void
+{
+    for ( auto i = first; i < file_descriptors.size( ); ++i )
+    {
+        utils::ignore( ::close( file_descriptors[ i ] ) );
+    }
+}
+
+auto constexpr queue_depth_report_interval = std::chrono::seconds( 5 );
+
+auto slot_bit( uint32 const slot ) -> uint32
+{
+    return 1U << slot;
+}
+
+auto acquire_mailbox_slot(
+    SharedRingData< ExternalMemory::Export >& ring,
+    uint32&                                   slot,
+    uint64&                                   ready_value
+) -> bool
+{
+    auto& control = *ring.control;
+
+    // The newest frame is kept for the consumer, and of the remaining slots
+    // the consumer doesn't hold, the one with the oldest frame is reused.
+    auto const consumer_slots = control.consumer_slots.load( );
+    auto       free_slot      = std::optional< uint32 >{ };
+    auto       oldest_value   = std::numeric_limits< uint64 >::max( );
+    for ( auto candidate = 0U; candidate < control.slot_count; ++candidate )
+    {
+        auto const value = control.slot_ready_values[ candidate ].load( );
+        if ( ( 0U == ( consumer_slots & slot_bit( candidate ) ) )
+             && ( ring.newest_slot != candidate ) && ( value <= oldest_value ) )
+        {
+            free_slot    = candidate;
+            oldest_value = value;
+        }
+    }
+    if ( !free_slot )
+    {
+        return false;
+    }
+
+    // Claim the slot, then make sure the consumer didn't start sampling it in the
+    // meantime. If it did, it saw the old frame and keeps it, so the slot is skipped.
+    auto const frame_id = ring.next_frame_id;
+    control.slot_ready_values[ free_slot.value( ) ].store( frame_id + 1U );
+    if ( 0U != ( control.consumer_slots.load( ) & slot_bit( free_slot.value( ) ) ) )
+    {
+        control.slot_ready_values[ free_slot.value( ) ].store( 0U );
+        return false;
+    }
+
+    slot             = free_slot.value( );
+    ready_value      = frame_id + 1U;
+    ring.newest_slot = slot;
+    ++ring.next_frame_id;
+    return true;
+}
+
+// Frames between the last latched one and this one are counted as dropped.
+auto latch(
+    SharedRingData< ExternalMemory::Import >& ring,
+    uint64 const                              frame_id,
+    uint32 const                              slot
+) -> void
+{
+    auto const first_frame_id = ring.next_frame_id;
+
+    ring.dropped_frame_count += frame_id - first_frame_id;
+    ++ring.latched_frame_count;
+
+    ring.latched_frame_id = frame_id;
+    ring.latched_slot     = slot;
+    ring.next_frame_id    = frame_id + 1U;
+
+    // Records of frames before this one were skipped or never published. The damage
+    // of skipped frames is carried over, since they were never displayed either.
+    auto merged_record = std::optional< FrameRecord >{ };
+    auto merged_count  = uint64{ 0 };
+    auto const* record = net::peek( ring.control->frames );
+    while ( ( nullptr != record ) && ( record->frame_id <= frame_id ) )
+    {
+        auto popped = FrameRecord{ };
+        utils::ignore( net::try_pop( ring.control->frames, popped ) );
+        if ( popped.frame_id >= first_frame_id )
+        {
+            if ( merged_record )
+            {
+                merge_damage( popped, merged_record.value( ) );
+            }
+            merged_record = popped;
+            ++merged_count;
+        }
+        record = net::peek( ring.control->frames );
+    }
+
+    ring.latched_record = std::nullopt;
+    if ( merged_record && ( merged_record->frame_id == frame_id ) )
+    {
+        ring.latched_record = merged_record;
+
+        // Skipped frames without a record may have changed anything.
+        if ( merged_count != ( frame_id - first_frame_id + 1U ) )
+        {
+            ring.latched_record->damage_count = 0U;
+        }
+    }
+}
+
+auto latch_mailbox_slot(
+    SharedRingData< ExternalMemory::Import >& ring,
+    VkDevice const&                           device,
+    SyncData< AppType::Windowed >&            sync
+) -> std::optional< uint32 >
+{
+    auto& control = *ring.control;
+
+    // Find the newest finished frame that's newer than the latched one.
+    auto ready_value = uint64{ 0 };
+    auto newest_slot = std::optional< uint32 >{ };
+    auto newest      = ring.next_frame_id;
+    if ( get_timeline_value( ready_value, device, ring.ready_timeline ) )
+    {
+        for ( auto slot = 0U; slot < control.slot_count; ++slot )
+        {
+            auto const value = control.slot_ready_values[ slot ].load( );
+            if ( ( value > newest ) && ( value <= ready_value ) )
+            {
+                newest_slot = slot;
+                newest      = value;
+            }
+        }
+    }
+
+    // Hold the slot, then make sure the producer didn't start rendering a newer frame
+    // into it in the meantime. If it did, the previously latched frame is kept.
+    if ( newest_slot )
+    {
+        control.consumer_slots.fetch_or( slot_bit( newest_slot.value( ) ) );
+        if ( newest == control.slot_ready_values[ newest_slot.value( ) ].load( ) )
+        {
+            latch( ring, newest - 1U, newest_slot.value( ) );
+
+            // The value is already reached, but the wait orders the image reads after the producer.
+            sync.wait_timelines.push_back( ring.ready_timeline );
+            sync.wait_values.push_back( newest );
+        }
+    }
+
+    // This frame's fence was waited on, so only the slots of the other frames in
+    // flight and the latched slot are still held. Only the consumer writes the word.
+    ring.frame_slots.resize( sync.graphics_queue_fences.size( ) );
+    ring.frame_slots[ sync.current_frame ] = ring.latched_slot;
+
+    auto consumer_slots = uint32{ 0 };
+    for ( auto const& frame_slot : ring.frame_slots )
+    {
+        if ( frame_slot )
+        {
+            consumer_slots |= slot_bit( frame_slot.value( ) );
+        }
+    }
+    control.consumer_slots.store( consumer_slots );
+
+    return ring.latched_slot;
+}
+
+// Maps the control block and imports the timelines, which come before the images.
+auto import_control(
+    SharedRingData< ExternalMemory::Import >& ring,
+    VkInstance const&                         instance,
+    VkDevice const&                           device,
+    SharedRingMessage const&                  message,
+    std::span< int32 const > const            file_descriptors
+) -> bool
+{
+    // Everything is validated before any file descriptor is handed to Vulkan.
+    if ( !validate( message, file_descriptors ) )
+    {
+        close_from( file_descriptors, 0U );
+        return false;
+    }
+
+    if ( !ring.memory.map( file_descriptors[ 0 ] ) )
+    {
+        close_from( file_descriptors, 1U );
+        return false;
+    }
+
+    if ( ( ring.memory.size( ) < sizeof( SharedRingControl ) )
+         || ( message.slot_count
+              != static_cast< SharedRingControl* >( ring.memory.data( ) )->slot_count ) )
+    {
+        spdlog::error( "Shared ring control block doesn't match the message" );
+        close_from( file_descriptors, 1U );
+        return false;
+    }
+    ring.control    = static_cast< SharedRingControl* >( ring.memory.data( ) );
+    ring.generation = message.generation;
+
+    if ( ( RingMode::Fifo != ring.control->mode ) && ( RingMode::Mailbox != ring.control->mode ) )
+    {
+        spdlog::error( "Unknown ring mode: {}", static_cast< uint32 >( ring.control->mode ) );
+        close_from( file_descriptors, 1U );
+        return false;
+    }
+
+    if ( !import_timeline( ring.ready_timeline, instance, device, file_descriptors[ 1 ] ) )
+    {
+        close_from( file_descriptors, 2U );
+        return false;
+    }
+    if ( !import_timeline( ring.released_timeline, instance, device, file_descriptors[ 2 ] ) )
+    {
+        close_from( file_descriptors, shared_ring_message_image_fd_offset );
+        return false;
+    }
+
+    return true;
+}
+
+auto import_images(
+    SharedRingData< ExternalMemory::Import >& ring,
+    AllocatorData&                            allocator,
+    VkDevice const&                           device,
+    SharedRingMessage const&                  message,
+    std::span< int32 const > const            file_descriptors
+) -> bool
+{
+    if ( 0U != message.pooled )
+    {
+        auto const fd_index = shared_ring_message_image_fd_offset;
+        if ( !initialize(
+                 ring.image_pool,
+                 ring.images,
+                 allocator,
+                 device,
+                 std::span{ message.images.data( ), message.slot_count },
+                 file_descriptors[ fd_index ]
+             ) )
+        {
+            close_from( file_descriptors, fd_index + 1U );
+            return false;
+        }
+        spdlog::debug( "Shared ring imported with {} pooled slots", message.slot_count );
+        return true;
+    }
+
+    ring.images.resize( message.slot_count );
+    for ( auto slot = 0U; slot < message.slot_count; ++slot )
+    {
+        auto const fd_index = shared_ring_message_image_fd_offset + slot;
+        if ( !initialize(
+                 ring.images[ slot ],
+                 allocator,
+                 device,
+                 message.images[ slot ],
+                 file_descriptors[ fd_index ]
+             ) )
+        {
+            close_from( file_descriptors, fd_index + 1U );
+            return false;
+        }
+    }
+    spdlog::debug( "Shared ring imported with {} slots", message.slot_count );
+
+    return true;
+}
+
+} // namespace
+
+auto initialize(
+    SharedRingData< ExternalMemory::Export >& ring,
+    AllocatorData&                            allocator,
+    VkDevice const&                           device,
+    VkExtent3D const                          image_extents,
+    VkFormat const                            color_format,
+    ExternalHandle const                      handle_type,
+    RingMode const                            mode,
+    uint32 const                              slot_count
+) -> bool
+{
+    if ( ( 0U == slot_count ) || ( slot_count > max_shared_ring_slots ) )
+    {
+        spdlog::error( "Invalid ring slot count: {}", slot_count );
+        return false;
+    }
+
+    // Lets consumers tell a restarted producer's images apart from the previous ones.
+    ring.generation = static_cast< uint64 >(
+        std::chrono::steady_clock::now( ).time_since_epoch( ).count( )
+    );
+
+    CHECK_TRUE( ring.memory.create( "ltb_shared_ring", sizeof( SharedRingControl ) ) );
+    ring.control             = new ( ring.memory.data( ) ) SharedRingControl{ };
+    ring.control->slot_count = slot_count;
+    ring.control->mode       = mode;
+
+    CHECK_TRUE( initialize_timeline( ring.ready_timeline, device, ExternalMemory::Export ) );
+    CHECK_TRUE( initialize_timeline( ring.released_timeline, device, ExternalMemory::Export ) );
+
+    CHECK_TRUE( initialize(
+        ring.image_pool,
+        ring.images,
+        allocator,
+        device,
+        image_extents,
+        color_format,
+        handle_type,
+        slot_count
+    ) );
+    spdlog::debug(
+        "{} shared ring initialized with {} slots",
+        ( RingMode::Mailbox == mode ) ? "Mailbox" : "FIFO",
+        slot_count
+    );
+
+    return true;
+}
+
+auto initialize(
+    SharedRingData< ExternalMemory::Import >& ring,
+    AllocatorData&                            allocator,
+    VkInstance const&                         instance,
+    VkDevice const&                           device,
+    SharedRingMessage const&                  message,
+    std::span< int32 const >                  file_descriptors
+) -> bool
+{
+    CHECK_TRUE( import_control( ring, instance, device, message, file_descriptors ) );
+    CHECK_TRUE( import_images( ring, allocator, device, message, file_descriptors ) );
+    return true;
+}
+
+auto initialize(
+    SharedRingData< ExternalMemory::Import >& ring,
+    AllocatorData&                            allocator,
+    VkInstance const&                         instance,
+    VkDevice const&                           device,
+    SharedRingMessage const&                  message,
+    std::span< int32 const >                  file_descriptors,
+    ImportCacheData&                          cache,
+    uint32 const                              producer_id
+) -> bool
+{
+    CHECK_TRUE( import_control( ring, instance, device, message, file_descriptors ) );
+
+    // The images of a re-announced generation are already imported, so their fds aren't needed.
+    if ( acquire( cache, producer_id, message.generation, message.slot_count, ring.images ) )
+    {
+        close_from( file_descriptors, shared_ring_message_image_fd_offset );
+    }
+    else
+    {
+        CHECK_TRUE( import_images( ring, allocator, device, message, file_descriptors ) );
+        insert( cache, producer_id, message.generation, ring.images, ring.image_pool );
+    }
+    ring.image_cache = &cache;
+    ring.producer_id = producer_id;
+
+    return true;
+}
+
+auto get_message(
+    SharedRingMessage&                              message,
+    std::vector< int32 >&                           file_descriptors,
+    VkInstance const&                               instance,
+    VkDevice const&                                 device,
+    SharedRingData< ExternalMemory::Export > const& ring
+) -> bool
+{
+    message            = SharedRingMessage{ };
+    message.slot_count = static_cast< uint32 >( ring.images.size( ) );
+    message.generation = ring.generation;
+    message.pooled     = ( nullptr != ring.image_pool.memory ) ? 1U : 0U;
+    message.fd_count   = shared_ring_message_image_fd_offset
+                     + ( ( 0U != message.pooled ) ? 1U : message.slot_count );
+
+    file_descriptors.clear( );
+
+    // The control block fd is still owned by the ring, so the caller gets a duplicate.
+    if ( auto const control_fd = ::fcntl( ring.memory.fd( ), F_DUPFD_CLOEXEC, 0 ); control_fd >= 0 )
+    {
+        file_descriptors.push_back( control_fd );
+    }
+    else
+    {
+        spdlog::error( "fcntl() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    for ( auto const& timeline : { ring.ready_timeline, ring.released_timeline } )
+    {
+        auto file_descriptor = int32{ -1 };
+        CHECK_TRUE( get_file_descriptor( file_descriptor, instance, device, timeline ) );
+        file_descriptors.push_back( file_descriptor );
+    }
+
+    if ( 0U != message.pooled )
+    {
+        for ( auto slot = 0U; slot < message.slot_count; ++slot )
+        {
+            auto const& image = ring.images[ slot ];
+            describe( message.images[ slot ], ring.image_pool, image, slot, ring.generation );
+        }
+
+        auto file_descriptor = int32{ -1 };
+        CHECK_TRUE( get_file_descriptor( file_descriptor, instance, device, ring.image_pool ) );
+        file_descriptors.push_back( file_descriptor );
+        return true;
+    }
+
+    for ( auto slot = 0U; slot < message.slot_count; ++slot )
+    {
+        auto const& image = ring.images[ slot ];
+        describe( message.images[ slot ], image, slot, ring.generation );
+
+        auto file_descriptor = int32{ -1 };
+        CHECK_TRUE( get_file_descriptor( file_descriptor, instance, device, image ) );
+        file_descriptors.push_back( file_descriptor );
+    }
+    return true;
+}
+
+auto wait_for_credit(
+    SharedRingData< ExternalMemory::Export >& ring,
+    VkDevice const&                           device,
+    std::chrono::nanoseconds const            timeout,
+    bool&                                     has_credit
+) -> bool
+{
+    has_credit = true;
+    if ( RingMode::Mailbox == ring.control->mode )
+    {
+        return true;
+    }
+
+    auto released_value = uint64{ 0 };
+    CHECK_TRUE( get_timeline_value( released_value, device, ring.released_timeline ) );
+
+    auto&      stats      = ring.stats;
+    auto const slot_count = uint64{ ring.control->slot_count };
+    auto const depth      = ring.next_frame_id - std::min( released_value, ring.next_frame_id );
+    ++stats.sample_count;
+    stats.depth_sum += depth;
+    stats.max_depth = std::max( stats.max_depth, depth );
+
+    // Every slot holds a frame the consumer hasn't released, so it's truly behind.
+    if ( depth >= slot_count )
+    {
+        auto const credit_value = ring.next_frame_id - slot_count + 1U;
+        auto const wait_info    = VkSemaphoreWaitInfo{
+            .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+            .pNext          = nullptr,
+            .flags          = 0U,
+            .semaphoreCount = 1U,
+            .pSemaphores    = &ring.released_timeline,
+            .pValues        = &credit_value,
+        };
+
+        auto const stall_start = std::chrono::steady_clock::now( );
+        auto const wait_result = ::vkWaitSemaphores(
+            device,
+            &wait_info,
+            static_cast< uint64 >( timeout.count( ) )
+        );
+        if ( VK_TIMEOUT != wait_result )
+        {
+            CHECK_VK( wait_result );
+        }
+        ++stats.stall_count;
+        stats.stall_time += std::chrono::steady_clock::now( ) - stall_start;
+        has_credit = ( VK_SUCCESS == wait_result );
+    }
+
+    if ( auto const now = std::chrono::steady_clock::now( );
+         ( now - stats.report_time ) >= queue_depth_report_interval )
+    {
+        if ( stats.sample_count > 0U )
+        {
+            spdlog::info(
+                "Ring queue depth: {:.2f} avg, {} max of {} slots, {} stalls ({:.1f} ms)",
+                static_cast< float64 >( stats.depth_sum )
+                    / static_cast< float64 >( stats.sample_count ),
+                stats.max_depth,
+                slot_count,
+                stats.stall_count,
+                std::chrono::duration< float64, std::milli >( stats.stall_time ).count( )
+            );
+        }
+        stats             = QueueDepthStats{ };
+        stats.report_time = now;
+    }
+
+    return true;
+}
+
+auto acquire_render_slot(
+    SharedRingData< ExternalMemory::Export >& ring,
+    uint32&                                   slot,
+    uint64&                                   ready_value,
+    uint64&                                   credit_value
+) -> bool
+{
+    credit_value = 0U;
+    if ( RingMode::Mailbox == ring.control->mode )
+    {
+        return acquire_mailbox_slot( ring, slot, ready_value );
+    }
+
+    auto const slot_count = uint64{ ring.control->slot_count };
+    auto const frame_id   = ring.next_frame_id;
+
+    // The slot was last used by frame_id - slot_count, which
+    // is released once the released timeline passes it.
+    if ( frame_id >= slot_count )
+    {
+        credit_value = frame_id - slot_count + 1U;
+    }
+
+    slot        = static_cast< uint32 >( frame_id % slot_count );
+    ready_value = frame_id + 1U;
+    ++ring.next_frame_id;
+    return true;
+}
+
+auto publish_frame( SharedRingData< ExternalMemory::Export >& ring, FrameRecord const& record )
+    -> bool
+{
+    return net::try_push( ring.control->frames, record );
+}
+
+auto add_damage( FrameRecord& record, VkRect2D const& rect ) -> void
+{
+    if ( record.damage_count < max_damage_rects )
+    {
+        record.damage[ record.damage_count ] = to_damage( rect );
+        ++record.damage_count;
+        return;
+    }
+
+    auto& last_damage = record.damage.back( );
+    last_damage       = to_damage( unite( to_rect( last_damage ), rect ) );
+}
+
+auto merge_damage( FrameRecord& record, FrameRecord const& skipped_record ) -> void
+{
+    // Either frame may have changed everywhere.
+    if ( ( 0U == record.damage_count ) || ( 0U == skipped_record.damage_count ) )
+    {
+        record.damage_count = 0U;
+        return;
+    }
+
+    auto const damage_count = std::min( skipped_record.damage_count, max_damage_rects );
+    for ( auto index = 0U; index < damage_count; ++index )
+    {
+        add_damage( record, to_rect( skipped_record.damage[ index ] ) );
+    }
+}
+
+auto publish_timing( SharedRingData< ExternalMemory::Export >& ring, FrameTiming const& timing )
+    -> bool
+{
+    return net::try_push( ring.control->timings, timing );
+}
+
+auto find_frame_timing( SharedRingData< ExternalMemory::Import >& ring, uint64 const frame_id )
+    -> std::optional< FrameTiming >
+{
+    auto timing = FrameTiming{ };
+    while ( net::try_pop( ring.control->timings, timing ) )
+    {
+        if ( ring.frame_timings.size( ) == frame_record_capacity )
+        {
+            ring.frame_timings.pop_front( );
+        }
+        ring.frame_timings.push_back( timing );
+    }
+
+    auto const found = std::ranges::find( ring.frame_timings, frame_id, &FrameTiming::frame_id );
+    if ( found == ring.frame_timings.end( ) )
+    {
+        return std::nullopt;
+    }
+    return *found;
+}
+
+auto latch_ready_slot(
+    SharedRingData< ExternalMemory::Import >& ring,
+    VkDevice const&                           device,
+    SyncData< AppType::Windowed >&            sync
+) -> std::optional< uint32 >
+{
+    if ( RingMode::Mailbox == ring.control->mode )
+    {
+        return latch_mailbox_slot( ring, device, sync );
+    }
+
+    // Frames are latched in order, one at a time, so every frame is displayed.
+    auto ready_value = uint64{ 0 };
+    if ( get_timeline_value( ready_value, device, ring.ready_timeline )
+         && ( ready_value > ring.next_frame_id ) )
+    {
+        auto const frame_id = ring.next_frame_id;
+        latch( ring, frame_id, static_cast< uint32 >( frame_id % ring.control->slot_count ) );
+        ring.queue_depth = ready_value - ring.next_frame_id;
+
+        // The value is already reached, but the wait orders the image reads after the producer.
+        sync.wait_timelines.push_back( ring.ready_timeline );
+        sync.wait_values.push_back( frame_id + 1U );
+
+        // Once this submit is done, every frame before this one has been released.
+        // Timeline signals must increase, so there's nothing to signal for frame 0.
+        if ( frame_id > 0U )
+        {
+            sync.signal_timelines.push_back( ring.released_timeline );
+            sync.signal_values.push_back( frame_id );
+        }
+    }
+
+    return ring.latched_slot;
+}
+
+template < ExternalMemory mem_type >
+auto destroy( SharedRingData< mem_type >& ring, VkDevice const& device ) -> void
+{
+    if constexpr ( ExternalMemory::Import == mem_type )
+    {
+        // Cached images outlive the ring, and are destroyed by the cache once evicted.
+        if ( nullptr != ring.image_cache )
+        {
+            release(
+                *ring.image_cache,
+                ring.producer_id,
+                ring.generation,
+                static_cast< uint32 >( ring.images.size( ) )
+            );
+            ring.images.clear( );
+            ring.image_cache = nullptr;
+        }
+    }
+
+    for ( auto& image : ring.images )
+    {
+        destroy( image, device );
+    }
+    ring.images.clear( );
+    destroy( ring.image_pool, device );
+
+    destroy_timeline( ring.released_timeline, device );
+    destroy_timeline( ring.ready_timeline, device );
+
+    ring.control = nullptr;
+    ring.memory.reset( );
+}
+
+template auto destroy( SharedRingData< ExternalMemory::Export >&, VkDevice const& ) -> void;
+template auto destroy( SharedRingData< ExternalMemory::Import >&, VkDevice const& ) -> void;
+
+} // namespace ltb::vlk
@@ -0,0 +1,84 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/spirv.hpp"
+
+// project
+#include "ltb/utils/read_file.hpp"
+
+// external
+#include <spdlog/spdlog.h>
+
+// standard
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+// Generated from the shaders in res/shaders when the library is built.
+auto constexpr triangle_vert_spirv = std::to_array< uint32 >( {
+#include "ltb/spirv/triangle.vert.inc"
+} );
+auto constexpr triangle_frag_spirv = std::to_array< uint32 >( {
+#include "ltb/spirv/triangle.frag.inc"
+} );
+auto constexpr composite_vert_spirv = std::to_array< uint32 >( {
+#include "ltb/spirv/composite.vert.inc"
+} );
+auto constexpr composite_frag_spirv = std::to_array< uint32 >( {
+#include "ltb/spirv/composite.frag.inc"
+} );
+
+struct EmbeddedShader
+{
+    std::string_view          name  = { };
+    std::span< uint32 const > spirv = { };
+};
+
+auto constexpr embedded_shaders = std::array{
+    EmbeddedShader{ .name = "triangle.vert", .spirv = triangle_vert_spirv },
+    EmbeddedShader{ .name = "triangle.frag", .spirv = triangle_frag_spirv },
+    EmbeddedShader{ .name = "composite.vert", .spirv = composite_vert_spirv },
+    EmbeddedShader{ .name = "composite.frag", .spirv = composite_frag_spirv },
+};
+
+} // namespace
+
+auto get_spirv(
+    std::span< uint32 const >& spirv,
+    std::vector< uint32 >&     override_code,
+    std::string_view const     shader_name
+) -> bool
+{
+    if ( auto const* const dir_path = std::getenv( spirv_shader_dir_variable );
+         nullptr != dir_path )
+    {
+        auto const shader_path
+            = std::filesystem::path( dir_path ) / ( std::string( shader_name ) + ".spv" );
+        if ( !utils::get_binary_file_contents( shader_path, override_code ) )
+        {
+            return false;
+        }
+        spdlog::info( "Loaded shader override '{}'", shader_path.string( ) );
+        spirv = override_code;
+        return true;
+    }
+
+    auto const* const shader
+        = std::ranges::find( embedded_shaders, shader_name, &EmbeddedShader::name );
+    if ( embedded_shaders.end( ) == shader )
+    {
+        spdlog::error( "No shader named '{}' was compiled into the library", shader_name );
+        return false;
+    }
+    spirv = shader->spirv;
+    return true;
+}
+
+} // namespace ltb::vlk
@@ -0,0 +1,566 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/stream.hpp"
+
+// project
+#include "ltb/net/frame_delta.hpp"
+#include "ltb/net/shared_memory.hpp"
+#include "ltb/utils/ignore.hpp"
+#include "ltb/vlk/check.hpp"
+
+// standard
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+
+// platform
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+auto constexpr stats_report_interval = std::chrono::seconds( 5 );
+
+// Enough to keep the sender busy while the next frame is encoded.
+auto constexpr max_encoded_frames = size_t{ 2 };
+
+// How long the encoder sleeps when the host ring has no new frames.
+auto constexpr encoder_idle_time = std::chrono::microseconds( 500 );
+
+// The receiving ring holds one frame being uploaded, one ready, and one being written.
+auto constexpr receive_ring_slot_count = 3U;
+
+// Frames bigger than this are rejected before anything is sized from their headers.
+auto constexpr max_stream_extent = 16'384U;
+
+auto get_slot_pixels( std::byte* const pixels, uint64 const slot_size, uint32 const slot )
+    -> std::byte*
+{
+    return pixels + ( slot_size * slot );
+}
+
+auto report_stats( StreamStats& stats ) -> void
+{
+    auto const now = std::chrono::steady_clock::now( );
+    if ( ( now - stats.report_time ) < stats_report_interval )
+    {
+        return;
+    }
+
+    using FloatSeconds = std::chrono::duration< float64 >;
+
+    auto constexpr bytes_per_mib = 1024.0 * 1024.0;
+    auto const elapsed_s = std::chrono::duration_cast< FloatSeconds >( now - stats.report_time );
+    auto const encoded_mib = static_cast< float64 >( stats.encoded_bytes ) / bytes_per_mib;
+    auto const raw_mib     = static_cast< float64 >( stats.raw_bytes ) / bytes_per_mib;
+
+    spdlog::info(
+        "Streamed {} frames at {:.1f} fps, {:.1f} MiB/s ({:.1f} MiB/s raw)",
+        stats.frame_count,
+        static_cast< float64 >( stats.frame_count ) / elapsed_s.count( ),
+        encoded_mib / elapsed_s.count( ),
+        raw_mib / elapsed_s.count( )
+    );
+    stats = StreamStats{ .report_time = now };
+}
+
+// Takes every frame published to the host ring, encodes it, and releases its slot.
+auto encode_frames(
+    std::stop_token const&                stop_token,
+    StreamData< ExternalMemory::Export >& stream
+) -> void
+{
+    auto previous_frame = std::vector< std::byte >( stream.slot_size );
+    auto record         = FrameRecord{ };
+
+    while ( !stop_token.stop_requested( ) )
+    {
+        if ( !net::try_pop( stream.control->frames, record ) )
+        {
+            std::this_thread::sleep_for( encoder_idle_time );
+            continue;
+        }
+
+        auto frame = EncodedFrame{ .header = stream.frame_header, .bytes = { } };
+        {
+            auto lock = std::unique_lock{ stream.mutex };
+            if ( !stream.free_buffers.empty( ) )
+            {
+                frame.bytes = std::move( stream.free_buffers.back( ) );
+                stream.free_buffers.pop_back( );
+            }
+        }
+
+        auto const pixels = std::span{
+            stream.pixels + ( stream.slot_size * record.slot ),
+            stream.slot_size,
+        };
+        if ( !net::encode_frame_delta( pixels, previous_frame, frame.bytes ) )
+        {
+            stream.failed = true;
+            return;
+        }
+
+        // The pixels were copied out, so the host ring can reuse the slot.
+        stream.control->released_frame_count.store(
+            record.frame_id + 1U,
+            std::memory_order_release
+        );
+
+        frame.header.encoded_size = frame.bytes.size( );
+        frame.header.record       = record;
+
+        auto lock = std::unique_lock{ stream.mutex };
+        if ( !stream.queue_changed.wait(
+                 lock,
+                 stop_token,
+                 [ &stream ] { return stream.encoded_frames.size( ) < max_encoded_frames; }
+             ) )
+        {
+            return;
+        }
+        stream.encoded_frames.push_back( std::move( frame ) );
+        stream.queue_changed.notify_all( );
+    }
+}
+
+// Sends every encoded frame, in order, until the stream stops or the connection breaks.
+auto send_frames(
+    std::stop_token const&                stop_token,
+    StreamData< ExternalMemory::Export >& stream
+) -> void
+{
+    stream.stats.report_time = std::chrono::steady_clock::now( );
+
+    while ( !stop_token.stop_requested( ) )
+    {
+        auto frame = EncodedFrame{ };
+        {
+            auto lock = std::unique_lock{ stream.mutex };
+            if ( !stream.queue_changed.wait(
+                     lock,
+                     stop_token,
+                     [ &stream ] { return !stream.encoded_frames.empty( ); }
+                 ) )
+            {
+                return;
+            }
+            frame = std::move( stream.encoded_frames.front( ) );
+            stream.encoded_frames.pop_front( );
+            stream.queue_changed.notify_all( );
+        }
+
+        if ( !stream.socket.send( std::as_bytes( std::span{ &frame.header, 1U } ) )
+             || !stream.socket.send( frame.bytes ) )
+        {
+            stream.failed = true;
+            return;
+        }
+
+        stream.stats.frame_count += 1U;
+        stream.stats.raw_bytes += stream.slot_size;
+        stream.stats.encoded_bytes += sizeof( frame.header ) + frame.bytes.size( );
+        report_stats( stream.stats );
+
+        auto lock = std::unique_lock{ stream.mutex };
+        stream.free_buffers.push_back( std::move( frame.bytes ) );
+    }
+}
+
+// The state of one connection on the consumer side.
+struct ReceivedRing
+{
+    std::unique_ptr< net::SharedMemory > memory         = { };
+    HostRingControl*                     control        = nullptr;
+    HostRingMessage                      message        = { };
+    std::vector< std::byte >             decoded_frame  = { };
+    std::vector< std::byte >             encoded_frame  = { };
+    uint64                               next_frame_id  = 0U;
+    uint64                               dropped_frames = 0U;
+
+    // The combined damage of the frames dropped since the last one was pushed.
+    std::optional< FrameRecord > dropped_record = { };
+};
+
+auto is_valid( StreamFrameHeader const& header ) -> bool
+{
+    auto constexpr bytes_per_texel = uint64{ 4U };
+    switch ( static_cast< VkFormat >( header.format ) )
+    {
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            break;
+        default:
+            return false;
+    }
+    return ( stream_frame_magic == header.magic ) && ( stream_frame_version == header.version )
+        && ( 0U != header.width ) && ( 0U != header.height )
+        && ( header.width <= max_stream_extent ) && ( header.height <= max_stream_extent )
+        && ( ( header.width * bytes_per_texel ) == header.row_pitch );
+}
+
+// The size of one frame, as long as a ring of them doesn't overflow.
+auto get_slot_size( StreamFrameHeader const& header ) -> std::optional< uint64 >
+{
+    auto constexpr max_slot_size
+        = ( std::numeric_limits< uint64 >::max( ) - host_ring_pixels_offset )
+        / receive_ring_slot_count;
+    if ( header.row_pitch > ( max_slot_size / header.height ) )
+    {
+        return std::nullopt;
+    }
+    return header.row_pitch * header.height;
+}
+
+// Creates the host ring a connection's frames are written into, laid out like a producer's.
+auto initialize_ring( ReceivedRing& ring, StreamFrameHeader const& header ) -> bool
+{
+    auto const maybe_slot_size = get_slot_size( header );
+    if ( !maybe_slot_size )
+    {
+        spdlog::error( "Stream frame too large: {}x{}", header.width, header.height );
+        return false;
+    }
+    auto const slot_size = maybe_slot_size.value( );
+    if ( 0U != ( slot_size % net::frame_delta_word_size ) )
+    {
+        spdlog::error(
+            "Stream frame size isn't a multiple of {} bytes",
+            net::frame_delta_word_size
+        );
+        return false;
+    }
+
+    ring.memory = std::make_unique< net::SharedMemory >( );
+    CHECK_TRUE( ring.memory->create_hugepage_backed(
+        "ltb_stream_ring",
+        host_ring_pixels_offset + ( slot_size * receive_ring_slot_count )
+    ) );
+    ring.control             = new ( ring.memory->data( ) ) HostRingControl{ };
+    ring.control->slot_count = receive_ring_slot_count;
+
+    ring.message = HostRingMessage{
+        .magic      = host_ring_message_magic,
+        .version    = host_ring_message_version,
+        .slot_count = receive_ring_slot_count,
+        .format     = header.format,
+        .width      = header.width,
+        .height     = header.height,
+        .row_pitch  = header.row_pitch,
+        .slot_size  = slot_size,
+        .generation = static_cast< uint64 >(
+            std::chrono::steady_clock::now( ).time_since_epoch( ).count( )
+        ),
+    };
+
+    // Both sides of a connection start from an all-zero frame.
+    ring.decoded_frame.assign( slot_size, std::byte{ 0 } );
+    return true;
+}
+
+// Hands a connection's ring to the consumer, replacing any ring it hasn't taken yet.
+auto offer_ring(
+    StreamData< ExternalMemory::Import >& stream,
+    ReceivedRing const&                   ring,
+    LayerMessage const&                   layer
+) -> bool
+{
+    auto const memory_fd = ::fcntl( ring.memory->fd( ), F_DUPFD_CLOEXEC, 0 );
+    if ( memory_fd < 0 )
+    {
+        spdlog::error( "fcntl() failed: {}", std::strerror( errno ) );
+        return false;
+    }
+
+    auto lock = std::unique_lock{ stream.mutex };
+    if ( -1 != stream.ring_fd )
+    {
+        utils::ignore( ::close( stream.ring_fd ) );
+    }
+    stream.layer        = layer;
+    stream.ring_message = ring.message;
+    stream.ring_fd      = memory_fd;
+    return true;
+}
+
+// Decodes one frame and writes it into the ring, unless the consumer hasn't released the slot.
+auto receive_frame(
+    StreamData< ExternalMemory::Import >& stream,
+    ReceivedRing&                         ring,
+    bool&                                 closed
+) -> bool
+{
+    auto header = StreamFrameHeader{ };
+    CHECK_TRUE(
+        stream.socket.receive( std::as_writable_bytes( std::span{ &header, 1U } ), closed )
+    );
+
+    if ( !is_valid( header ) )
+    {
+        spdlog::error( "Invalid stream frame header" );
+        return false;
+    }
+
+    if ( !ring.memory )
+    {
+        CHECK_TRUE( initialize_ring( ring, header ) );
+    }
+    else if ( ( header.width != ring.message.width ) || ( header.height != ring.message.height )
+              || ( header.format != ring.message.format ) )
+    {
+        spdlog::error( "Stream frame size changed mid-connection" );
+        return false;
+    }
+
+    // Deltas are never much bigger than the frame itself.
+    if ( header.encoded_size > ( 2U * ring.message.slot_size ) )
+    {
+        spdlog::error( "Stream frame too large: {} bytes", header.encoded_size );
+        return false;
+    }
+    // Hanging up once the header is sent truncates the frame, so it's never a clean close.
+    ring.encoded_frame.resize( header.encoded_size );
+    auto body_closed = false;
+    if ( !stream.socket.receive( ring.encoded_frame, body_closed ) )
+    {
+        if ( body_closed )
+        {
+            spdlog::error( "Streaming producer hung up in the middle of a frame" );
+        }
+        return false;
+    }
+
+    // Every frame is decoded, even dropped ones, since the next delta builds on it.
+    CHECK_TRUE( net::decode_frame_delta( ring.encoded_frame, ring.decoded_frame ) );
+
+    // Dropped frames are never displayed, so their damage carries over to the next frame.
+    auto record = header.record;
+    if ( ring.dropped_record )
+    {
+        merge_damage( record, ring.dropped_record.value( ) );
+    }
+
+    auto const slot_count = uint64{ ring.control->slot_count };
+    auto const frame_id   = ring.next_frame_id;
+    auto const released   = ring.control->released_frame_count.load( std::memory_order_acquire );
+    if ( ( released + slot_count ) <= frame_id )
+    {
+        ring.dropped_record = record;
+        ++ring.dropped_frames;
+        return true;
+    }
+
+    auto const slot = static_cast< uint32 >( frame_id % slot_count );
+    utils::ignore( std::memcpy(
+        get_slot_pixels(
+            static_cast< std::byte* >( ring.memory->data( ) ) + host_ring_pixels_offset,
+            ring.message.slot_size,
+            slot
+        ),
+        ring.decoded_frame.data( ),
+        ring.decoded_frame.size( )
+    ) );
+
+    // The producer's timing survives, but ids and slots are this ring's own.
+    record.frame_id = frame_id;
+    record.slot     = slot;
+    if ( !net::try_push( ring.control->frames, record ) )
+    {
+        ring.dropped_record = record;
+        ++ring.dropped_frames;
+        return true;
+    }
+    ring.dropped_record = std::nullopt;
+    ++ring.next_frame_id;
+    return true;
+}
+
+// Accepts one producer at a time and receives its frames until it hangs up.
+auto receive_frames(
+    std::stop_token const&                stop_token,
+    StreamData< ExternalMemory::Import >& stream
+) -> void
+{
+    while ( !stop_token.stop_requested( ) && stream.listener.accept( stream.socket ) )
+    {
+        // A connection accepted while stopping missed the shutdown meant to unblock it.
+        if ( stop_token.stop_requested( ) )
+        {
+            stream.socket.reset( );
+            break;
+        }
+        spdlog::info( "Streaming producer connected" );
+
+        auto layer  = LayerMessage{ };
+        auto closed = false;
+        auto ring   = ReceivedRing{ };
+
+        auto connected
+            = stream.socket.receive( std::as_writable_bytes( std::span{ &layer, 1U } ), closed )
+           && ( layer_message_magic == layer.magic ) && ( layer_message_version == layer.version );
+
+        while ( connected && !stop_token.stop_requested( ) )
+        {
+            auto const had_ring = ( nullptr != ring.memory );
+            connected           = receive_frame( stream, ring, closed );
+            if ( connected && !had_ring )
+            {
+                connected = offer_ring( stream, ring, layer );
+            }
+        }
+
+        if ( !closed && !stop_token.stop_requested( ) )
+        {
+            spdlog::error( "Streaming producer failed" );
+        }
+        spdlog::info(
+            "Streaming producer disconnected after {} frames, {} dropped",
+            ring.next_frame_id,
+            ring.dropped_frames
+        );
+        stream.socket.reset( );
+    }
+}
+
+} // namespace
+
+auto initialize(
+    StreamData< ExternalMemory::Export >&         stream,
+    HostRingData< ExternalMemory::Export > const& ring,
+    LayerMessage const&                           layer,
+    std::string_view const                        address,
+    uint16 const                                  port
+) -> bool
+{
+    auto const& image = ring.images.front( );
+
+    // Frames are delta-encoded a word at a time.
+    if ( 0U != ( ring.slot_size % net::frame_delta_word_size ) )
+    {
+        spdlog::error(
+            "Can't stream {}x{} frames: their size isn't a multiple of {} bytes",
+            image.image_size.width,
+            image.image_size.height,
+            net::frame_delta_word_size
+        );
+        return false;
+    }
+
+    stream.control      = ring.control;
+    stream.pixels       = static_cast< std::byte const* >( ring.memory.data( ) );
+    stream.pixels       += host_ring_pixels_offset;
+    stream.slot_size    = ring.slot_size;
+    stream.frame_header = StreamFrameHeader{
+        .magic        = stream_frame_magic,
+        .version      = stream_frame_version,
+        .format       = static_cast< uint32 >( image.color_format ),
+        .width        = image.image_size.width,
+        .height       = image.image_size.height,
+        .reserved     = 0U,
+        .row_pitch    = ring.row_pitch,
+        .encoded_size = 0U,
+        .record       = { },
+    };
+
+    CHECK_TRUE( stream.socket.connect( address, port ) );
+    CHECK_TRUE( stream.socket.send( std::as_bytes( std::span{ &layer, 1U } ) ) );
+    spdlog::info( "Streaming to {}:{}", address, port );
+
+    stream.encoder = std::jthread( [ &stream ]( std::stop_token const& stop_token )
+                                   { encode_frames( stop_token, stream ); } );
+    stream.sender  = std::jthread( [ &stream ]( std::stop_token const& stop_token )
+                                  { send_frames( stop_token, stream ); } );
+    return true;
+}
+
+auto initialize(
+    StreamData< ExternalMemory::Import >& stream,
+    std::string_view const                address,
+    uint16 const                          port
+) -> bool
+{
+    CHECK_TRUE( stream.listener.listen( address, port ) );
+    spdlog::info( "Listening for streamed frames on {}:{}", address, port );
+
+    stream.receiver = std::jthread( [ &stream ]( std::stop_token const& stop_token )
+                                    { receive_frames( stop_token, stream ); } );
+    return true;
+}
+
+auto has_failed( StreamData< ExternalMemory::Export > const& stream ) -> bool
+{
+    return stream.failed;
+}
+
+auto take_ring(
+    StreamData< ExternalMemory::Import >& stream,
+    LayerMessage&                         layer,
+    HostRingMessage&                      message,
+    int32&                                memory_fd
+) -> bool
+{
+    auto lock = std::unique_lock{ stream.mutex };
+    if ( -1 == stream.ring_fd )
+    {
+        return false;
+    }
+
+    layer     = stream.layer.value( );
+    message   = stream.ring_message.value( );
+    memory_fd = stream.ring_fd;
+
+    stream.layer        = std::nullopt;
+    stream.ring_message = std::nullopt;
+    stream.ring_fd      = -1;
+    return true;
+}
+
+template <>
+auto destroy( StreamData< ExternalMemory::Export >& stream ) -> void
+{
+    // Blocked sends return once the socket is shut down.
+    stream.encoder.request_stop( );
+    stream.sender.request_stop( );
+    stream.socket.shutdown( );
+    if ( stream.encoder.joinable( ) )
+    {
+        stream.encoder.join( );
+    }
+    if ( stream.sender.joinable( ) )
+    {
+        stream.sender.join( );
+    }
+    stream.socket.reset( );
+    stream.encoded_frames.clear( );
+    stream.free_buffers.clear( );
+}
+
+template <>
+auto destroy( StreamData< ExternalMemory::Import >& stream ) -> void
+{
+    // Blocked accepts and receives return once their sockets are shut down.
+    stream.receiver.request_stop( );
+    stream.listener.shutdown( );
+    stream.socket.shutdown( );
+    if ( stream.receiver.joinable( ) )
+    {
+        stream.receiver.join( );
+    }
+    stream.socket.reset( );
+
+    if ( -1 != stream.ring_fd )
+    {
+        utils::ignore( ::close( stream.ring_fd ) );
+        stream.ring_fd = -1;
+    }
+}
+
+} // namespace ltb::vlk
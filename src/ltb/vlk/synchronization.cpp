@@ -8,25 +8,74 @@
 
 namespace ltb::vlk
 {
+namespace
+{
+
+auto constexpr external_semaphore_handle_type = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+
+} // namespace
 
 auto initialize(
     SyncData< AppType::Windowed >& sync,
     VkDevice const&                device,
-    VkCommandPool const&           command_pool,
-    uint32 const                   max_frames_in_flight
+    uint32 const                   graphics_queue_family_index,
+    uint32 const                   max_frames_in_flight,
+    uint32 const                   recording_thread_count
 ) -> bool
 {
-    auto const cmd_buf_alloc_info = VkCommandBufferAllocateInfo{
-        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .pNext              = nullptr,
-        .commandPool        = command_pool,
-        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = max_frames_in_flight,
+    CHECK_TRUE( initialize( sync.recording_threads, recording_thread_count ) );
+    auto const thread_count = sync.recording_threads.thread_count;
+
+    // Buffers are never reset one at a time, and are recorded again every frame.
+    auto const command_pool_create_info = VkCommandPoolCreateInfo{
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext            = nullptr,
+        .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = graphics_queue_family_index,
     };
-    sync.command_buffers.resize( cmd_buf_alloc_info.commandBufferCount );
-    CHECK_VK(
-        ::vkAllocateCommandBuffers( device, &cmd_buf_alloc_info, sync.command_buffers.data( ) )
-    );
+    sync.command_pools.resize( max_frames_in_flight * thread_count );
+    for ( auto& command_pool : sync.command_pools )
+    {
+        CHECK_VK(
+            ::vkCreateCommandPool( device, &command_pool_create_info, nullptr, &command_pool )
+        );
+    }
+    spdlog::debug( "vkCreateCommandPool()x{}", sync.command_pools.size( ) );
+
+    sync.command_buffers.resize( max_frames_in_flight );
+    sync.secondary_command_buffers.resize( sync.command_pools.size( ) );
+
+    for ( auto frame = 0U; frame < max_frames_in_flight; ++frame )
+    {
+        auto const primary_alloc_info = VkCommandBufferAllocateInfo{
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext              = nullptr,
+            .commandPool        = sync.command_pools[ frame * thread_count ],
+            .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1U,
+        };
+        CHECK_VK( ::vkAllocateCommandBuffers(
+            device,
+            &primary_alloc_info,
+            sync.command_buffers.data( ) + frame
+        ) );
+    }
+
+    for ( auto i = 0U; i < sync.command_pools.size( ); ++i )
+    {
+        auto const secondary_alloc_info = VkCommandBufferAllocateInfo{
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext              = nullptr,
+            .commandPool        = sync.command_pools[ i ],
+            .level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1U,
+        };
+        CHECK_VK( ::vkAllocateCommandBuffers(
+            device,
+            &secondary_alloc_info,
+            sync.secondary_command_buffers.data( ) + i
+        ) );
+    }
     spdlog::debug( "vkAllocateCommandBuffers()" );
 
     sync.image_available_semaphores.resize( max_frames_in_flight );
@@ -106,10 +155,131 @@ auto initialize(
 auto initialize(
     SyncData< AppType::Windowed >&        sync,
     SetupData< AppType::Windowed > const& setup,
-    uint32 const                          max_frames_in_flight
+    uint32 const                          max_frames_in_flight,
+    uint32 const                          recording_thread_count
 ) -> bool
 {
-    return initialize( sync, setup.device, setup.graphics_command_pool, max_frames_in_flight );
+    return initialize(
+        sync,
+        setup.device,
+        setup.graphics_queue_family_index,
+        max_frames_in_flight,
+        recording_thread_count
+    );
+}
+
+auto initialize_timeline(
+    VkSemaphore&         timeline,
+    VkDevice const&      device,
+    ExternalMemory const semaphore_type
+) -> bool
+{
+    if ( ExternalMemory::Import == semaphore_type )
+    {
+        spdlog::error( "Use import_timeline() to import a timeline semaphore" );
+        return false;
+    }
+
+    auto const export_semaphore_info = VkExportSemaphoreCreateInfo{
+        .sType       = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO,
+        .pNext       = nullptr,
+        .handleTypes = external_semaphore_handle_type,
+    };
+    auto const semaphore_type_info = VkSemaphoreTypeCreateInfo{
+        .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext         = ( ExternalMemory::Export == semaphore_type ) ? &export_semaphore_info
+                                                                      : nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue  = 0U,
+    };
+    auto const semaphore_create_info = VkSemaphoreCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &semaphore_type_info,
+        .flags = 0U,
+    };
+    CHECK_VK( ::vkCreateSemaphore( device, &semaphore_create_info, nullptr, &timeline ) );
+    spdlog::debug( "vkCreateSemaphore()" );
+
+    return true;
+}
+
+auto import_timeline(
+    VkSemaphore&      timeline,
+    VkInstance const& instance,
+    VkDevice const&   device,
+    int32 const       import_timeline_fd
+) -> bool
+{
+    auto* const vkImportSemaphoreFdKHR = reinterpret_cast< PFN_vkImportSemaphoreFdKHR >(
+        ::vkGetInstanceProcAddr( instance, "vkImportSemaphoreFdKHR" )
+    );
+    if ( nullptr == vkImportSemaphoreFdKHR )
+    {
+        spdlog::error( "vkGetInstanceProcAddr() failed" );
+        return false;
+    }
+
+    // The imported payload replaces the initial value, but the type must match the exporter.
+    CHECK_TRUE( initialize_timeline( timeline, device, ExternalMemory::None ) );
+
+    // Vulkan takes ownership of the file descriptor on success.
+    auto const import_semaphore_info = VkImportSemaphoreFdInfoKHR{
+        .sType      = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR,
+        .pNext      = nullptr,
+        .semaphore  = timeline,
+        .flags      = 0U,
+        .handleType = external_semaphore_handle_type,
+        .fd         = import_timeline_fd,
+    };
+    CHECK_VK( vkImportSemaphoreFdKHR( device, &import_semaphore_info ) );
+    spdlog::debug( "vkImportSemaphoreFdKHR()" );
+
+    return true;
+}
+
+auto get_file_descriptor(
+    int32&             file_descriptor,
+    VkInstance const&  instance,
+    VkDevice const&    device,
+    VkSemaphore const& semaphore
+) -> bool
+{
+    auto* const vkGetSemaphoreFdKHR = reinterpret_cast< PFN_vkGetSemaphoreFdKHR >(
+        ::vkGetInstanceProcAddr( instance, "vkGetSemaphoreFdKHR" )
+    );
+    if ( nullptr == vkGetSemaphoreFdKHR )
+    {
+        spdlog::error( "vkGetInstanceProcAddr() failed" );
+        return false;
+    }
+
+    auto const semaphore_info = VkSemaphoreGetFdInfoKHR{
+        .sType      = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR,
+        .pNext      = nullptr,
+        .semaphore  = semaphore,
+        .handleType = external_semaphore_handle_type,
+    };
+    CHECK_VK( vkGetSemaphoreFdKHR( device, &semaphore_info, &file_descriptor ) );
+    spdlog::debug( "vkGetSemaphoreFdKHR()" );
+
+    return true;
+}
+
+auto get_timeline_value( uint64& value, VkDevice const& device, VkSemaphore const& timeline )
+    -> bool
+{
+    CHECK_VK( ::vkGetSemaphoreCounterValue( device, timeline, &value ) );
+    return true;
+}
+
+auto destroy_timeline( VkSemaphore& timeline, VkDevice const& device ) -> void
+{
+    if ( nullptr != timeline )
+    {
+        ::vkDestroySemaphore( device, timeline, nullptr );
+        spdlog::debug( "vkDestroySemaphore()" );
+        timeline = nullptr;
+    }
 }
 
 template < AppType app_type >
@@ -156,16 +326,17 @@ auto destroy(
         spdlog::debug( "vkDestroySemaphore()x{}", sync.image_available_semaphores.size( ) );
         sync.image_available_semaphores.clear( );
 
-        if ( !sync.command_buffers.empty( ) )
+        // Destroying the pools frees every command buffer allocated from them.
+        for ( auto* const command_pool : sync.command_pools )
         {
-            ::vkFreeCommandBuffers(
-                device,
-                graphics_command_pool,
-                static_cast< uint32 >( sync.command_buffers.size( ) ),
-                sync.command_buffers.data( )
-            );
-            spdlog::debug( "vkFreeCommandBuffers()" );
+            ::vkDestroyCommandPool( device, command_pool, nullptr );
         }
+        spdlog::debug( "vkDestroyCommandPool()x{}", sync.command_pools.size( ) );
+        sync.command_pools.clear( );
+        sync.command_buffers.clear( );
+        sync.secondary_command_buffers.clear( );
+
+        destroy( sync.recording_threads );
     }
 }
 
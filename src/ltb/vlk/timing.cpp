@@ -0,0 +1,269 @@
+// /////////////////////////////////////////////////////////////
+// A Logan Thomas Barnes project
+// /////////////////////////////////////////////////////////////
+#include "ltb/vlk/timing.hpp"
+
+// project
+#include "ltb/vlk/check.hpp"
+
+// standard
+#include <algorithm>
+#include <array>
+
+namespace ltb::vlk
+{
+namespace
+{
+
+auto constexpr latency_report_interval = std::chrono::seconds( 5 );
+
+// The two clocks drift apart slowly, so they're compared again every so often.
+auto constexpr calibration_interval = std::chrono::seconds( 1 );
+
+auto supports_monotonic_time_domain(
+    VkInstance const&       instance,
+    VkPhysicalDevice const& physical_device,
+    bool&                   supported
+) -> bool
+{
+    auto* const vkGetPhysicalDeviceCalibrateableTimeDomainsEXT
+        = reinterpret_cast< PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT >(
+            ::vkGetInstanceProcAddr( instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT" )
+        );
+    if ( nullptr == vkGetPhysicalDeviceCalibrateableTimeDomainsEXT )
+    {
+        spdlog::error( "vkGetInstanceProcAddr() failed" );
+        return false;
+    }
+
+    auto time_domain_count = uint32{ 0 };
+    CHECK_VK( vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+        physical_device,
+        &time_domain_count,
+        nullptr
+    ) );
+    auto time_domains = std::vector< VkTimeDomainEXT >( time_domain_count );
+    CHECK_VK( vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+        physical_device,
+        &time_domain_count,
+        time_domains.data( )
+    ) );
+
+    auto const has_domain = [ &time_domains ]( VkTimeDomainEXT const domain )
+    { return std::ranges::find( time_domains, domain ) != time_domains.end( ); };
+
+    // The steady clock is CLOCK_MONOTONIC on Linux.
+    supported = has_domain( VK_TIME_DOMAIN_DEVICE_EXT )
+             && has_domain( VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT );
+    return true;
+}
+
+auto calibrate( TimestampData& timestamps, VkDevice const& device ) -> bool
+{
+    auto const infos = std::array{
+        VkCalibratedTimestampInfoEXT{
+            .sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+            .pNext      = nullptr,
+            .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT,
+        },
+        VkCalibratedTimestampInfoEXT{
+            .sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+            .pNext      = nullptr,
+            .timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT,
+        },
+    };
+    auto values        = std::array< uint64, infos.size( ) >{ };
+    auto max_deviation = uint64{ 0 };
+    CHECK_VK( timestamps.vkGetCalibratedTimestampsEXT(
+        device,
+        static_cast< uint32 >( infos.size( ) ),
+        infos.data( ),
+        values.data( ),
+        &max_deviation
+    ) );
+
+    timestamps.calibration_ticks = values[ 0 ] & timestamps.valid_mask;
+    timestamps.calibration_ns    = static_cast< int64 >( values[ 1 ] );
+    timestamps.calibration_time  = std::chrono::steady_clock::now( );
+    return true;
+}
+
+// Ticks only have `timestampValidBits` bits, so the difference wraps around within them.
+auto to_steady_ns( TimestampData const& timestamps, uint64 const ticks ) -> int64
+{
+    auto const mask         = timestamps.valid_mask;
+    auto const ticks_after  = ( ( ticks & mask ) - timestamps.calibration_ticks ) & mask;
+    auto const ticks_before = ( timestamps.calibration_ticks - ( ticks & mask ) ) & mask;
+
+    auto const delta_ticks = ( ticks_after > ( mask >> 1U ) )
+                               ? -static_cast< float64 >( ticks_before )
+                               : static_cast< float64 >( ticks_after );
+    return timestamps.calibration_ns
+         + static_cast< int64 >( delta_ticks * timestamps.ns_per_tick );
+}
+
+auto get_percentile_ms( std::vector< int64 > const& sorted_ns, float64 const percentile )
+    -> float64
+{
+    auto const index = static_cast< size_t >(
+        percentile * static_cast< float64 >( sorted_ns.size( ) - 1U )
+    );
+    auto const latency = std::chrono::nanoseconds( sorted_ns[ index ] );
+    return std::chrono::duration< float64, std::milli >( latency ).count( );
+}
+
+} // namespace
+
+auto initialize(
+    TimestampData&          timestamps,
+    VkInstance const&       instance,
+    VkPhysicalDevice const& physical_device,
+    VkDevice const&         device,
+    uint32 const            queue_family_index,
+    bool const              supports_calibrated_timestamps,
+    uint32 const            query_count
+) -> bool
+{
+    auto queue_family_count = uint32{ 0 };
+    ::vkGetPhysicalDeviceQueueFamilyProperties( physical_device, &queue_family_count, nullptr );
+    auto queue_families = std::vector< VkQueueFamilyProperties >( queue_family_count );
+    ::vkGetPhysicalDeviceQueueFamilyProperties(
+        physical_device,
+        &queue_family_count,
+        queue_families.data( )
+    );
+    auto const valid_bits = queue_families.at( queue_family_index ).timestampValidBits;
+
+    auto supports_monotonic = false;
+    if ( supports_calibrated_timestamps )
+    {
+        CHECK_TRUE(
+            supports_monotonic_time_domain( instance, physical_device, supports_monotonic )
+        );
+    }
+
+    if ( ( 0U == valid_bits ) || !supports_monotonic )
+    {
+        spdlog::info( "Calibrated GPU timestamps not supported, latency tracing is off" );
+        return true;
+    }
+
+    timestamps.vkGetCalibratedTimestampsEXT = reinterpret_cast< PFN_vkGetCalibratedTimestampsEXT >(
+        ::vkGetDeviceProcAddr( device, "vkGetCalibratedTimestampsEXT" )
+    );
+    if ( nullptr == timestamps.vkGetCalibratedTimestampsEXT )
+    {
+        spdlog::error( "vkGetDeviceProcAddr() failed" );
+        return false;
+    }
+
+    auto physical_device_properties = VkPhysicalDeviceProperties{ };
+    ::vkGetPhysicalDeviceProperties( physical_device, &physical_device_properties );
+
+    timestamps.ns_per_tick = physical_device_properties.limits.timestampPeriod;
+    timestamps.valid_mask
+        = ( valid_bits >= 64U ) ? ~uint64{ 0 } : ( ( uint64{ 1 } << valid_bits ) - 1U );
+    CHECK_TRUE( calibrate( timestamps, device ) );
+
+    auto const query_pool_create_info = VkQueryPoolCreateInfo{
+        .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0U,
+        .queryType          = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount         = query_count,
+        .pipelineStatistics = 0U,
+    };
+    CHECK_VK(
+        ::vkCreateQueryPool( device, &query_pool_create_info, nullptr, &timestamps.query_pool )
+    );
+    spdlog::debug( "vkCreateQueryPool()" );
+    timestamps.query_count = query_count;
+
+    return true;
+}
+
+auto get_timestamps_ns(
+    std::span< int64 > const timestamps_ns,
+    TimestampData&           timestamps,
+    VkDevice const&          device,
+    uint32 const             first_query,
+    bool&                    available
+) -> bool
+{
+    available = false;
+    if ( nullptr == timestamps.query_pool )
+    {
+        return true;
+    }
+
+    auto ticks = std::vector< uint64 >( timestamps_ns.size( ) );
+
+    auto const query_result = ::vkGetQueryPoolResults(
+        device,
+        timestamps.query_pool,
+        first_query,
+        static_cast< uint32 >( ticks.size( ) ),
+        ticks.size( ) * sizeof( uint64 ),
+        ticks.data( ),
+        sizeof( uint64 ),
+        VK_QUERY_RESULT_64_BIT
+    );
+    if ( VK_NOT_READY == query_result )
+    {
+        return true;
+    }
+    CHECK_VK( query_result );
+
+    if ( ( std::chrono::steady_clock::now( ) - timestamps.calibration_time )
+         >= calibration_interval )
+    {
+        CHECK_TRUE( calibrate( timestamps, device ) );
+    }
+
+    std::ranges::transform(
+        ticks,
+        timestamps_ns.begin( ),
+        [ &timestamps ]( uint64 const tick ) { return to_steady_ns( timestamps, tick ); }
+    );
+    available = true;
+    return true;
+}
+
+auto record_latency( LatencyHistogram& histogram, int64 const latency_ns ) -> void
+{
+    auto const now = std::chrono::steady_clock::now( );
+    if ( std::chrono::steady_clock::time_point{ } == histogram.report_time )
+    {
+        histogram.report_time = now;
+    }
+    histogram.samples_ns.push_back( latency_ns );
+
+    if ( ( now - histogram.report_time ) < latency_report_interval )
+    {
+        return;
+    }
+
+    std::ranges::sort( histogram.samples_ns );
+    spdlog::info(
+        "{}: p50 {:.2f} ms, p95 {:.2f} ms, p99 {:.2f} ms over {} frames",
+        histogram.name,
+        get_percentile_ms( histogram.samples_ns, 0.50 ),
+        get_percentile_ms( histogram.samples_ns, 0.95 ),
+        get_percentile_ms( histogram.samples_ns, 0.99 ),
+        histogram.samples_ns.size( )
+    );
+    histogram.samples_ns.clear( );
+    histogram.report_time = now;
+}
+
+auto destroy( TimestampData& timestamps, VkDevice const& device ) -> void
+{
+    if ( nullptr != timestamps.query_pool )
+    {
+        ::vkDestroyQueryPool( device, timestamps.query_pool, nullptr );
+        spdlog::debug( "vkDestroyQueryPool()" );
+    }
+    timestamps = TimestampData{ };
+}
+
+} // namespace ltb::vlk